@@ -7,6 +7,8 @@ countries.
 
 #include "AppController.h"
 
+#include "FrameProfiler.h"
+#include "MathCore.h"
 #include "MathUtils.h"
 #include "Log.h"
 
@@ -312,7 +314,12 @@ bool AppController::configureRendering(int width, int height, int orientation)
 bool AppController::prepareToRender(double* viewport, Vuforia::RenderData* renderData,
                                     Vuforia::TextureUnit* videoBackgroundTextureUnit, Vuforia::TextureData* videoBackgroundTexture)
 {
-    mVuforiaState = Vuforia::TrackerManager::getInstance().getStateUpdater().updateState();
+    {
+        PROFILE_SCOPE(STAGE_UPDATE_STATE);
+        mVuforiaState = Vuforia::TrackerManager::getInstance().getStateUpdater().updateState();
+    }
+
+    PROFILE_SCOPE(STAGE_RENDERER_BEGIN);
     auto& renderer = Vuforia::Renderer::getInstance();
     renderer.begin(mVuforiaState, renderData);
 
@@ -343,6 +350,7 @@ bool AppController::prepareToRender(double* viewport, Vuforia::RenderData* rende
 
 void AppController::finishRender(Vuforia::RenderData* renderData)
 {
+    PROFILE_SCOPE(STAGE_FINISH_RENDER);
     Vuforia::Renderer::getInstance().end(renderData);
 }
 
@@ -356,8 +364,7 @@ bool AppController::getOrigin(Vuforia::Matrix44F& projectionMatrix,
         if (origin->getStatus() == Vuforia::TrackableResult::STATUS::TRACKED &&
             origin->getStatusInfo() == Vuforia::TrackableResult::STATUS_INFO::NORMAL)
         {
-            Vuforia::Matrix44F viewMatrix = Vuforia::Tool::convertPose2GLMatrix(origin->getPose());
-            modelViewMatrix = MathUtils::Matrix44FTranspose(MathUtils::Matrix44FInverse(viewMatrix));
+            modelViewMatrix = MathUtils::Matrix44FViewFromPose(origin->getPose());
 
             projectionMatrix = Vuforia::Tool::convertPerspectiveProjection2GLMatrix(
                 mCurrentRenderingPrimitives->getProjectionMatrix(Vuforia::VIEW_SINGULAR,
@@ -382,29 +389,12 @@ bool AppController::getImageTargetResult(Vuforia::Matrix44F& projectionMatrix,
 
         if (result->isOfType(Vuforia::ImageTargetResult::getClassType()) && mTarget == IMAGE_TARGET_ID)
         {
-            const Vuforia::ImageTargetResult* itResult = static_cast<const Vuforia::ImageTargetResult*>(result);
-            const Vuforia::ImageTarget& target = itResult->getTrackable();
+            projectionMatrix = getProjectionMatrix();
 
-            Vuforia::Matrix44F viewMatrix = Vuforia::Tool::convertPose2GLMatrix(mVuforiaState.getDeviceTrackableResult()->getPose());
-            viewMatrix = MathUtils::Matrix44FTranspose(MathUtils::Matrix44FInverse(viewMatrix));
-
-            // Get the projection matrix
-            projectionMatrix = Vuforia::Tool::convertPerspectiveProjection2GLMatrix(
-                mCurrentRenderingPrimitives->getProjectionMatrix(Vuforia::VIEW_SINGULAR,
-                                                                 mVuforiaState.getCameraCalibration()),
-                NEAR_PLANE, FAR_PLANE);
-
-            // Get object pose and populate modelViewMatrix
-            modelViewMatrix = Vuforia::Tool::convertPose2GLMatrix(result->getPose());
-            MathUtils::multiplyMatrix(viewMatrix, modelViewMatrix, modelViewMatrix);
-
-            // Calculate a scaled modelViewMatrix for rendering a unit bounding box
-            auto targetSize = target.getSize();
-            // z-dimension will be zero for planar target
-            // set it here to the larger dimension so that
-            // a 3D augmentation can be shown
-            targetSize.data[2] = std::max(targetSize.data[0], targetSize.data[1]);
-            scaledModelViewMatrix = MathUtils::Matrix44FScale(targetSize, modelViewMatrix);
+            TargetResult targetResult;
+            computeImageTargetResult(result, getViewMatrix(), targetResult);
+            modelViewMatrix = targetResult.modelViewMatrix;
+            scaledModelViewMatrix = targetResult.scaledModelViewMatrix;
 
             return true;
         }
@@ -414,6 +404,36 @@ bool AppController::getImageTargetResult(Vuforia::Matrix44F& projectionMatrix,
 }
 
 
+bool AppController::getImageTargetResults(Vuforia::Matrix44F& projectionMatrix, std::vector<TargetResult>& results)
+{
+    results.clear();
+    if (mTarget != IMAGE_TARGET_ID)
+    {
+        return false;
+    }
+
+    // The view and projection matrices are the same for all the targets
+    Vuforia::Matrix44F viewMatrix;
+    const auto& trackableResultList = mVuforiaState.getTrackableResults();
+    for (const auto* result : trackableResultList)
+    {
+        if (result->isOfType(Vuforia::ImageTargetResult::getClassType()))
+        {
+            if (results.empty())
+            {
+                viewMatrix = getViewMatrix();
+                projectionMatrix = getProjectionMatrix();
+            }
+
+            results.emplace_back();
+            computeImageTargetResult(result, viewMatrix, results.back());
+        }
+    }
+
+    return !results.empty();
+}
+
+
 bool AppController::getModelTargetResult(Vuforia::Matrix44F& projectionMatrix,
                                          Vuforia::Matrix44F& modelViewMatrix,
                                          Vuforia::Matrix44F& scaledModelViewMatrix)
@@ -439,8 +459,7 @@ bool AppController::getModelTargetResult(Vuforia::Matrix44F& projectionMatrix,
             {
                 mGuideViewModelTarget = nullptr;
 
-                Vuforia::Matrix44F viewMatrix = Vuforia::Tool::convertPose2GLMatrix(mVuforiaState.getDeviceTrackableResult()->getPose());
-                viewMatrix = MathUtils::Matrix44FTranspose(MathUtils::Matrix44FInverse(viewMatrix));
+                Vuforia::Matrix44F viewMatrix = getViewMatrix();
 
                 // Get the projection matrix
                 projectionMatrix = Vuforia::Tool::convertPerspectiveProjection2GLMatrix(
@@ -679,6 +698,41 @@ void AppController::setVuforiaOrientation(int orientation) const
 }
 
 
+Vuforia::Matrix44F AppController::getViewMatrix() const
+{
+    // The device pose is a rigid transform, its inverse needs no determinant
+    return MathUtils::Matrix44FViewFromPose(mVuforiaState.getDeviceTrackableResult()->getPose());
+}
+
+
+Vuforia::Matrix44F AppController::getProjectionMatrix() const
+{
+    return Vuforia::Tool::convertPerspectiveProjection2GLMatrix(
+        mCurrentRenderingPrimitives->getProjectionMatrix(Vuforia::VIEW_SINGULAR,
+                                                         mVuforiaState.getCameraCalibration()),
+        NEAR_PLANE, FAR_PLANE);
+}
+
+
+void AppController::computeImageTargetResult(const Vuforia::TrackableResult* result,
+                                             const Vuforia::Matrix44F& viewMatrix, TargetResult& targetResult) const
+{
+    const Vuforia::ImageTargetResult* itResult = static_cast<const Vuforia::ImageTargetResult*>(result);
+    const Vuforia::ImageTarget& target = itResult->getTrackable();
+
+    // Get object pose and populate modelViewMatrix
+    targetResult.modelViewMatrix = Math::multiply(viewMatrix, Vuforia::Tool::convertPose2GLMatrix(result->getPose()));
+
+    // Calculate a scaled modelViewMatrix for rendering a unit bounding box
+    auto targetSize = target.getSize();
+    // z-dimension will be zero for planar target
+    // set it here to the larger dimension so that
+    // a 3D augmentation can be shown
+    targetSize.data[2] = std::max(targetSize.data[0], targetSize.data[1]);
+    targetResult.scaledModelViewMatrix = Math::scaled(targetResult.modelViewMatrix, targetSize);
+}
+
+
 bool AppController::initTrackers()
 {
     // Initialize the object tracker
@@ -700,6 +754,12 @@ bool AppController::initTrackers()
         return false;
     }
 
+    // Allow several Image Targets to be tracked at once
+    if (!Vuforia::setHint(Vuforia::HINT_MAX_SIMULTANEOUS_IMAGE_TARGETS, MAX_SIMULTANEOUS_IMAGE_TARGETS))
+    {
+        LOG("Failed to set the maximum number of simultaneous Image Targets");
+    }
+
     return true;
 }
 
@@ -18,6 +18,7 @@ countries.
 #include <Vuforia/ModelTarget.h>
 #include <Vuforia/Renderer.h>
 #include <Vuforia/RenderingPrimitives.h>
+#include <Vuforia/TrackableResult.h>
 #ifdef _MSC_VER
 #pragma warning(default:4251)
 #endif
@@ -26,6 +27,7 @@ countries.
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 
 /// The AppController provides a platform independent encapsulation of the  Vuforia lifecycle
@@ -38,11 +40,21 @@ public:
     // Constants
     static constexpr int IMAGE_TARGET_ID = 0;
     static constexpr int MODEL_TARGET_ID = 1;
+    /// Number of Image Targets Vuforia is asked to track at the same time
+    static constexpr int MAX_SIMULTANEOUS_IMAGE_TARGETS = 10;
 
     // Type definitions
     using ErrorCallback = std::function<void(const char* errorString)>;
     using InitDoneCallback = std::function<void()>;
 
+    /// Rendering information for a tracked target
+    struct TargetResult
+    {
+        Vuforia::Matrix44F modelViewMatrix;
+        /// modelViewMatrix scaled to the target size, for rendering a unit bounding box
+        Vuforia::Matrix44F scaledModelViewMatrix;
+    };
+
     /// Struct to group initialization parameters passed to initAR
     using InitConfig = struct
     {
@@ -91,6 +103,9 @@ public:
     /// Query whether the camera is currently started
     bool isCameraStarted() { return mCameraIsStarted; }
 
+    /// The target passed to initAR, either IMAGE_TARGET_ID or MODEL_TARGET_ID
+    int getTarget() const { return mTarget; }
+
     /// Call this method at the start of Vuforia rendering.
     /// Gets the latest video background texture from Vuforia.
     bool prepareToRender(double* viewport, Vuforia::RenderData* renderData,
@@ -113,6 +128,11 @@ public:
     bool getImageTargetResult(Vuforia::Matrix44F& projectionMatrix,
                               Vuforia::Matrix44F& modelViewMatrix, Vuforia::Matrix44F& scaledModelViewMatrix);
 
+    /// Get rendering information for all the tracked Image Targets.
+    /// results is cleared then holds one entry per target, its storage is reused between calls.
+    /// Returns false if Vuforia isn't currently tracking any Image Target.
+    bool getImageTargetResults(Vuforia::Matrix44F& projectionMatrix, std::vector<TargetResult>& results);
+
     /// Get rendering information for the Model Target.
     /// Returns false if Vuforia isn't currently tracking the Model Target.
     bool getModelTargetResult(Vuforia::Matrix44F& projectionMatrix,
@@ -155,6 +175,16 @@ private: // methods
     /// Calculate the video background configuration to pass to Vuforia.
     void configureVideoBackground(float viewWidth, float viewHeight);
     
+    /// Get the view matrix from the device pose for the current frame
+    Vuforia::Matrix44F getViewMatrix() const;
+
+    /// Get the projection matrix for the current frame
+    Vuforia::Matrix44F getProjectionMatrix() const;
+
+    /// Calculate the rendering information of an Image Target result
+    void computeImageTargetResult(const Vuforia::TrackableResult* result,
+                                  const Vuforia::Matrix44F& viewMatrix, TargetResult& targetResult) const;
+
     /// Utility method to load and activate datasets
     /// Can be used before trackers are started.
     /// During an active Vuforia session dataset activation is only allowed in the Vuforia_onUpdate() callback.
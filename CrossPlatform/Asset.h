@@ -0,0 +1,72 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+ 
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __ASSET_H__
+#define __ASSET_H__
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+/// Read-only contents of an asset
+/**
+ * The data is mapped or owned by the platform, e.g. an Android asset
+ * buffer or a memory mapped file, and stays valid until the Asset is
+ * destroyed. Parse from it directly rather than copying it.
+ */
+class Asset
+{
+public:
+    virtual ~Asset() = default;
+
+    Asset(const Asset&) = delete;
+    Asset& operator=(const Asset&) = delete;
+
+    /// First byte of the asset, nullptr for an empty asset
+    const char* getData() const { return mData; }
+    /// Size of the asset in bytes
+    size_t getSize() const { return mSize; }
+
+protected:
+    Asset() = default;
+
+    const char* mData = nullptr;
+    size_t mSize = 0;
+};
+
+
+/// Asset data held in memory, e.g. produced by decoding another asset
+class MemoryAsset : public Asset
+{
+public:
+    explicit MemoryAsset(std::vector<char> data) : mStorage(std::move(data))
+    {
+        mData = mStorage.empty() ? nullptr : mStorage.data();
+        mSize = mStorage.size();
+    }
+
+private:
+    std::vector<char> mStorage;
+};
+
+
+/// Platform specific way of opening assets by name
+class AssetSource
+{
+public:
+    virtual ~AssetSource() = default;
+
+    /// Open an asset, returns nullptr when it doesn't exist or can't be read
+    /*
+    * Implementations must allow assets to be opened from any thread.
+    */
+    virtual std::unique_ptr<Asset> open(const char* name) const = 0;
+};
+
+#endif // __ASSET_H__
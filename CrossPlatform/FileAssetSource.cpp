@@ -0,0 +1,85 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+ 
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "FileAssetSource.h"
+
+#include "Log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+
+namespace
+{
+    /// A file mapped read-only for the lifetime of the object
+    class MappedFileAsset : public Asset
+    {
+    public:
+        MappedFileAsset(void* mapping, size_t size)
+        {
+            mData = static_cast<const char*>(mapping);
+            mSize = size;
+        }
+
+        ~MappedFileAsset() override
+        {
+            if (mData != nullptr)
+            {
+                munmap(const_cast<char*>(mData), mSize);
+            }
+        }
+    };
+}
+
+
+FileAssetSource::FileAssetSource(std::string directory)
+    : mDirectory(std::move(directory))
+{
+}
+
+
+std::unique_ptr<Asset>
+FileAssetSource::open(const char* name) const
+{
+    std::string path = mDirectory.empty() ? std::string(name) : mDirectory + "/" + name;
+
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || !S_ISREG(status.st_mode))
+    {
+        LOG("Error reading file %s", path.c_str());
+        close(file);
+        return nullptr;
+    }
+
+    // mmap fails for empty files, they have no data
+    size_t size = static_cast<size_t>(status.st_size);
+    void* mapping = nullptr;
+    if (size > 0)
+    {
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED)
+        {
+            LOG("Error mapping file %s", path.c_str());
+            close(file);
+            return nullptr;
+        }
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(file);
+    return std::unique_ptr<Asset>(new MappedFileAsset(mapping, size));
+}
@@ -0,0 +1,33 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+ 
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __FILE_ASSET_SOURCE_H__
+#define __FILE_ASSET_SOURCE_H__
+
+#include "Asset.h"
+
+#include <string>
+
+
+/// Assets read from files, mapped into memory with mmap
+/**
+ * Used by the host tools, and anywhere assets are plain files rather than
+ * packaged with the application.
+ */
+class FileAssetSource : public AssetSource
+{
+public:
+    /// Asset names are relative to directory, or paths when it is empty
+    explicit FileAssetSource(std::string directory = std::string());
+
+    std::unique_ptr<Asset> open(const char* name) const override;
+
+private:
+    std::string mDirectory;
+};
+
+#endif // __FILE_ASSET_SOURCE_H__
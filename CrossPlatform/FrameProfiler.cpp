@@ -0,0 +1,119 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+ 
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+
+namespace
+{
+    /// Single producer ring of samples
+    /*
+    * written counts all the samples ever recorded, the newest sample is at
+    * (written - 1) % SAMPLE_COUNT. It is published with release ordering
+    * after the sample is stored.
+    */
+    struct SampleRing
+    {
+        std::atomic<uint32_t> written { 0 };
+        std::atomic<float> samples[FrameProfiler::SAMPLE_COUNT] {};
+    };
+
+    SampleRing gRings[FrameProfiler::STAGE_COUNT];
+
+    /// Value at a percentile of sorted samples, nearest rank
+    float percentile(const std::vector<float>& sorted, float fraction)
+    {
+        size_t rank = static_cast<size_t>(fraction * static_cast<float>(sorted.size()) + 0.5f);
+        rank = std::min(std::max(rank, size_t(1)), sorted.size());
+        return sorted[rank - 1];
+    }
+}
+
+
+FrameProfiler::ScopedTimer::~ScopedTimer()
+{
+    record(mStage, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mStart).count());
+}
+
+
+const char*
+FrameProfiler::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case STAGE_FRAME:                   return "frame";
+        case STAGE_UPDATE_STATE:            return "update state";
+        case STAGE_RENDERER_BEGIN:          return "renderer begin";
+        case STAGE_VIDEO_BACKGROUND:        return "video background";
+        case STAGE_AUGMENTATIONS:           return "augmentations";
+        case STAGE_FINISH_RENDER:           return "finish render";
+        case STAGE_GPU_VIDEO_BACKGROUND:    return "GPU video background";
+        case STAGE_GPU_AUGMENTATIONS:       return "GPU augmentations";
+        default:                            return "unknown";
+    }
+}
+
+
+void
+FrameProfiler::record(Stage stage, float milliseconds)
+{
+    if (stage < 0 || stage >= STAGE_COUNT)
+    {
+        return;
+    }
+
+    SampleRing& ring = gRings[stage];
+    uint32_t written = ring.written.load(std::memory_order_relaxed);
+    ring.samples[written % SAMPLE_COUNT].store(milliseconds, std::memory_order_relaxed);
+    ring.written.store(written + 1, std::memory_order_release);
+}
+
+
+FrameProfiler::Percentiles
+FrameProfiler::getPercentiles(Stage stage)
+{
+    Percentiles result;
+    if (stage < 0 || stage >= STAGE_COUNT)
+    {
+        return result;
+    }
+
+    const SampleRing& ring = gRings[stage];
+    uint32_t written = ring.written.load(std::memory_order_acquire);
+    uint32_t count = std::min<uint32_t>(written, SAMPLE_COUNT);
+    if (count == 0)
+    {
+        return result;
+    }
+
+    std::vector<float> samples(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        samples[i] = ring.samples[(written - 1 - i) % SAMPLE_COUNT].load(std::memory_order_relaxed);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    result.p50 = percentile(samples, 0.50f);
+    result.p95 = percentile(samples, 0.95f);
+    result.p99 = percentile(samples, 0.99f);
+    return result;
+}
+
+
+void
+FrameProfiler::reset()
+{
+    for (SampleRing& ring : gRings)
+    {
+        ring.written.store(0, std::memory_order_release);
+    }
+}
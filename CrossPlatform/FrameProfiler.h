@@ -0,0 +1,96 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+ 
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __FRAME_PROFILER_H__
+#define __FRAME_PROFILER_H__
+
+#include <chrono>
+
+/// Set to 0 to compile all PROFILE_SCOPE timers out
+#ifndef ENABLE_FRAME_PROFILER
+#define ENABLE_FRAME_PROFILER 1
+#endif
+
+
+/// Rolling per stage timings of the render loop
+/**
+ * Each stage keeps its last SAMPLE_COUNT durations in a ring buffer. The
+ * render thread records samples and any other thread can read percentiles
+ * at the same time without locking, a reader may see a sample being
+ * replaced but never blocks the render thread.
+ *
+ * CPU stages are timed with PROFILE_SCOPE, GPU stages are recorded by the
+ * platform renderer from timer queries.
+ */
+class FrameProfiler
+{
+public:
+    /// Stages of a frame, in the order returned to the application
+    enum Stage
+    {
+        STAGE_FRAME,                ///< The whole frame on the CPU
+        STAGE_UPDATE_STATE,         ///< StateUpdater::updateState
+        STAGE_RENDERER_BEGIN,       ///< Renderer::begin and the video background texture update
+        STAGE_VIDEO_BACKGROUND,     ///< Drawing the video background
+        STAGE_AUGMENTATIONS,        ///< Submitting and drawing the augmentations
+        STAGE_FINISH_RENDER,        ///< Renderer::end
+        STAGE_GPU_VIDEO_BACKGROUND, ///< GPU time of the video background
+        STAGE_GPU_AUGMENTATIONS,    ///< GPU time of the augmentations
+        STAGE_COUNT
+    };
+
+    /// Number of samples kept for each stage
+    static const int SAMPLE_COUNT = 256;
+
+    /// Durations in milliseconds, 0 when no sample was recorded
+    struct Percentiles
+    {
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    /// Times the scope it is declared in and records it for a stage
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Stage stage) : mStage(stage), mStart(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Stage mStage;
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+    /// Name of a stage for logging
+    static const char* getStageName(Stage stage);
+
+    /// Add a sample to a stage, only call from one thread, e.g. the render thread
+    static void record(Stage stage, float milliseconds);
+
+    /// Percentiles of the samples currently held for a stage, safe to call from any thread
+    static Percentiles getPercentiles(Stage stage);
+
+    /// Drop all samples, don't call while samples are recorded
+    static void reset();
+};
+
+
+#if ENABLE_FRAME_PROFILER
+#define PROFILE_SCOPE_CONCAT_(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_(a, b)
+/// Record the duration of the enclosing scope for a FrameProfiler stage
+#define PROFILE_SCOPE(stage) \
+    FrameProfiler::ScopedTimer PROFILE_SCOPE_CONCAT(profileScope, __LINE__)(FrameProfiler::stage)
+#else
+#define PROFILE_SCOPE(stage) do {} while (0)
+#endif
+
+#endif // __FRAME_PROFILER_H__
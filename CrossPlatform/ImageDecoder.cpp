@@ -0,0 +1,1100 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "ImageDecoder.h"
+#include "Log.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+namespace
+{
+    uint16_t readBigEndian16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] << 8 | p[1]);
+    }
+
+
+    uint32_t readBigEndian32(const uint8_t* p)
+    {
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+    }
+
+
+    uint8_t clampToByte(int value)
+    {
+        return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+
+    /// Larger images than GL can hold as a texture are rejected before anything is allocated
+    constexpr uint32_t MAX_DIMENSION = 16384;
+
+    const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    /// JPEG markers, the byte following 0xFF
+    enum JpegMarker : uint8_t
+    {
+        SOF0 = 0xC0,
+        SOF1 = 0xC1,
+        DHT = 0xC4,
+        RST0 = 0xD0,
+        RST7 = 0xD7,
+        SOI = 0xD8,
+        EOI = 0xD9,
+        SOS = 0xDA,
+        DQT = 0xDB,
+        DRI = 0xDD,
+        APP14 = 0xEE,
+    };
+
+    /// Natural order index of each zigzag ordered coefficient
+    const uint8_t ZIGZAG[64] =
+    {
+         0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+        12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+        35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+        58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+    };
+
+    /// Scale factors of the AAN inverse DCT, cos(k * pi / 16) * sqrt(2) but 1 for k = 0
+    const float AAN_SCALE[8] =
+    {
+        1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f,
+    };
+
+    /// Canonical Huffman table of a JPEG file
+    struct HuffmanTable
+    {
+        /// Codes of up to LOOKUP_BITS bits are decoded with a single lookup of the next bits
+        static constexpr int LOOKUP_BITS = 9;
+
+        /// Code length, 0 for longer codes, and symbol indexed by the next LOOKUP_BITS bits
+        uint8_t lookupLength[1 << LOOKUP_BITS];
+        uint8_t lookupSymbol[1 << LOOKUP_BITS];
+        /// Codes of each length are below maxCode[length]
+        uint32_t maxCode[18];
+        /// Added to a code of each length to index symbols
+        int32_t symbolOffset[17];
+        uint8_t symbols[256];
+        bool defined = false;
+    };
+
+
+    /// Build a table from the code counts of each length and the symbols in code order
+    bool buildHuffmanTable(const uint8_t counts[16], const uint8_t* symbols, size_t symbolCount, HuffmanTable& table)
+    {
+        memcpy(table.symbols, symbols, symbolCount);
+        memset(table.lookupLength, 0, sizeof(table.lookupLength));
+
+        uint32_t code = 0;
+        int32_t index = 0;
+        for (int length = 1; length <= 16; ++length)
+        {
+            table.symbolOffset[length] = index - static_cast<int32_t>(code);
+            for (int i = 0; i < counts[length - 1]; ++i, ++code, ++index)
+            {
+                // More codes than the length can hold, checked before they index the lookup
+                if (code >= (1u << length))
+                {
+                    return false;
+                }
+                if (length <= HuffmanTable::LOOKUP_BITS)
+                {
+                    const int shift = HuffmanTable::LOOKUP_BITS - length;
+                    for (uint32_t j = code << shift; j < (code + 1) << shift; ++j)
+                    {
+                        table.lookupLength[j] = static_cast<uint8_t>(length);
+                        table.lookupSymbol[j] = symbols[index];
+                    }
+                }
+            }
+            table.maxCode[length] = code;
+            code <<= 1;
+        }
+        table.maxCode[17] = UINT32_MAX;
+        table.defined = true;
+        return true;
+    }
+
+
+    /// Reads the entropy coded data of a JPEG scan
+    class JpegBitReader
+    {
+    public:
+        JpegBitReader(const uint8_t* data, const uint8_t* end) : mData(data), mEnd(end) {}
+
+        /// Buffer at least 57 bits, zeros are read past the end of the scan
+        void fill()
+        {
+            while (mCount <= 56)
+            {
+                uint32_t byte = 0;
+                if (!mAtMarker && mData < mEnd)
+                {
+                    byte = *mData;
+                    if (byte == 0xFF)
+                    {
+                        // 0xFF is followed by a stuffed 0, anything else is a marker
+                        if (mData + 1 < mEnd && mData[1] == 0)
+                        {
+                            mData += 2;
+                        }
+                        else
+                        {
+                            mAtMarker = true;
+                            byte = 0;
+                        }
+                    }
+                    else
+                    {
+                        ++mData;
+                    }
+                }
+                mBits |= uint64_t(byte) << (56 - mCount);
+                mCount += 8;
+            }
+        }
+
+        /// Decode a Huffman coded symbol, -1 for an invalid code
+        int decode(const HuffmanTable& table)
+        {
+            fill();
+            const uint32_t next = static_cast<uint32_t>(mBits >> (64 - HuffmanTable::LOOKUP_BITS));
+            const int length = table.lookupLength[next];
+            if (length != 0)
+            {
+                skip(length);
+                return table.lookupSymbol[next];
+            }
+            for (int longLength = HuffmanTable::LOOKUP_BITS + 1; longLength <= 16; ++longLength)
+            {
+                const uint32_t code = static_cast<uint32_t>(mBits >> (64 - longLength));
+                if (code < table.maxCode[longLength])
+                {
+                    skip(longLength);
+                    return table.symbols[(static_cast<int32_t>(code) + table.symbolOffset[longLength]) & 0xFF];
+                }
+            }
+            return -1;
+        }
+
+        /// Read a length bit value and extend it to its signed value
+        int receiveExtend(int length)
+        {
+            if (length == 0)
+            {
+                return 0;
+            }
+            fill();
+            int value = static_cast<int>(mBits >> (64 - length));
+            skip(length);
+            // Values with a clear top bit are negative
+            return value < (1 << (length - 1)) ? value - (1 << length) + 1 : value;
+        }
+
+        /// Skip the padding bits and the RST marker which ends a restart interval
+        bool restart()
+        {
+            mBits = 0;
+            mCount = 0;
+            mAtMarker = false;
+            while (mData + 1 < mEnd && !(mData[0] == 0xFF && mData[1] >= RST0 && mData[1] <= RST7))
+            {
+                ++mData;
+            }
+            if (mData + 1 >= mEnd)
+            {
+                return false;
+            }
+            mData += 2;
+            return true;
+        }
+
+    private:
+        void skip(int count)
+        {
+            mBits <<= count;
+            mCount -= count;
+        }
+
+        const uint8_t* mData;
+        const uint8_t* mEnd;
+        uint64_t mBits = 0;
+        int mCount = 0;
+        bool mAtMarker = false;
+    };
+
+
+    struct JpegComponent
+    {
+        uint8_t id = 0;
+        uint32_t h = 1;
+        uint32_t v = 1;
+        uint8_t quantizationTable = 0;
+        uint8_t dcTable = 0;
+        uint8_t acTable = 0;
+        int dcPrediction = 0;
+        /// Decoded samples, whole MCUs so blocks never straddle the edge
+        uint32_t blocksPerLine = 0;
+        uint32_t blocksPerColumn = 0;
+        std::vector<uint8_t> samples;
+    };
+
+
+    /// State of a JPEG decode, filled in as the segments are read
+    struct JpegDecoder
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t componentCount = 0;
+        JpegComponent components[3];
+        uint32_t hMax = 1;
+        uint32_t vMax = 1;
+        uint32_t mcusPerLine = 0;
+        uint32_t mcusPerColumn = 0;
+        uint32_t restartInterval = 0;
+        /// Set by an Adobe segment, 0 means RGB rather than YCbCr components
+        int adobeTransform = -1;
+        /// Dequantization with the inverse DCT scale factors folded in, natural order
+        float quantizationTables[4][64];
+        HuffmanTable dcTables[4];
+        HuffmanTable acTables[4];
+    };
+
+
+    /// Inverse DCT of a dequantized block, float version of the AAN algorithm
+    void inverseDct(const float* in, uint8_t* out, size_t stride)
+    {
+        float workspace[64];
+
+        // Columns
+        for (int i = 0; i < 8; ++i)
+        {
+            const float* column = in + i;
+            float* result = workspace + i;
+            if (column[8] == 0.0f && column[16] == 0.0f && column[24] == 0.0f && column[32] == 0.0f &&
+                column[40] == 0.0f && column[48] == 0.0f && column[56] == 0.0f)
+            {
+                // Only the DC coefficient, common in smooth areas
+                for (int j = 0; j < 8; ++j)
+                {
+                    result[j * 8] = column[0];
+                }
+                continue;
+            }
+
+            float tmp0 = column[0];
+            float tmp1 = column[16];
+            float tmp2 = column[32];
+            float tmp3 = column[48];
+            float tmp10 = tmp0 + tmp2;
+            float tmp11 = tmp0 - tmp2;
+            float tmp13 = tmp1 + tmp3;
+            float tmp12 = (tmp1 - tmp3) * 1.414213562f - tmp13;
+            tmp0 = tmp10 + tmp13;
+            tmp3 = tmp10 - tmp13;
+            tmp1 = tmp11 + tmp12;
+            tmp2 = tmp11 - tmp12;
+
+            float tmp4 = column[8];
+            float tmp5 = column[24];
+            float tmp6 = column[40];
+            float tmp7 = column[56];
+            float z13 = tmp6 + tmp5;
+            float z10 = tmp6 - tmp5;
+            float z11 = tmp4 + tmp7;
+            float z12 = tmp4 - tmp7;
+            tmp7 = z11 + z13;
+            tmp11 = (z11 - z13) * 1.414213562f;
+            float z5 = (z10 + z12) * 1.847759065f;
+            tmp10 = 1.082392200f * z12 - z5;
+            tmp12 = -2.613125930f * z10 + z5;
+            tmp6 = tmp12 - tmp7;
+            tmp5 = tmp11 - tmp6;
+            tmp4 = tmp10 + tmp5;
+
+            result[0] = tmp0 + tmp7;
+            result[56] = tmp0 - tmp7;
+            result[8] = tmp1 + tmp6;
+            result[48] = tmp1 - tmp6;
+            result[16] = tmp2 + tmp5;
+            result[40] = tmp2 - tmp5;
+            result[32] = tmp3 + tmp4;
+            result[24] = tmp3 - tmp4;
+        }
+
+        // Rows, the output is level shifted back to unsigned samples
+        for (int i = 0; i < 8; ++i)
+        {
+            const float* row = workspace + i * 8;
+            uint8_t* result = out + i * stride;
+
+            float tmp10 = row[0] + row[4];
+            float tmp11 = row[0] - row[4];
+            float tmp13 = row[2] + row[6];
+            float tmp12 = (row[2] - row[6]) * 1.414213562f - tmp13;
+            float tmp0 = tmp10 + tmp13;
+            float tmp3 = tmp10 - tmp13;
+            float tmp1 = tmp11 + tmp12;
+            float tmp2 = tmp11 - tmp12;
+
+            float z13 = row[5] + row[3];
+            float z10 = row[5] - row[3];
+            float z11 = row[1] + row[7];
+            float z12 = row[1] - row[7];
+            float tmp7 = z11 + z13;
+            tmp11 = (z11 - z13) * 1.414213562f;
+            float z5 = (z10 + z12) * 1.847759065f;
+            tmp10 = 1.082392200f * z12 - z5;
+            tmp12 = -2.613125930f * z10 + z5;
+            float tmp6 = tmp12 - tmp7;
+            float tmp5 = tmp11 - tmp6;
+            float tmp4 = tmp10 + tmp5;
+
+            result[0] = clampToByte(static_cast<int>(tmp0 + tmp7 + 128.5f));
+            result[7] = clampToByte(static_cast<int>(tmp0 - tmp7 + 128.5f));
+            result[1] = clampToByte(static_cast<int>(tmp1 + tmp6 + 128.5f));
+            result[6] = clampToByte(static_cast<int>(tmp1 - tmp6 + 128.5f));
+            result[2] = clampToByte(static_cast<int>(tmp2 + tmp5 + 128.5f));
+            result[5] = clampToByte(static_cast<int>(tmp2 - tmp5 + 128.5f));
+            result[4] = clampToByte(static_cast<int>(tmp3 + tmp4 + 128.5f));
+            result[3] = clampToByte(static_cast<int>(tmp3 - tmp4 + 128.5f));
+        }
+    }
+
+
+    /// Decode the coefficients of a block and write its samples to the component
+    bool decodeBlock(JpegDecoder& decoder, JpegBitReader& reader, JpegComponent& component,
+                     uint32_t blockX, uint32_t blockY)
+    {
+        const float* quantization = decoder.quantizationTables[component.quantizationTable];
+        float coefficients[64] = {};
+
+        int length = reader.decode(decoder.dcTables[component.dcTable]);
+        if (length < 0 || length > 11)
+        {
+            return false;
+        }
+        component.dcPrediction += reader.receiveExtend(length);
+        coefficients[0] = static_cast<float>(component.dcPrediction) * quantization[0];
+
+        bool hasAc = false;
+        for (int k = 1; k < 64;)
+        {
+            int symbol = reader.decode(decoder.acTables[component.acTable]);
+            if (symbol < 0)
+            {
+                return false;
+            }
+            const int run = symbol >> 4;
+            const int size = symbol & 15;
+            if (size == 0)
+            {
+                if (run != 15)
+                {
+                    // End of block
+                    break;
+                }
+                k += 16;
+                continue;
+            }
+            k += run;
+            if (k > 63)
+            {
+                return false;
+            }
+            const int index = ZIGZAG[k++];
+            coefficients[index] = static_cast<float>(reader.receiveExtend(size)) * quantization[index];
+            hasAc = true;
+        }
+
+        const size_t stride = size_t(component.blocksPerLine) * 8;
+        uint8_t* out = &component.samples[size_t(blockY) * 8 * stride + size_t(blockX) * 8];
+        if (!hasAc)
+        {
+            // A flat block, what the inverse DCT gives without AC coefficients
+            const uint8_t value = clampToByte(static_cast<int>(coefficients[0] + 128.5f));
+            for (int row = 0; row < 8; ++row)
+            {
+                memset(out + row * stride, value, 8);
+            }
+            return true;
+        }
+        inverseDct(coefficients, out, stride);
+        return true;
+    }
+
+
+    /// Decode the entropy coded data of a scan of the given components
+    bool decodeScan(JpegDecoder& decoder, const uint8_t* data, const uint8_t* end,
+                    JpegComponent* const* scanComponents, uint32_t scanComponentCount)
+    {
+        JpegBitReader reader(data, end);
+        for (uint32_t i = 0; i < scanComponentCount; ++i)
+        {
+            scanComponents[i]->dcPrediction = 0;
+        }
+
+        // A scan of a single component codes its blocks in raster order, not by MCU
+        uint32_t unitsPerLine = decoder.mcusPerLine;
+        uint32_t unitCount = decoder.mcusPerLine * decoder.mcusPerColumn;
+        if (scanComponentCount == 1)
+        {
+            const JpegComponent& component = *scanComponents[0];
+            unitsPerLine = ((decoder.width * component.h + decoder.hMax - 1) / decoder.hMax + 7) / 8;
+            unitCount = unitsPerLine * (((decoder.height * component.v + decoder.vMax - 1) / decoder.vMax + 7) / 8);
+        }
+
+        for (uint32_t unit = 0; unit < unitCount; ++unit)
+        {
+            if (decoder.restartInterval != 0 && unit != 0 && unit % decoder.restartInterval == 0)
+            {
+                if (!reader.restart())
+                {
+                    LOG("Error: JPEG restart marker is missing");
+                    return false;
+                }
+                for (uint32_t i = 0; i < scanComponentCount; ++i)
+                {
+                    scanComponents[i]->dcPrediction = 0;
+                }
+            }
+
+            const uint32_t unitX = unit % unitsPerLine;
+            const uint32_t unitY = unit / unitsPerLine;
+            if (scanComponentCount == 1)
+            {
+                if (!decodeBlock(decoder, reader, *scanComponents[0], unitX, unitY))
+                {
+                    LOG("Error: JPEG entropy coded data is corrupt");
+                    return false;
+                }
+                continue;
+            }
+            for (uint32_t i = 0; i < scanComponentCount; ++i)
+            {
+                JpegComponent& component = *scanComponents[i];
+                for (uint32_t v = 0; v < component.v; ++v)
+                {
+                    for (uint32_t h = 0; h < component.h; ++h)
+                    {
+                        if (!decodeBlock(decoder, reader, component, unitX * component.h + h, unitY * component.v + v))
+                        {
+                            LOG("Error: JPEG entropy coded data is corrupt");
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+
+    /// Position of the marker which ends the entropy coded data of a scan
+    const uint8_t* skipEntropyCodedData(const uint8_t* p, const uint8_t* end)
+    {
+        for (; p + 1 < end; ++p)
+        {
+            if (p[0] == 0xFF && p[1] != 0 && p[1] != 0xFF && !(p[1] >= RST0 && p[1] <= RST7))
+            {
+                return p;
+            }
+        }
+        return end;
+    }
+
+
+    /// Read the frame header, the components are allocated unless infoOnly
+    bool readJpegFrame(const uint8_t* segment, size_t length, JpegDecoder& decoder, bool infoOnly)
+    {
+        if (length < 6 || segment[0] != 8)
+        {
+            LOG("Error: only 8-bit JPEG files are supported");
+            return false;
+        }
+        decoder.height = readBigEndian16(segment + 1);
+        decoder.width = readBigEndian16(segment + 3);
+        decoder.componentCount = segment[5];
+        if (decoder.width == 0 || decoder.height == 0 ||
+            (decoder.componentCount != 1 && decoder.componentCount != 3) ||
+            length < 6 + size_t(decoder.componentCount) * 3)
+        {
+            LOG("Error: JPEG files must be grayscale or color with known dimensions");
+            return false;
+        }
+        if (infoOnly)
+        {
+            return true;
+        }
+
+        for (uint32_t i = 0; i < decoder.componentCount; ++i)
+        {
+            JpegComponent& component = decoder.components[i];
+            const uint8_t* p = segment + 6 + i * 3;
+            component.id = p[0];
+            component.h = p[1] >> 4;
+            component.v = p[1] & 15;
+            component.quantizationTable = p[2] & 3;
+            if (component.h < 1 || component.h > 4 || component.v < 1 || component.v > 4)
+            {
+                LOG("Error: JPEG sampling factors are invalid");
+                return false;
+            }
+            decoder.hMax = std::max(decoder.hMax, component.h);
+            decoder.vMax = std::max(decoder.vMax, component.v);
+        }
+
+        decoder.mcusPerLine = (decoder.width + 8 * decoder.hMax - 1) / (8 * decoder.hMax);
+        decoder.mcusPerColumn = (decoder.height + 8 * decoder.vMax - 1) / (8 * decoder.vMax);
+        for (uint32_t i = 0; i < decoder.componentCount; ++i)
+        {
+            JpegComponent& component = decoder.components[i];
+            component.blocksPerLine = decoder.mcusPerLine * component.h;
+            component.blocksPerColumn = decoder.mcusPerColumn * component.v;
+            component.samples.assign(size_t(component.blocksPerLine) * component.blocksPerColumn * 64, 0);
+        }
+        return true;
+    }
+
+
+    bool readJpegQuantizationTables(const uint8_t* segment, size_t length, JpegDecoder& decoder)
+    {
+        const uint8_t* end = segment + length;
+        while (segment < end)
+        {
+            const int precision = segment[0] >> 4;
+            const int id = segment[0] & 3;
+            const size_t tableSize = precision == 0 ? 64 : 128;
+            if (size_t(end - segment) < 1 + tableSize)
+            {
+                return false;
+            }
+            for (int k = 0; k < 64; ++k)
+            {
+                const int value = precision == 0 ? segment[1 + k] : readBigEndian16(segment + 1 + 2 * k);
+                const int index = ZIGZAG[k];
+                // The 1/8 of the inverse DCT is folded in as well
+                decoder.quantizationTables[id][index] = value * AAN_SCALE[index / 8] * AAN_SCALE[index % 8] / 8.0f;
+            }
+            segment += 1 + tableSize;
+        }
+        return true;
+    }
+
+
+    bool readJpegHuffmanTables(const uint8_t* segment, size_t length, JpegDecoder& decoder)
+    {
+        const uint8_t* end = segment + length;
+        while (segment < end)
+        {
+            if (end - segment < 17)
+            {
+                return false;
+            }
+            const int tableClass = segment[0] >> 4;
+            const int id = segment[0] & 3;
+            const uint8_t* counts = segment + 1;
+            size_t symbolCount = 0;
+            for (int i = 0; i < 16; ++i)
+            {
+                symbolCount += counts[i];
+            }
+            if (symbolCount > 256 || size_t(end - segment) < 17 + symbolCount)
+            {
+                return false;
+            }
+            HuffmanTable& table = tableClass == 0 ? decoder.dcTables[id] : decoder.acTables[id];
+            if (!buildHuffmanTable(counts, segment + 17, symbolCount, table))
+            {
+                return false;
+            }
+            segment += 17 + symbolCount;
+        }
+        return true;
+    }
+
+
+    /// Convert the decoded components to RGBA8
+    void writeJpegPixels(const JpegDecoder& decoder, uint8_t* destination, size_t stride, bool flipVertically)
+    {
+        // Column of each output pixel in the samples of each component
+        std::vector<uint32_t> columns[3];
+        for (uint32_t i = 0; i < decoder.componentCount; ++i)
+        {
+            columns[i].resize(decoder.width);
+            for (uint32_t x = 0; x < decoder.width; ++x)
+            {
+                columns[i][x] = x * decoder.components[i].h / decoder.hMax;
+            }
+        }
+
+        const bool isRgb = decoder.componentCount == 3 && decoder.adobeTransform == 0;
+        for (uint32_t y = 0; y < decoder.height; ++y)
+        {
+            uint8_t* out = destination + size_t(flipVertically ? decoder.height - 1 - y : y) * stride;
+            const uint8_t* rows[3];
+            for (uint32_t i = 0; i < decoder.componentCount; ++i)
+            {
+                const JpegComponent& component = decoder.components[i];
+                rows[i] = &component.samples[size_t(y * component.v / decoder.vMax) * component.blocksPerLine * 8];
+            }
+
+            if (decoder.componentCount == 1)
+            {
+                for (uint32_t x = 0; x < decoder.width; ++x, out += 4)
+                {
+                    out[0] = out[1] = out[2] = rows[0][x];
+                    out[3] = 255;
+                }
+            }
+            else if (isRgb)
+            {
+                for (uint32_t x = 0; x < decoder.width; ++x, out += 4)
+                {
+                    out[0] = rows[0][columns[0][x]];
+                    out[1] = rows[1][columns[1][x]];
+                    out[2] = rows[2][columns[2][x]];
+                    out[3] = 255;
+                }
+            }
+            else
+            {
+                // JFIF YCbCr to RGB in 16.16 fixed point
+                for (uint32_t x = 0; x < decoder.width; ++x, out += 4)
+                {
+                    const int luma = (rows[0][columns[0][x]] << 16) + (1 << 15);
+                    const int cb = rows[1][columns[1][x]] - 128;
+                    const int cr = rows[2][columns[2][x]] - 128;
+                    out[0] = clampToByte((luma + 91881 * cr) >> 16);
+                    out[1] = clampToByte((luma - 22554 * cb - 46802 * cr) >> 16);
+                    out[2] = clampToByte((luma + 116130 * cb) >> 16);
+                    out[3] = 255;
+                }
+            }
+        }
+    }
+
+
+    /// Read the segments of a JPEG file, the image is decoded to destination unless it is null
+    bool readJpeg(const uint8_t* data, size_t size, JpegDecoder& decoder,
+                  uint8_t* destination, size_t stride, bool flipVertically)
+    {
+        const bool infoOnly = destination == nullptr;
+        const uint8_t* end = data + size;
+        const uint8_t* p = data + 2;
+        bool hasFrame = false;
+
+        while (p + 2 <= end)
+        {
+            if (p[0] != 0xFF)
+            {
+                LOG("Error: JPEG marker expected");
+                return false;
+            }
+            const uint8_t marker = p[1];
+            p += 2;
+            if (marker == 0xFF)
+            {
+                // Fill byte before a marker
+                --p;
+                continue;
+            }
+            if (marker == EOI)
+            {
+                break;
+            }
+            if ((marker >= RST0 && marker <= RST7) || marker == 0x01)
+            {
+                continue;
+            }
+
+            if (p + 2 > end || readBigEndian16(p) < 2 || p + readBigEndian16(p) > end)
+            {
+                LOG("Error: JPEG file is truncated");
+                return false;
+            }
+            const size_t length = readBigEndian16(p);
+            const uint8_t* segment = p + 2;
+            const size_t segmentLength = length - 2;
+
+            switch (marker)
+            {
+                case SOF0:
+                case SOF1:
+                    if (!readJpegFrame(segment, segmentLength, decoder, infoOnly))
+                    {
+                        return false;
+                    }
+                    if (infoOnly)
+                    {
+                        return true;
+                    }
+                    hasFrame = true;
+                    break;
+
+                case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+                case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                    LOG("Error: only baseline JPEG files are supported, SOF%d found", marker - SOF0);
+                    return false;
+
+                case DHT:
+                    if (!readJpegHuffmanTables(segment, segmentLength, decoder))
+                    {
+                        LOG("Error: JPEG Huffman table is invalid");
+                        return false;
+                    }
+                    break;
+
+                case DQT:
+                    if (!readJpegQuantizationTables(segment, segmentLength, decoder))
+                    {
+                        LOG("Error: JPEG quantization table is invalid");
+                        return false;
+                    }
+                    break;
+
+                case DRI:
+                    if (segmentLength < 2)
+                    {
+                        return false;
+                    }
+                    decoder.restartInterval = readBigEndian16(segment);
+                    break;
+
+                case APP14:
+                    if (segmentLength >= 12 && memcmp(segment, "Adobe", 5) == 0)
+                    {
+                        decoder.adobeTransform = segment[11];
+                    }
+                    break;
+
+                case SOS:
+                {
+                    if (!hasFrame || segmentLength < 1)
+                    {
+                        LOG("Error: JPEG scan before the frame header");
+                        return false;
+                    }
+                    const uint32_t scanComponentCount = segment[0];
+                    if (scanComponentCount < 1 || scanComponentCount > decoder.componentCount ||
+                        segmentLength < 4 + size_t(scanComponentCount) * 2)
+                    {
+                        LOG("Error: JPEG scan header is invalid");
+                        return false;
+                    }
+                    JpegComponent* scanComponents[3];
+                    for (uint32_t i = 0; i < scanComponentCount; ++i)
+                    {
+                        const uint8_t* entry = segment + 1 + i * 2;
+                        JpegComponent* component = nullptr;
+                        for (uint32_t j = 0; j < decoder.componentCount; ++j)
+                        {
+                            if (decoder.components[j].id == entry[0])
+                            {
+                                component = &decoder.components[j];
+                            }
+                        }
+                        if (component == nullptr)
+                        {
+                            LOG("Error: JPEG scan refers to an unknown component");
+                            return false;
+                        }
+                        component->dcTable = entry[1] >> 4 & 3;
+                        component->acTable = entry[1] & 3;
+                        if (!decoder.dcTables[component->dcTable].defined ||
+                            !decoder.acTables[component->acTable].defined)
+                        {
+                            LOG("Error: JPEG scan uses an undefined Huffman table");
+                            return false;
+                        }
+                        scanComponents[i] = component;
+                    }
+
+                    const uint8_t* scanData = p + length;
+                    if (!decodeScan(decoder, scanData, end, scanComponents, scanComponentCount))
+                    {
+                        return false;
+                    }
+                    p = skipEntropyCodedData(scanData, end);
+                    continue;
+                }
+
+                default:
+                    break;
+            }
+            p += length;
+        }
+
+        if (infoOnly || !hasFrame)
+        {
+            LOG("Error: JPEG file has no frame");
+            return false;
+        }
+        writeJpegPixels(decoder, destination, stride, flipVertically);
+        return true;
+    }
+
+
+    /// Predictor of the PNG Paeth filter
+    int paeth(int left, int up, int upLeft)
+    {
+        const int estimate = left + up - upLeft;
+        const int leftDistance = abs(estimate - left);
+        const int upDistance = abs(estimate - up);
+        const int upLeftDistance = abs(estimate - upLeft);
+        if (leftDistance <= upDistance && leftDistance <= upLeftDistance)
+        {
+            return left;
+        }
+        return upDistance <= upLeftDistance ? up : upLeft;
+    }
+
+
+    /// Undo the filter of a PNG row in place, previous is the unfiltered row above
+    bool unfilterPngRow(uint8_t filter, uint8_t* row, const uint8_t* previous, size_t rowBytes, size_t pixelBytes)
+    {
+        switch (filter)
+        {
+            case 0:
+                return true;
+            case 1:
+                for (size_t i = pixelBytes; i < rowBytes; ++i)
+                {
+                    row[i] = static_cast<uint8_t>(row[i] + row[i - pixelBytes]);
+                }
+                return true;
+            case 2:
+                for (size_t i = 0; i < rowBytes; ++i)
+                {
+                    row[i] = static_cast<uint8_t>(row[i] + previous[i]);
+                }
+                return true;
+            case 3:
+                for (size_t i = 0; i < rowBytes; ++i)
+                {
+                    const int left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+                    row[i] = static_cast<uint8_t>(row[i] + ((left + previous[i]) >> 1));
+                }
+                return true;
+            case 4:
+                for (size_t i = 0; i < rowBytes; ++i)
+                {
+                    const int left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+                    const int upLeft = i >= pixelBytes ? previous[i - pixelBytes] : 0;
+                    row[i] = static_cast<uint8_t>(row[i] + paeth(left, previous[i], upLeft));
+                }
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+
+bool
+ImageDecoder::getInfo(const void* data, size_t size, Info& info)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    info = Info();
+    if (bytes != nullptr && size >= 4 && bytes[0] == 0xFF && bytes[1] == SOI)
+    {
+        std::unique_ptr<JpegDecoder> decoder(new JpegDecoder());
+        if (!readJpeg(bytes, size, *decoder, nullptr, 0, false))
+        {
+            return false;
+        }
+        info.format = FORMAT_JPEG;
+        info.width = decoder->width;
+        info.height = decoder->height;
+    }
+    else if (bytes != nullptr && size >= 33 && memcmp(bytes, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0)
+    {
+        // IHDR is always the first chunk
+        if (memcmp(bytes + 12, "IHDR", 4) != 0)
+        {
+            LOG("Error: PNG file has no header");
+            return false;
+        }
+        info.format = FORMAT_PNG;
+        info.width = readBigEndian32(bytes + 16);
+        info.height = readBigEndian32(bytes + 20);
+    }
+    else
+    {
+        LOG("Error: image is neither a JPEG nor a PNG file");
+        return false;
+    }
+
+    if (info.width == 0 || info.height == 0 || info.width > MAX_DIMENSION || info.height > MAX_DIMENSION)
+    {
+        LOG("Error: image of %ux%u pixels is not supported", info.width, info.height);
+        return false;
+    }
+    return true;
+}
+
+
+bool
+ImageDecoder::decode(const void* data, size_t size, uint8_t* destination, size_t stride, bool flipVertically)
+{
+    Info info;
+    if (destination == nullptr || !getInfo(data, size, info))
+    {
+        return false;
+    }
+    auto bytes = static_cast<const uint8_t*>(data);
+    return info.format == FORMAT_JPEG ? decodeJpeg(bytes, size, destination, stride, flipVertically)
+                                      : decodePng(bytes, size, destination, stride, flipVertically);
+}
+
+
+bool
+ImageDecoder::decodeJpeg(const uint8_t* data, size_t size, uint8_t* destination, size_t stride, bool flipVertically)
+{
+    // The tables are too large for the stack
+    std::unique_ptr<JpegDecoder> decoder(new JpegDecoder());
+    return readJpeg(data, size, *decoder, destination, stride, flipVertically);
+}
+
+
+bool
+ImageDecoder::decodePng(const uint8_t* data, size_t size, uint8_t* destination, size_t stride, bool flipVertically)
+{
+    const uint8_t* end = data + size;
+    const uint8_t* header = data + 16;
+    const uint32_t width = readBigEndian32(header);
+    const uint32_t height = readBigEndian32(header + 4);
+    const uint8_t bitDepth = header[8];
+    const uint8_t colorType = header[9];
+    const uint8_t interlace = header[12];
+
+    // Channels of each color type: gray, -, RGB, palette, gray alpha, -, RGBA
+    static const uint8_t CHANNELS[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    if (bitDepth != 8 || colorType > 6 || CHANNELS[colorType] == 0 || interlace != 0)
+    {
+        LOG("Error: only non-interlaced 8-bit PNG files are supported");
+        return false;
+    }
+    const size_t pixelBytes = CHANNELS[colorType];
+    const size_t rowBytes = size_t(width) * pixelBytes;
+
+    // Rows as stored, each preceded by its filter type
+    std::vector<uint8_t> rows((rowBytes + 1) * height);
+    uint8_t palette[256][4] = {};
+
+    z_stream stream {};
+    if (inflateInit(&stream) != Z_OK)
+    {
+        return false;
+    }
+    stream.next_out = rows.data();
+    stream.avail_out = static_cast<uInt>(rows.size());
+
+    bool inflated = false;
+    const uint8_t* p = data + sizeof(PNG_SIGNATURE);
+    while (p + 12 <= end)
+    {
+        const uint32_t length = readBigEndian32(p);
+        const uint8_t* type = p + 4;
+        const uint8_t* chunk = p + 8;
+        if (length > size_t(end - chunk) - 4)
+        {
+            break;
+        }
+
+        if (memcmp(type, "PLTE", 4) == 0)
+        {
+            for (uint32_t i = 0; i < std::min(length / 3, 256u); ++i)
+            {
+                memcpy(palette[i], chunk + i * 3, 3);
+                palette[i][3] = 255;
+            }
+        }
+        else if (memcmp(type, "tRNS", 4) == 0 && colorType == 3)
+        {
+            for (uint32_t i = 0; i < std::min(length, 256u); ++i)
+            {
+                palette[i][3] = chunk[i];
+            }
+        }
+        else if (memcmp(type, "IDAT", 4) == 0 && !inflated)
+        {
+            stream.next_in = const_cast<Bytef*>(chunk);
+            stream.avail_in = length;
+            const int result = inflate(&stream, Z_NO_FLUSH);
+            if (result == Z_STREAM_END)
+            {
+                inflated = true;
+            }
+            else if (result != Z_OK && result != Z_BUF_ERROR)
+            {
+                break;
+            }
+        }
+        else if (memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+        p = chunk + length + 4;
+    }
+    const bool complete = stream.total_out == rows.size();
+    inflateEnd(&stream);
+    if (!complete)
+    {
+        LOG("Error: PNG image data is truncated or corrupt");
+        return false;
+    }
+
+    std::vector<uint8_t> zeroRow(rowBytes, 0);
+    const uint8_t* previous = zeroRow.data();
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        uint8_t* row = &rows[y * (rowBytes + 1)];
+        if (!unfilterPngRow(row[0], row + 1, previous, rowBytes, pixelBytes))
+        {
+            LOG("Error: PNG row filter %u is invalid", row[0]);
+            return false;
+        }
+        previous = row + 1;
+
+        const uint8_t* in = row + 1;
+        uint8_t* out = destination + size_t(flipVertically ? height - 1 - y : y) * stride;
+        for (uint32_t x = 0; x < width; ++x, out += 4)
+        {
+            switch (colorType)
+            {
+                case 0:
+                    out[0] = out[1] = out[2] = in[x];
+                    out[3] = 255;
+                    break;
+                case 2:
+                    memcpy(out, in + x * 3, 3);
+                    out[3] = 255;
+                    break;
+                case 3:
+                    memcpy(out, palette[in[x]], 4);
+                    break;
+                case 4:
+                    out[0] = out[1] = out[2] = in[x * 2];
+                    out[3] = in[x * 2 + 1];
+                    break;
+                default:
+                    memcpy(out, in + x * 4, 4);
+                    break;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __IMAGE_DECODER_H__
+#define __IMAGE_DECODER_H__
+
+#include <cstddef>
+#include <cstdint>
+
+/// Decodes JPEG and PNG images to RGBA8 without going through the JVM.
+/**
+ * Decoding is split in two so the caller can size the destination, e.g. a
+ * mapped pixel unpack buffer, before any pixel is decoded:
+ *
+ *     ImageDecoder::Info info;
+ *     if (ImageDecoder::getInfo(data, size, info))
+ *     {
+ *         ... allocate info.width * info.height * 4 bytes ...
+ *         ImageDecoder::decode(data, size, destination, info.width * 4, true);
+ *     }
+ *
+ * JPEG files must be baseline, i.e. sequential with Huffman coding, which
+ * is what image editors write by default. Chroma is upsampled by repeating
+ * samples. PNG files must be 8 bits per channel and not interlaced, they
+ * are inflated with zlib. Other files fail with an error logged.
+ */
+class ImageDecoder
+{
+public:
+    /// Bytes per decoded pixel
+    static constexpr size_t PIXEL_SIZE = 4;
+
+    enum Format
+    {
+        FORMAT_UNKNOWN,
+        FORMAT_JPEG,
+        FORMAT_PNG,
+    };
+
+    /// Image properties read from the header
+    struct Info
+    {
+        Format format = FORMAT_UNKNOWN;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    /// Read the format and dimensions of an encoded image
+    static bool getInfo(const void* data, size_t size, Info& info);
+
+    /// Decode an image to RGBA8 rows of stride bytes
+    /// With flipVertically the first row written is the bottom row of the image,
+    /// the order GL expects texture rows in.
+    static bool decode(const void* data, size_t size, uint8_t* destination, size_t stride, bool flipVertically);
+
+private:
+    static bool decodeJpeg(const uint8_t* data, size_t size, uint8_t* destination, size_t stride, bool flipVertically);
+    static bool decodePng(const uint8_t* data, size_t size, uint8_t* destination, size_t stride, bool flipVertically);
+};
+
+#endif // __IMAGE_DECODER_H__
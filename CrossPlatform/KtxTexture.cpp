@@ -0,0 +1,263 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "KtxTexture.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+    /// Round size up to the next multiple of 4 bytes
+    constexpr size_t align4(size_t size) { return (size + 3) & ~size_t(3); }
+
+    /// The identifier every KTX 1.1 file starts with, «KTX 11»\r\n\x1A\n
+    const unsigned char IDENTIFIER[KtxTexture::IDENTIFIER_SIZE] =
+    {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+
+    /// Number of ASTC block sizes, each has an RGBA and an sRGB format
+    constexpr uint32_t ASTC_BLOCK_SIZE_COUNT = 14;
+
+    /// Block dimensions of the ASTC formats in the order of their enum values
+    const uint32_t ASTC_BLOCK_DIMENSIONS[ASTC_BLOCK_SIZE_COUNT][2] =
+    {
+        { 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+        { 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 },
+    };
+
+    const char* ASTC_FORMAT_NAMES[ASTC_BLOCK_SIZE_COUNT] =
+    {
+        "ASTC 4x4", "ASTC 5x4", "ASTC 5x5", "ASTC 6x5", "ASTC 6x6", "ASTC 8x5", "ASTC 8x6",
+        "ASTC 8x8", "ASTC 10x5", "ASTC 10x6", "ASTC 10x8", "ASTC 10x10", "ASTC 12x10", "ASTC 12x12",
+    };
+
+    /// Index of an ASTC format in ASTC_BLOCK_DIMENSIONS, -1 for other formats
+    int getAstcIndex(uint32_t format)
+    {
+        if (format >= KtxTexture::COMPRESSED_RGBA_ASTC_4x4 &&
+            format < KtxTexture::COMPRESSED_RGBA_ASTC_4x4 + ASTC_BLOCK_SIZE_COUNT)
+        {
+            return static_cast<int>(format - KtxTexture::COMPRESSED_RGBA_ASTC_4x4);
+        }
+        if (format >= KtxTexture::COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 &&
+            format < KtxTexture::COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 + ASTC_BLOCK_SIZE_COUNT)
+        {
+            return static_cast<int>(format - KtxTexture::COMPRESSED_SRGB8_ALPHA8_ASTC_4x4);
+        }
+        return -1;
+    }
+}
+
+
+bool
+KtxTexture::getBlockSize(uint32_t format, uint32_t& blockWidth, uint32_t& blockHeight, uint32_t& blockBytes)
+{
+    int astcIndex = getAstcIndex(format);
+    if (astcIndex >= 0)
+    {
+        blockWidth = ASTC_BLOCK_DIMENSIONS[astcIndex][0];
+        blockHeight = ASTC_BLOCK_DIMENSIONS[astcIndex][1];
+        blockBytes = 16;
+        return true;
+    }
+
+    blockWidth = 4;
+    blockHeight = 4;
+    switch (format)
+    {
+        case COMPRESSED_R11_EAC:
+        case COMPRESSED_SIGNED_R11_EAC:
+        case COMPRESSED_RGB8_ETC2:
+        case COMPRESSED_SRGB8_ETC2:
+        case COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+            blockBytes = 8;
+            return true;
+
+        case COMPRESSED_RG11_EAC:
+        case COMPRESSED_SIGNED_RG11_EAC:
+        case COMPRESSED_RGBA8_ETC2_EAC:
+        case COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+            blockBytes = 16;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+size_t
+KtxTexture::getImageSize(uint32_t format, uint32_t width, uint32_t height)
+{
+    uint32_t blockWidth, blockHeight, blockBytes;
+    if (!getBlockSize(format, blockWidth, blockHeight, blockBytes))
+    {
+        return 0;
+    }
+    size_t blocksX = (size_t(width) + blockWidth - 1) / blockWidth;
+    size_t blocksY = (size_t(height) + blockHeight - 1) / blockHeight;
+    return blocksX * blocksY * blockBytes;
+}
+
+
+const char*
+KtxTexture::getFormatName(uint32_t format)
+{
+    int astcIndex = getAstcIndex(format);
+    if (astcIndex >= 0)
+    {
+        return ASTC_FORMAT_NAMES[astcIndex];
+    }
+
+    switch (format)
+    {
+        case COMPRESSED_R11_EAC: return "EAC R11";
+        case COMPRESSED_SIGNED_R11_EAC: return "EAC signed R11";
+        case COMPRESSED_RG11_EAC: return "EAC RG11";
+        case COMPRESSED_SIGNED_RG11_EAC: return "EAC signed RG11";
+        case COMPRESSED_RGB8_ETC2: return "ETC2 RGB8";
+        case COMPRESSED_SRGB8_ETC2: return "ETC2 sRGB8";
+        case COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2: return "ETC2 RGB8 A1";
+        case COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2: return "ETC2 sRGB8 A1";
+        case COMPRESSED_RGBA8_ETC2_EAC: return "ETC2 RGBA8";
+        case COMPRESSED_SRGB8_ALPHA8_ETC2_EAC: return "ETC2 sRGB8 A8";
+        default: return "unknown";
+    }
+}
+
+
+void
+KtxTexture::serialize(uint32_t format, uint32_t baseFormat, uint32_t width, uint32_t height,
+                      const std::vector<std::vector<char>>& levels, std::vector<char>& data)
+{
+    Header header {};
+    header.endianness = ENDIANNESS;
+    header.glInternalFormat = format;
+    header.glBaseInternalFormat = baseFormat;
+    header.pixelWidth = width;
+    header.pixelHeight = height;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = static_cast<uint32_t>(levels.size());
+
+    size_t size = IDENTIFIER_SIZE + sizeof(Header);
+    for (const std::vector<char>& level : levels)
+    {
+        size += sizeof(uint32_t) + align4(level.size());
+    }
+    data.assign(size, 0);
+
+    char* out = data.data();
+    memcpy(out, IDENTIFIER, IDENTIFIER_SIZE);
+    out += IDENTIFIER_SIZE;
+    memcpy(out, &header, sizeof(Header));
+    out += sizeof(Header);
+    for (const std::vector<char>& level : levels)
+    {
+        uint32_t imageSize = static_cast<uint32_t>(level.size());
+        memcpy(out, &imageSize, sizeof(imageSize));
+        out += sizeof(imageSize);
+        memcpy(out, level.data(), level.size());
+        out += align4(level.size());
+    }
+}
+
+
+bool
+KtxTexture::parse(const void* data, size_t size, View& view)
+{
+    if (data == nullptr || size < IDENTIFIER_SIZE + sizeof(Header))
+    {
+        LOG("Error: KTX file is too small");
+        return false;
+    }
+
+    auto bytes = static_cast<const char*>(data);
+    if (memcmp(bytes, IDENTIFIER, IDENTIFIER_SIZE) != 0)
+    {
+        LOG("Error: data is not a KTX 1.1 file");
+        return false;
+    }
+
+    // Copy the header as the buffer is not guaranteed to be aligned
+    Header header;
+    memcpy(&header, bytes + IDENTIFIER_SIZE, sizeof(Header));
+
+    if (header.endianness != ENDIANNESS)
+    {
+        LOG("Error: KTX file has the wrong byte order");
+        return false;
+    }
+    if (header.glType != 0 || header.glFormat != 0 || getImageSize(header.glInternalFormat, 1, 1) == 0)
+    {
+        LOG("Error: KTX format 0x%04x is not a supported compressed format", header.glInternalFormat);
+        return false;
+    }
+    if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0 ||
+        header.numberOfArrayElements != 0 || header.numberOfFaces != 1)
+    {
+        LOG("Error: KTX file is not a 2D texture");
+        return false;
+    }
+
+    // Compressed levels can't be generated at load time, 0 levels means level 0 only
+    uint32_t levelCount = std::max(header.numberOfMipmapLevels, 1u);
+    uint32_t maxLevelCount = 1;
+    while ((std::max(header.pixelWidth, header.pixelHeight) >> maxLevelCount) != 0)
+    {
+        ++maxLevelCount;
+    }
+    if (levelCount > maxLevelCount)
+    {
+        LOG("Error: KTX file has %u mip levels, a %ux%u texture has at most %u",
+            levelCount, header.pixelWidth, header.pixelHeight, maxLevelCount);
+        return false;
+    }
+
+    size_t offset = IDENTIFIER_SIZE + sizeof(Header) + size_t(header.bytesOfKeyValueData);
+    std::vector<Level> levels(levelCount);
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        Level& level = levels[i];
+        level.width = std::max(header.pixelWidth >> i, 1u);
+        level.height = std::max(header.pixelHeight >> i, 1u);
+
+        uint32_t imageSize;
+        if (offset + sizeof(imageSize) > size)
+        {
+            LOG("Error: KTX file is truncated");
+            return false;
+        }
+        memcpy(&imageSize, bytes + offset, sizeof(imageSize));
+        offset += sizeof(imageSize);
+
+        size_t expectedSize = getImageSize(header.glInternalFormat, level.width, level.height);
+        if (imageSize != expectedSize)
+        {
+            LOG("Error: KTX level %u is %u bytes, expected %zu", i, imageSize, expectedSize);
+            return false;
+        }
+        if (offset + imageSize > size)
+        {
+            LOG("Error: KTX file is truncated");
+            return false;
+        }
+
+        level.data = bytes + offset;
+        level.size = imageSize;
+        offset += align4(imageSize);
+    }
+
+    view.header = header;
+    view.levels.swap(levels);
+
+    return true;
+}
@@ -0,0 +1,115 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __KTX_TEXTURE_H__
+#define __KTX_TEXTURE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Block compressed 2D textures in the KTX 1.1 container format.
+/**
+ * A KTX file holds the GL format of the texture and the data of each mip
+ * level, ready to be passed to glCompressedTexImage2D:
+ *
+ *     identifier | Header | key/value data | size | level 0 | size | level 1 ...
+ *
+ * Each level is preceded by its size in bytes and padded to a 4-byte
+ * boundary. Only little-endian 2D textures in the ETC2/EAC and ASTC LDR
+ * formats are supported, which covers what GLES 3 devices can sample.
+ *
+ * ETC2 files are created offline with the ImageToKtx tool, ASTC files with
+ * an ASTC encoder which can write KTX, e.g. astcenc.
+ */
+class KtxTexture
+{
+public:
+    /// Value of Header::endianness when the file matches the reader's byte order
+    static constexpr uint32_t ENDIANNESS = 0x04030201;
+    /// Size of the identifier at the start of the file
+    static constexpr size_t IDENTIFIER_SIZE = 12;
+
+    /// GL internal formats of the supported compressed formats
+    enum Format : uint32_t
+    {
+        COMPRESSED_R11_EAC                          = 0x9270,
+        COMPRESSED_SIGNED_R11_EAC                   = 0x9271,
+        COMPRESSED_RG11_EAC                         = 0x9272,
+        COMPRESSED_SIGNED_RG11_EAC                  = 0x9273,
+        COMPRESSED_RGB8_ETC2                        = 0x9274,
+        COMPRESSED_SRGB8_ETC2                       = 0x9275,
+        COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2    = 0x9276,
+        COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2   = 0x9277,
+        COMPRESSED_RGBA8_ETC2_EAC                   = 0x9278,
+        COMPRESSED_SRGB8_ALPHA8_ETC2_EAC            = 0x9279,
+        /// 14 block sizes from 4x4 to 12x12 follow each of these
+        COMPRESSED_RGBA_ASTC_4x4                    = 0x93B0,
+        COMPRESSED_SRGB8_ALPHA8_ASTC_4x4            = 0x93D0,
+    };
+
+    /// File header, follows the identifier
+    struct Header
+    {
+        uint32_t endianness;
+        /// 0 for compressed formats
+        uint32_t glType;
+        uint32_t glTypeSize;
+        /// 0 for compressed formats
+        uint32_t glFormat;
+        uint32_t glInternalFormat;
+        uint32_t glBaseInternalFormat;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        /// 0 for 2D textures
+        uint32_t pixelDepth;
+        /// 0 when the texture isn't an array
+        uint32_t numberOfArrayElements;
+        /// 1 when the texture isn't a cube map
+        uint32_t numberOfFaces;
+        /// 0 asks the loader to generate the mip levels
+        uint32_t numberOfMipmapLevels;
+        uint32_t bytesOfKeyValueData;
+    };
+
+    /// A mip level, data refers into the buffer passed to parse
+    struct Level
+    {
+        const void* data = nullptr;
+        size_t size = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    /// Read-only view of a KTX file
+    struct View
+    {
+        Header header {};
+        /// Level 0 first
+        std::vector<Level> levels;
+    };
+
+    /// Block dimensions and size of a compressed format, returns false for an unknown format
+    static bool getBlockSize(uint32_t format, uint32_t& blockWidth, uint32_t& blockHeight, uint32_t& blockBytes);
+
+    /// Size in bytes of an image of the given dimensions, 0 for an unknown format
+    static size_t getImageSize(uint32_t format, uint32_t width, uint32_t height);
+
+    /// Readable name of a compressed format, e.g. for logs
+    static const char* getFormatName(uint32_t format);
+
+    /// Write a compressed texture in the KTX format to the data buffer
+    /// levels holds the data of each mip level, level 0 first.
+    static void serialize(uint32_t format, uint32_t baseFormat, uint32_t width, uint32_t height,
+                          const std::vector<std::vector<char>>& levels, std::vector<char>& data);
+
+    /// Validate a KTX file held in memory and populate view to refer to its levels
+    /// No data is copied, the buffer must remain valid while the view is used.
+    static bool parse(const void* data, size_t size, View& view);
+};
+
+#endif // __KTX_TEXTURE_H__
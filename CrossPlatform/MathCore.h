@@ -0,0 +1,680 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __MATH_CORE_H__
+#define __MATH_CORE_H__
+
+#include <Vuforia/Matrices.h>
+#include <Vuforia/Vectors.h>
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MATH_CORE_NEON 1
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define MATH_CORE_SSE 1
+#endif
+
+#if defined(MATH_CORE_NEON) || defined(MATH_CORE_SSE)
+#define MATH_CORE_SIMD 1
+
+// The products use the vector kernels unless evaluated at compile time
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define MATH_CORE_RUNTIME_SIMD 1
+#endif
+#endif
+#endif
+
+/// Inline vector, matrix and quaternion value types for the per frame math.
+/**
+ * Everything is defined in this header so calls inline in every
+ * translation unit, and the operations but those needing a square root
+ * are constexpr:
+ *
+ *     constexpr Math::Vec3 scale(2.0f, 2.0f, 1.0f);
+ *     Vuforia::Matrix44F modelView = Math::multiply(viewMatrix, modelMatrix);
+ *     Vuforia::Matrix44F scaled = Math::scaled(modelView, scale);
+ *     constexpr Math::Mat4 offset = Math::Mat4::translation(Math::Vec3(0.0f, 0.0f, 1.0f)) * Math::Mat4::scaling(scale);
+ *
+ * The matrix functions work on Vuforia::Matrix44F in place as well as on
+ * Mat4, the value type with operators for matrices the code owns. The
+ * vector types convert to and from the Vuforia vectors implicitly.
+ *
+ * Each result is computed with the operations of the matching MathUtils
+ * function in the same order, so both give the same values. MathUtils
+ * forwards its simple functions here.
+ *
+ * At run time the matrix products and transforms use NEON on ARM and SSE
+ * on x86, in the same order as the scalar code constant expressions use.
+ */
+namespace Math
+{
+    /// Vector kernels of the products, also used by the MathUtils batch transforms
+    namespace Simd
+    {
+#if defined(MATH_CORE_NEON)
+        using Vector = float32x4_t;
+
+        inline Vector load(const float* data) { return vld1q_f32(data); }
+        inline void store(float* data, Vector v) { vst1q_f32(data, v); }
+        inline Vector set(float x, float y, float z, float w)
+        {
+            const float data[4] = { x, y, z, w };
+            return vld1q_f32(data);
+        }
+
+        /// Sum of the matrix columns weighted by the lanes of v, in the order of the scalar version
+        inline Vector transform(const Vector columns[4], Vector v)
+        {
+            // Multiply then add rather than fused, so rounding matches the scalar version
+            Vector r = vmulq_lane_f32(columns[0], vget_low_f32(v), 0);
+            r = vmlaq_lane_f32(r, columns[1], vget_low_f32(v), 1);
+            r = vmlaq_lane_f32(r, columns[2], vget_high_f32(v), 0);
+            return vmlaq_lane_f32(r, columns[3], vget_high_f32(v), 1);
+        }
+
+        inline Vector splat(float value) { return vdupq_n_f32(value); }
+        inline Vector add(Vector a, Vector b) { return vaddq_f32(a, b); }
+        inline Vector sub(Vector a, Vector b) { return vsubq_f32(a, b); }
+        inline Vector mul(Vector a, Vector b) { return vmulq_f32(a, b); }
+#elif defined(MATH_CORE_SSE)
+        using Vector = __m128;
+
+        inline Vector load(const float* data) { return _mm_loadu_ps(data); }
+        inline void store(float* data, Vector v) { _mm_storeu_ps(data, v); }
+        inline Vector set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+
+        /// Sum of the matrix columns weighted by the lanes of v, in the order of the scalar version
+        inline Vector transform(const Vector columns[4], Vector v)
+        {
+            Vector r = _mm_mul_ps(columns[0], _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+            r = _mm_add_ps(r, _mm_mul_ps(columns[1], _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+            r = _mm_add_ps(r, _mm_mul_ps(columns[2], _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+            return _mm_add_ps(r, _mm_mul_ps(columns[3], _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+        }
+
+        inline Vector splat(float value) { return _mm_set1_ps(value); }
+        inline Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+        inline Vector sub(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+        inline Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+#endif
+
+#if defined(MATH_CORE_SIMD)
+        /// Load the columns of a matrix stored column by column
+        inline void loadColumns(const float* m, Vector columns[4])
+        {
+            columns[0] = load(m);
+            columns[1] = load(m + 4);
+            columns[2] = load(m + 8);
+            columns[3] = load(m + 12);
+        }
+
+        /// r = a * b, r may be a or b as each column of b is read before it is written
+        inline void multiply(const float* a, const float* b, float* r)
+        {
+            Vector columns[4];
+            loadColumns(a, columns);
+            for (int j = 0; j < 4; ++j)
+            {
+                store(r + j * 4, transform(columns, load(b + j * 4)));
+            }
+        }
+
+        /// r = m * (x, y, z, w)
+        inline void transform(const float* m, float x, float y, float z, float w, float* r)
+        {
+            Vector columns[4];
+            loadColumns(m, columns);
+            store(r, transform(columns, set(x, y, z, w)));
+        }
+#endif
+    }
+
+    /// 2D vector, converts to and from Vuforia::Vec2F
+    struct Vec2
+    {
+        float data[2];
+
+        constexpr Vec2() : data{} {}
+        constexpr Vec2(float x, float y) : data{ x, y } {}
+        Vec2(const Vuforia::Vec2F& v) : data{ v.data[0], v.data[1] } {}
+        operator Vuforia::Vec2F() const { return Vuforia::Vec2F(data[0], data[1]); }
+
+        constexpr float operator[](int i) const { return data[i]; }
+        constexpr float& operator[](int i) { return data[i]; }
+    };
+
+    /// 3D vector, converts to and from Vuforia::Vec3F
+    struct Vec3
+    {
+        float data[3];
+
+        constexpr Vec3() : data{} {}
+        constexpr Vec3(float x, float y, float z) : data{ x, y, z } {}
+        Vec3(const Vuforia::Vec3F& v) : data{ v.data[0], v.data[1], v.data[2] } {}
+        operator Vuforia::Vec3F() const { return Vuforia::Vec3F(data[0], data[1], data[2]); }
+
+        constexpr float operator[](int i) const { return data[i]; }
+        constexpr float& operator[](int i) { return data[i]; }
+    };
+
+    /// 4D vector, converts to and from Vuforia::Vec4F
+    struct Vec4
+    {
+        float data[4];
+
+        constexpr Vec4() : data{} {}
+        constexpr Vec4(float x, float y, float z, float w) : data{ x, y, z, w } {}
+        constexpr Vec4(const Vec3& v, float w) : data{ v[0], v[1], v[2], w } {}
+        Vec4(const Vuforia::Vec4F& v) : data{ v.data[0], v.data[1], v.data[2], v.data[3] } {}
+        operator Vuforia::Vec4F() const { return Vuforia::Vec4F(data[0], data[1], data[2], data[3]); }
+
+        constexpr float operator[](int i) const { return data[i]; }
+        constexpr float& operator[](int i) { return data[i]; }
+    };
+
+    // Vec2
+
+    constexpr Vec2 operator+(const Vec2& a, const Vec2& b) { return Vec2(a[0] + b[0], a[1] + b[1]); }
+    constexpr Vec2 operator-(const Vec2& a, const Vec2& b) { return Vec2(a[0] - b[0], a[1] - b[1]); }
+    constexpr Vec2 operator-(const Vec2& v) { return Vec2(-v[0], -v[1]); }
+    constexpr Vec2 operator*(const Vec2& v, float s) { return Vec2(v[0] * s, v[1] * s); }
+    constexpr Vec2 operator*(float s, const Vec2& v) { return v * s; }
+    constexpr Vec2& operator+=(Vec2& a, const Vec2& b) { return a = a + b; }
+    constexpr Vec2& operator-=(Vec2& a, const Vec2& b) { return a = a - b; }
+    constexpr Vec2& operator*=(Vec2& v, float s) { return v = v * s; }
+    constexpr bool operator==(const Vec2& a, const Vec2& b) { return a[0] == b[0] && a[1] == b[1]; }
+    constexpr bool operator!=(const Vec2& a, const Vec2& b) { return !(a == b); }
+
+    constexpr float dot(const Vec2& a, const Vec2& b) { return a[0] * b[0] + a[1] * b[1]; }
+    inline float length(const Vec2& v) { return sqrtf(dot(v, v)); }
+    inline float distance(const Vec2& a, const Vec2& b) { return length(a - b); }
+
+    // Vec3
+
+    constexpr Vec3 operator+(const Vec3& a, const Vec3& b) { return Vec3(a[0] + b[0], a[1] + b[1], a[2] + b[2]); }
+    constexpr Vec3 operator-(const Vec3& a, const Vec3& b) { return Vec3(a[0] - b[0], a[1] - b[1], a[2] - b[2]); }
+    constexpr Vec3 operator-(const Vec3& v) { return Vec3(-v[0], -v[1], -v[2]); }
+    constexpr Vec3 operator*(const Vec3& v, float s) { return Vec3(v[0] * s, v[1] * s, v[2] * s); }
+    constexpr Vec3 operator*(float s, const Vec3& v) { return v * s; }
+    constexpr Vec3& operator+=(Vec3& a, const Vec3& b) { return a = a + b; }
+    constexpr Vec3& operator-=(Vec3& a, const Vec3& b) { return a = a - b; }
+    constexpr Vec3& operator*=(Vec3& v, float s) { return v = v * s; }
+    constexpr bool operator==(const Vec3& a, const Vec3& b) { return a[0] == b[0] && a[1] == b[1] && a[2] == b[2]; }
+    constexpr bool operator!=(const Vec3& a, const Vec3& b) { return !(a == b); }
+
+    constexpr float dot(const Vec3& a, const Vec3& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+    constexpr Vec3 cross(const Vec3& a, const Vec3& b)
+    {
+        return Vec3(a[1] * b[2] - a[2] * b[1],
+                    a[2] * b[0] - a[0] * b[2],
+                    a[0] * b[1] - a[1] * b[0]);
+    }
+    inline float length(const Vec3& v) { return sqrtf(dot(v, v)); }
+    inline float distance(const Vec3& a, const Vec3& b) { return length(a - b); }
+
+    /// v / length(v), the zero vector stays zero
+    inline Vec3 normalize(const Vec3& v)
+    {
+        float scale = length(v);
+        if (scale != 0.0f)
+            scale = 1.0f / scale;
+        return v * scale;
+    }
+
+    // Vec4
+
+    constexpr Vec4 operator+(const Vec4& a, const Vec4& b) { return Vec4(a[0] + b[0], a[1] + b[1], a[2] + b[2], a[3] + b[3]); }
+    constexpr Vec4 operator-(const Vec4& a, const Vec4& b) { return Vec4(a[0] - b[0], a[1] - b[1], a[2] - b[2], a[3] - b[3]); }
+    constexpr Vec4 operator-(const Vec4& v) { return Vec4(-v[0], -v[1], -v[2], -v[3]); }
+    constexpr Vec4 operator*(const Vec4& v, float s) { return Vec4(v[0] * s, v[1] * s, v[2] * s, v[3] * s); }
+    constexpr Vec4 operator*(float s, const Vec4& v) { return v * s; }
+    constexpr bool operator==(const Vec4& a, const Vec4& b)
+    {
+        return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+    }
+    constexpr bool operator!=(const Vec4& a, const Vec4& b) { return !(a == b); }
+
+    constexpr float dot(const Vec4& a, const Vec4& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]; }
+
+    // Matrices
+    //
+    // The functions take and return any matrix type storing its elements
+    // column by column in float data[16], element (row, column) is
+    // data[column * 4 + row]. That is Mat4 and Vuforia::Matrix44F, so the
+    // Vuforia matrices are read in place rather than copied to a Mat4.
+
+    template <typename Matrix>
+    constexpr Matrix identity()
+    {
+        Matrix r{};
+        r.data[0] = r.data[5] = r.data[10] = r.data[15] = 1.0f;
+        return r;
+    }
+
+    template <typename Matrix>
+    constexpr Matrix translation(const Vec3& v)
+    {
+        Matrix r = identity<Matrix>();
+        r.data[12] = v[0];
+        r.data[13] = v[1];
+        r.data[14] = v[2];
+        return r;
+    }
+
+    template <typename Matrix>
+    constexpr Matrix scaling(const Vec3& v)
+    {
+        Matrix r = identity<Matrix>();
+        r.data[0] = v[0];
+        r.data[5] = v[1];
+        r.data[10] = v[2];
+        return r;
+    }
+
+    template <typename Matrix>
+    constexpr Matrix transposed(const Matrix& m)
+    {
+        Matrix r{};
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                r.data[i * 4 + j] = m.data[i + 4 * j];
+        return r;
+    }
+
+    /// m * translation(v), only the last column changes
+    template <typename Matrix>
+    constexpr Matrix translated(const Matrix& m, const Vec3& v)
+    {
+        Matrix r = m;
+        for (int i = 0; i < 4; i++)
+            r.data[12 + i] += (m.data[i] * v[0] + m.data[4 + i] * v[1] + m.data[8 + i] * v[2]);
+        return r;
+    }
+
+    /// m * scaling(v), each of the first three columns is scaled
+    template <typename Matrix>
+    constexpr Matrix scaled(const Matrix& m, const Vec3& v)
+    {
+        Matrix r = m;
+        for (int i = 0; i < 4; i++)
+        {
+            r.data[i] *= v[0];
+            r.data[4 + i] *= v[1];
+            r.data[8 + i] *= v[2];
+        }
+        return r;
+    }
+
+    /// Inverse of a rotation and translation, the rotation is transposed rather than inverted
+    template <typename Matrix>
+    constexpr Matrix rigidInverse(const Matrix& m)
+    {
+        Matrix r{};
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+                r.data[i * 4 + j] = m.data[j * 4 + i];
+            r.data[12 + i] = -(m.data[i * 4] * m.data[12] + m.data[i * 4 + 1] * m.data[13] + m.data[i * 4 + 2] * m.data[14]);
+        }
+        r.data[15] = 1.0f;
+        return r;
+    }
+
+    /// m * (v, 1) without the w row
+    template <typename Matrix>
+    constexpr Vec3 transformPoint(const Matrix& m, const Vec3& v)
+    {
+#if defined(MATH_CORE_RUNTIME_SIMD)
+        if (!__builtin_is_constant_evaluated())
+        {
+            // w = 1 adds the translation column unscaled
+            float r[4] = {};
+            Simd::transform(m.data, v[0], v[1], v[2], 1.0f, r);
+            return Vec3(r[0], r[1], r[2]);
+        }
+#endif
+        return Vec3(m.data[0] * v[0] + m.data[4] * v[1] + m.data[8] * v[2] + m.data[12],
+                    m.data[1] * v[0] + m.data[5] * v[1] + m.data[9] * v[2] + m.data[13],
+                    m.data[2] * v[0] + m.data[6] * v[1] + m.data[10] * v[2] + m.data[14]);
+    }
+
+    /// m * (v, 0) without the w row
+    template <typename Matrix>
+    constexpr Vec3 transformDirection(const Matrix& m, const Vec3& v)
+    {
+        return Vec3(m.data[0] * v[0] + m.data[4] * v[1] + m.data[8] * v[2],
+                    m.data[1] * v[0] + m.data[5] * v[1] + m.data[9] * v[2],
+                    m.data[2] * v[0] + m.data[6] * v[1] + m.data[10] * v[2]);
+    }
+
+    /// m * v
+    template <typename Matrix>
+    constexpr Vec4 transform(const Matrix& m, const Vec4& v)
+    {
+        Vec4 r;
+#if defined(MATH_CORE_RUNTIME_SIMD)
+        if (!__builtin_is_constant_evaluated())
+        {
+            Simd::transform(m.data, v[0], v[1], v[2], v[3], r.data);
+            return r;
+        }
+#endif
+        for (int i = 0; i < 4; i++)
+            r[i] = m.data[i] * v[0] + m.data[4 + i] * v[1] + m.data[8 + i] * v[2] + m.data[12 + i] * v[3];
+        return r;
+    }
+
+    /// a * b
+    template <typename Matrix>
+    constexpr Matrix multiply(const Matrix& a, const Matrix& b)
+    {
+        // Column j of the product is column j of b transformed by a
+        Matrix r{};
+#if defined(MATH_CORE_RUNTIME_SIMD)
+        if (!__builtin_is_constant_evaluated())
+        {
+            Simd::multiply(a.data, b.data, r.data);
+            return r;
+        }
+#endif
+        for (int j = 0; j < 4; j++)
+            for (int i = 0; i < 4; i++)
+                r.data[j * 4 + i] = a.data[i] * b.data[j * 4] + a.data[4 + i] * b.data[j * 4 + 1] +
+                    a.data[8 + i] * b.data[j * 4 + 2] + a.data[12 + i] * b.data[j * 4 + 3];
+        return r;
+    }
+
+    /// 4x4 matrix value with operators, stored like Vuforia::Matrix44F
+    /**
+     * For matrices the code owns, e.g. constants and intermediate results.
+     * The explicit conversions copy the elements, use the matrix functions
+     * above on Vuforia::Matrix44F directly instead.
+     */
+    struct Mat4
+    {
+        float data[16];
+
+        /// The zero matrix, see identity
+        constexpr Mat4() : data{} {}
+        explicit Mat4(const Vuforia::Matrix44F& m) { memcpy(data, m.data, sizeof(data)); }
+
+        Vuforia::Matrix44F toMatrix44F() const
+        {
+            Vuforia::Matrix44F m;
+            memcpy(m.data, data, sizeof(data));
+            return m;
+        }
+
+        constexpr float operator()(int row, int column) const { return data[column * 4 + row]; }
+        constexpr float& operator()(int row, int column) { return data[column * 4 + row]; }
+
+        constexpr Vec4 column(int i) const { return Vec4(data[i * 4], data[i * 4 + 1], data[i * 4 + 2], data[i * 4 + 3]); }
+
+        static constexpr Mat4 identity() { return Math::identity<Mat4>(); }
+        static constexpr Mat4 translation(const Vec3& v) { return Math::translation<Mat4>(v); }
+        static constexpr Mat4 scaling(const Vec3& v) { return Math::scaling<Mat4>(v); }
+
+        constexpr Mat4 transposed() const { return Math::transposed(*this); }
+        constexpr Mat4 translated(const Vec3& v) const { return Math::translated(*this, v); }
+        constexpr Mat4 scaled(const Vec3& v) const { return Math::scaled(*this, v); }
+        constexpr Mat4 rigidInverse() const { return Math::rigidInverse(*this); }
+        constexpr Vec3 transformPoint(const Vec3& v) const { return Math::transformPoint(*this, v); }
+        constexpr Vec3 transformDirection(const Vec3& v) const { return Math::transformDirection(*this, v); }
+    };
+
+    static_assert(sizeof(Mat4::data) == sizeof(Vuforia::Matrix44F::data), "Mat4 holds the elements of a Vuforia::Matrix44F");
+
+    constexpr Vec4 operator*(const Mat4& m, const Vec4& v) { return transform(m, v); }
+    constexpr Mat4 operator*(const Mat4& a, const Mat4& b) { return multiply(a, b); }
+    constexpr Mat4& operator*=(Mat4& a, const Mat4& b) { return a = a * b; }
+
+    constexpr bool operator==(const Mat4& a, const Mat4& b)
+    {
+        for (int i = 0; i < 16; i++)
+            if (a.data[i] != b.data[i])
+                return false;
+        return true;
+    }
+    constexpr bool operator!=(const Mat4& a, const Mat4& b) { return !(a == b); }
+
+    /// Rotation quaternion x i + y j + z k + w, stored x, y, z, w
+    struct Quat
+    {
+        float data[4];
+
+        /// The identity rotation
+        constexpr Quat() : data{ 0.0f, 0.0f, 0.0f, 1.0f } {}
+        constexpr Quat(float x, float y, float z, float w) : data{ x, y, z, w } {}
+        Quat(const Vuforia::Vec4F& v) : data{ v.data[0], v.data[1], v.data[2], v.data[3] } {}
+        operator Vuforia::Vec4F() const { return Vuforia::Vec4F(data[0], data[1], data[2], data[3]); }
+
+        constexpr float operator[](int i) const { return data[i]; }
+        constexpr float& operator[](int i) { return data[i]; }
+
+        /// Rotation of radians around a unit axis
+        static Quat fromAxisAngle(const Vec3& axis, float radians)
+        {
+            float s = sinf(0.5f * radians);
+            return Quat(axis[0] * s, axis[1] * s, axis[2] * s, cosf(0.5f * radians));
+        }
+
+        /// Rotation of the upper 3x3 of m, a Mat4 or Vuforia::Matrix44F, which must be a rotation
+        template <typename Matrix>
+        static Quat fromMatrix(const Matrix& m)
+        {
+            // Shepperd's method, the square root is taken of the largest
+            // diagonal sum so the divisions are well conditioned
+            const float* d = m.data;
+            float trace = d[0] + d[5] + d[10];
+            if (trace > 0.0f)
+            {
+                float s = sqrtf(trace + 1.0f) * 2.0f;
+                return Quat((d[6] - d[9]) / s, (d[8] - d[2]) / s, (d[1] - d[4]) / s, 0.25f * s);
+            }
+            if (d[0] > d[5] && d[0] > d[10])
+            {
+                float s = sqrtf(1.0f + d[0] - d[5] - d[10]) * 2.0f;
+                return Quat(0.25f * s, (d[4] + d[1]) / s, (d[8] + d[2]) / s, (d[6] - d[9]) / s);
+            }
+            if (d[5] > d[10])
+            {
+                float s = sqrtf(1.0f + d[5] - d[0] - d[10]) * 2.0f;
+                return Quat((d[4] + d[1]) / s, 0.25f * s, (d[9] + d[6]) / s, (d[8] - d[2]) / s);
+            }
+            float s = sqrtf(1.0f + d[10] - d[0] - d[5]) * 2.0f;
+            return Quat((d[8] + d[2]) / s, (d[9] + d[6]) / s, 0.25f * s, (d[1] - d[4]) / s);
+        }
+
+        /// Rotation matrix of a unit quaternion, a Mat4 or Vuforia::Matrix44F
+        template <typename Matrix = Mat4>
+        constexpr Matrix toMatrix() const
+        {
+            const float x = data[0], y = data[1], z = data[2], w = data[3];
+            Matrix m = identity<Matrix>();
+            m.data[0] = 1.0f - 2.0f * (y * y + z * z);
+            m.data[1] = 2.0f * (x * y + z * w);
+            m.data[2] = 2.0f * (x * z - y * w);
+            m.data[4] = 2.0f * (x * y - z * w);
+            m.data[5] = 1.0f - 2.0f * (x * x + z * z);
+            m.data[6] = 2.0f * (y * z + x * w);
+            m.data[8] = 2.0f * (x * z + y * w);
+            m.data[9] = 2.0f * (y * z - x * w);
+            m.data[10] = 1.0f - 2.0f * (x * x + y * y);
+            return m;
+        }
+
+        constexpr Vec3 vector() const { return Vec3(data[0], data[1], data[2]); }
+
+        /// The inverse of a unit quaternion
+        constexpr Quat conjugate() const { return Quat(-data[0], -data[1], -data[2], data[3]); }
+
+        /// Rotate v by a unit quaternion, q v q*
+        constexpr Vec3 rotate(const Vec3& v) const
+        {
+            const Vec3 t = 2.0f * cross(vector(), v);
+            return v + data[3] * t + cross(vector(), t);
+        }
+    };
+
+    constexpr Quat operator+(const Quat& a, const Quat& b) { return Quat(a[0] + b[0], a[1] + b[1], a[2] + b[2], a[3] + b[3]); }
+    constexpr Quat operator-(const Quat& a, const Quat& b) { return Quat(a[0] - b[0], a[1] - b[1], a[2] - b[2], a[3] - b[3]); }
+    constexpr Quat operator-(const Quat& q) { return Quat(-q[0], -q[1], -q[2], -q[3]); }
+    constexpr Quat operator*(const Quat& q, float s) { return Quat(q[0] * s, q[1] * s, q[2] * s, q[3] * s); }
+    constexpr Quat operator*(float s, const Quat& q) { return q * s; }
+    constexpr bool operator==(const Quat& a, const Quat& b)
+    {
+        return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+    }
+    constexpr bool operator!=(const Quat& a, const Quat& b) { return !(a == b); }
+
+    /// Hamilton product, the rotation b followed by a
+    constexpr Quat operator*(const Quat& a, const Quat& b)
+    {
+        return Quat(a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+                    a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+                    a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+                    a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2]);
+    }
+
+    constexpr float dot(const Quat& a, const Quat& b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]; }
+    inline float length(const Quat& q) { return sqrtf(dot(q, q)); }
+
+    /// q / length(q), the zero quaternion stays zero
+    inline Quat normalize(const Quat& q)
+    {
+        float scale = length(q);
+        if (scale != 0.0f)
+            scale = 1.0f / scale;
+        return q * scale;
+    }
+
+    /// Rotations closer than this cosine of half their angle are interpolated linearly by slerp
+    constexpr float SLERP_LINEAR_THRESHOLD = 0.99999f;
+
+    /// Weights of the two rotations of slerp at t, from the cosine of half the angle between them
+    /**
+     * cosAngle must be positive, i.e. the second rotation flipped to the
+     * same hemisphere. t outside [0, 1] extrapolates along the arc.
+     */
+    inline void slerpWeights(float cosAngle, float t, float& weight0, float& weight1)
+    {
+        if (cosAngle > SLERP_LINEAR_THRESHOLD)
+        {
+            // sin(angle) is too small to divide by, the arc is nearly straight
+            weight0 = 1.0f - t;
+            weight1 = t;
+            return;
+        }
+        float angle = acosf(cosAngle);
+        float scale = 1.0f / sinf(angle);
+        weight0 = sinf((1.0f - t) * angle) * scale;
+        weight1 = sinf(t * angle) * scale;
+    }
+
+    /// Normalized linear interpolation along the shorter arc, faster than slerp but not at constant speed
+    inline Quat nlerp(const Quat& a, const Quat& b, float t)
+    {
+        const Quat c = dot(a, b) < 0.0f ? -b : b;
+        return normalize(a * (1.0f - t) + c * t);
+    }
+
+    /// Spherical linear interpolation along the shorter arc, at constant angular speed
+    inline Quat slerp(const Quat& a, const Quat& b, float t)
+    {
+        float cosAngle = dot(a, b);
+        Quat c = b;
+        if (cosAngle < 0.0f)
+        {
+            c = -b;
+            cosAngle = -cosAngle;
+        }
+        float weight0 = 0.0f;
+        float weight1 = 0.0f;
+        slerpWeights(cosAngle, t, weight0, weight1);
+        // Normalized so repeated interpolation doesn't drift off unit length
+        return normalize(a * weight0 + c * weight1);
+    }
+
+    /// Rigid transform as a dual quaternion real + e dual, stored as 8 floats
+    /**
+     * real is the rotation and dual is half the translation times real, so
+     * the transform rotates then translates like a rigid Mat4. Blending
+     * dual quaternions interpolates rotation and translation together
+     * without the shrinking of blended matrices.
+     */
+    struct DualQuat
+    {
+        Quat real;
+        Quat dual;
+
+        /// The identity transform
+        constexpr DualQuat() : real(), dual(0.0f, 0.0f, 0.0f, 0.0f) {}
+        constexpr DualQuat(const Quat& realPart, const Quat& dualPart) : real(realPart), dual(dualPart) {}
+
+        static constexpr DualQuat fromRotationTranslation(const Quat& rotation, const Vec3& translation)
+        {
+            return DualQuat(rotation, Quat(translation[0], translation[1], translation[2], 0.0f) * rotation * 0.5f);
+        }
+
+        /// Transform of a rotation and translation matrix, a Mat4 or Vuforia::Matrix44F
+        template <typename Matrix>
+        static DualQuat fromMatrix(const Matrix& m)
+        {
+            return fromRotationTranslation(Quat::fromMatrix(m), Vec3(m.data[12], m.data[13], m.data[14]));
+        }
+
+        constexpr Vec3 translation() const { return (dual * real.conjugate() * 2.0f).vector(); }
+
+        template <typename Matrix = Mat4>
+        constexpr Matrix toMatrix() const
+        {
+            Matrix m = real.toMatrix<Matrix>();
+            const Vec3 t = translation();
+            m.data[12] = t[0];
+            m.data[13] = t[1];
+            m.data[14] = t[2];
+            return m;
+        }
+
+        constexpr Vec3 transformPoint(const Vec3& v) const { return real.rotate(v) + translation(); }
+    };
+
+    static_assert(sizeof(DualQuat) == 8 * sizeof(float), "DualQuat is stored as 8 floats");
+
+    /// The transform b followed by a
+    constexpr DualQuat operator*(const DualQuat& a, const DualQuat& b)
+    {
+        return DualQuat(a.real * b.real, a.real * b.dual + a.dual * b.real);
+    }
+
+    /// Unit real part and dual part orthogonal to it, i.e. a rigid transform
+    inline DualQuat normalize(const DualQuat& q)
+    {
+        float scale = length(q.real);
+        if (scale != 0.0f)
+            scale = 1.0f / scale;
+        const Quat real = q.real * scale;
+        const Quat dual = q.dual * scale;
+        return DualQuat(real, dual - real * dot(real, dual));
+    }
+
+    /// Dual quaternion linear blending, the rotation follows nlerp and the translation a screw motion
+    inline DualQuat nlerp(const DualQuat& a, const DualQuat& b, float t)
+    {
+        const bool flip = dot(a.real, b.real) < 0.0f;
+        const Quat real = flip ? -b.real : b.real;
+        const Quat dual = flip ? -b.dual : b.dual;
+        return normalize(DualQuat(a.real * (1.0f - t) + real * t, a.dual * (1.0f - t) + dual * t));
+    }
+}
+
+#endif // __MATH_CORE_H__
@@ -9,89 +9,337 @@ countries.
 #include "Log.h"
 
 #define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cmath>
+#include <thread>
+#include <vector>
 
-Vuforia::Vec2F
-MathUtils::Vec2FZero()
+
+namespace
 {
-    Vuforia::Vec2F v;
+    using namespace Math::Simd;
 
-    v.data[0] = 0.0f;
-    v.data[1] = 0.0f;
+#if defined(MATH_CORE_NEON)
+    /// Load 4 vertices stored x, y, z one after another as a vector per coordinate
+    inline void load3(const float* data, Vector& x, Vector& y, Vector& z)
+    {
+        float32x4x3_t v = vld3q_f32(data);
+        x = v.val[0];
+        y = v.val[1];
+        z = v.val[2];
+    }
 
-    return v;
-}
+    inline void store3(float* data, Vector x, Vector y, Vector z)
+    {
+        float32x4x3_t v = { { x, y, z } };
+        vst3q_f32(data, v);
+    }
 
+    /// 1 / sqrt(v), 0 where v is 0
+    inline Vector reciprocalSqrt(Vector v)
+    {
+#if defined(__aarch64__)
+        Vector r = vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(v));
+#else
+        // ARMv7 has no vector divide or square root, refine the estimate twice
+        Vector r = vrsqrteq_f32(v);
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(v, r), r));
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(v, r), r));
+#endif
+        return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(r), vcgtq_f32(v, vdupq_n_f32(0.0f))));
+    }
 
-Vuforia::Vec2F
-MathUtils::Vec2FUnit()
-{
-    Vuforia::Vec2F v;
+    /// Transpose the 4x4 matrix of the rows v, e.g. 4 quaternions to a vector per component
+    inline void transpose(Vector v[4])
+    {
+        float32x4x2_t v01 = vtrnq_f32(v[0], v[1]);
+        float32x4x2_t v23 = vtrnq_f32(v[2], v[3]);
+        v[0] = vcombine_f32(vget_low_f32(v01.val[0]), vget_low_f32(v23.val[0]));
+        v[1] = vcombine_f32(vget_low_f32(v01.val[1]), vget_low_f32(v23.val[1]));
+        v[2] = vcombine_f32(vget_high_f32(v01.val[0]), vget_high_f32(v23.val[0]));
+        v[3] = vcombine_f32(vget_high_f32(v01.val[1]), vget_high_f32(v23.val[1]));
+    }
 
-    v.data[0] = 1.0f;
-    v.data[1] = 1.0f;
+    /// v negated in the lanes where sign is negative, by flipping the sign bit like the scalar negation
+    inline Vector negateWhereNegative(Vector v, Vector sign)
+    {
+        uint32x4_t flip = vandq_u32(vcltq_f32(sign, vdupq_n_f32(0.0f)), vdupq_n_u32(0x80000000u));
+        return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(v), flip));
+    }
+#elif defined(MATH_CORE_SSE)
+    /// Load 4 vertices stored x, y, z one after another as a vector per coordinate
+    inline void load3(const float* data, Vector& x, Vector& y, Vector& z)
+    {
+        // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+        Vector a = _mm_loadu_ps(data);
+        Vector b = _mm_loadu_ps(data + 4);
+        Vector c = _mm_loadu_ps(data + 8);
+        Vector xy01 = _mm_shuffle_ps(a, _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 3, 3)), _MM_SHUFFLE(2, 0, 1, 0));
+        Vector xy23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+        x = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0));
+        y = _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1));
+        z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+    }
 
-    return v;
-}
+    inline void store3(float* data, Vector x, Vector y, Vector z)
+    {
+        Vector xy01 = _mm_unpacklo_ps(x, y);
+        Vector xy23 = _mm_unpackhi_ps(x, y);
+        Vector zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+        Vector yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+        Vector zxy = _mm_shuffle_ps(z, xy23, _MM_SHUFFLE(3, 2, 3, 2));
+        _mm_storeu_ps(data, _mm_shuffle_ps(xy01, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(data + 4, _mm_shuffle_ps(yz, xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+        _mm_storeu_ps(data + 8, _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(1, 3, 2, 0)));
+    }
 
-Vuforia::Vec2F
-MathUtils::Vec2FOpposite(const Vuforia::Vec2F& v)
-{
-    Vuforia::Vec2F r;
+    /// 1 / sqrt(v), 0 where v is 0
+    inline Vector reciprocalSqrt(Vector v)
+    {
+        // Divided rather than estimated with _mm_rsqrt_ps, to match Vec3FNormalize
+        Vector r = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(v));
+        return _mm_and_ps(r, _mm_cmpgt_ps(v, _mm_setzero_ps()));
+    }
 
-    r.data[0] = -v.data[0];
-    r.data[1] = -v.data[1];
+    /// Transpose the 4x4 matrix of the rows v, e.g. 4 quaternions to a vector per component
+    inline void transpose(Vector v[4])
+    {
+        _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+    }
 
-    return r;
-}
+    /// v negated in the lanes where sign is negative, by flipping the sign bit like the scalar negation
+    inline Vector negateWhereNegative(Vector v, Vector sign)
+    {
+        return _mm_xor_ps(v, _mm_and_ps(_mm_cmplt_ps(sign, _mm_setzero_ps()), _mm_set1_ps(-0.0f)));
+    }
+#endif
 
+    /// What a batch transform applies to each vertex
+    enum TransformKind
+    {
+        /// m * (v, 1)
+        TRANSFORM_POINT,
+        /// m * (v, 0)
+        TRANSFORM_DIRECTION,
+        /// m * (v, 0) normalized, m being the normal matrix
+        TRANSFORM_NORMAL,
+    };
+
+    /// Vertices below which a batch isn't split between threads, starting a thread costs more
+    constexpr size_t MIN_VERTICES_PER_THREAD = 16384;
+
+    /// Transform a vertex with the operations of Vec3FTransform and Vec3FNormalize
+    inline void transformVertex(const float* m, float x, float y, float z, TransformKind kind,
+                                float& resultX, float& resultY, float& resultZ)
+    {
+        float rx = m[0] * x + m[4] * y + m[8] * z;
+        float ry = m[1] * x + m[5] * y + m[9] * z;
+        float rz = m[2] * x + m[6] * y + m[10] * z;
+        if (kind == TRANSFORM_POINT)
+        {
+            rx += m[12];
+            ry += m[13];
+            rz += m[14];
+        }
+        else if (kind == TRANSFORM_NORMAL)
+        {
+            float length = sqrtf(rx * rx + ry * ry + rz * rz);
+            if (length != 0.0f)
+                length = 1.0f / length;
+            rx *= length;
+            ry *= length;
+            rz *= length;
+        }
+        resultX = rx;
+        resultY = ry;
+        resultZ = rz;
+    }
 
-Vuforia::Vec2F
-MathUtils::Vec2FAdd(const Vuforia::Vec2F& v1, const Vuforia::Vec2F& v2)
-{
-    Vuforia::Vec2F r;
+#if defined(MATH_CORE_SIMD)
+    /// transformVertex for 4 vertices, the matrix elements splat across the lanes
+    inline void transformVertices(const Vector m[16], Vector& x, Vector& y, Vector& z, TransformKind kind)
+    {
+        Vector rx = add(add(mul(m[0], x), mul(m[4], y)), mul(m[8], z));
+        Vector ry = add(add(mul(m[1], x), mul(m[5], y)), mul(m[9], z));
+        Vector rz = add(add(mul(m[2], x), mul(m[6], y)), mul(m[10], z));
+        if (kind == TRANSFORM_POINT)
+        {
+            rx = add(rx, m[12]);
+            ry = add(ry, m[13]);
+            rz = add(rz, m[14]);
+        }
+        else if (kind == TRANSFORM_NORMAL)
+        {
+            Vector scale = reciprocalSqrt(add(add(mul(rx, rx), mul(ry, ry)), mul(rz, rz)));
+            rx = mul(rx, scale);
+            ry = mul(ry, scale);
+            rz = mul(rz, scale);
+        }
+        x = rx;
+        y = ry;
+        z = rz;
+    }
+#endif
 
-    r.data[0] = v1.data[0] + v2.data[0];
-    r.data[1] = v1.data[1] + v2.data[1];
+    /// Transform vertices [begin, end) of arrays storing x, y, z one after another
+    void transformRange(const Vuforia::Matrix44F& matrix, const float* vertices, float* result,
+                        size_t begin, size_t end, TransformKind kind)
+    {
+        size_t i = begin;
+#if defined(MATH_CORE_SIMD)
+        Vector m[16];
+        for (int element = 0; element < 16; ++element)
+        {
+            m[element] = splat(matrix.data[element]);
+        }
+        for (; i + 4 <= end; i += 4)
+        {
+            Vector x, y, z;
+            load3(vertices + i * 3, x, y, z);
+            transformVertices(m, x, y, z, kind);
+            store3(result + i * 3, x, y, z);
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            const float* v = vertices + i * 3;
+            float* r = result + i * 3;
+            transformVertex(matrix.data, v[0], v[1], v[2], kind, r[0], r[1], r[2]);
+        }
+    }
 
-    return r;
-}
+    /// Transform vertices [begin, end) of separate x, y and z arrays
+    void transformRangeSoA(const Vuforia::Matrix44F& matrix, const float* x, const float* y, const float* z,
+                           float* resultX, float* resultY, float* resultZ,
+                           size_t begin, size_t end, TransformKind kind)
+    {
+        size_t i = begin;
+#if defined(MATH_CORE_SIMD)
+        Vector m[16];
+        for (int element = 0; element < 16; ++element)
+        {
+            m[element] = splat(matrix.data[element]);
+        }
+        for (; i + 4 <= end; i += 4)
+        {
+            Vector vx = load(x + i);
+            Vector vy = load(y + i);
+            Vector vz = load(z + i);
+            transformVertices(m, vx, vy, vz, kind);
+            store(resultX + i, vx);
+            store(resultY + i, vy);
+            store(resultZ + i, vz);
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            transformVertex(matrix.data, x[i], y[i], z[i], kind, resultX[i], resultY[i], resultZ[i]);
+        }
+    }
 
-Vuforia::Vec2F
-MathUtils::Vec2FSub(const Vuforia::Vec2F& v1, const Vuforia::Vec2F& v2)
-{
-    Vuforia::Vec2F r;
+    /// Call task(begin, end) on ranges covering [0, count), split between up to threadCount threads
+    /*
+    * The calling thread takes the first range. Ranges start on multiples of 4
+    * vertices so only the last one has vertices left for the scalar loop.
+    */
+    template <typename Task>
+    void splitBetweenThreads(size_t count, unsigned int threadCount, Task task)
+    {
+        size_t rangeCount = std::min<size_t>(std::max(threadCount, 1u), count / MIN_VERTICES_PER_THREAD);
+        if (rangeCount <= 1)
+        {
+            task(0, count);
+            return;
+        }
 
-    r.data[0] = v1.data[0] - v2.data[0];
-    r.data[1] = v1.data[1] - v2.data[1];
+        size_t rangeSize = (count / rangeCount + 3) & ~size_t(3);
+        std::vector<std::thread> threads;
+        for (size_t begin = rangeSize; begin < count; begin += rangeSize)
+        {
+            threads.emplace_back(task, begin, std::min(begin + rangeSize, count));
+        }
+        task(0, rangeSize);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
 
-    return r;
-}
+    /// Inverse transpose of the rotation and scale of m, which keeps normals perpendicular to the surface
+    Vuforia::Matrix44F normalMatrix(const Vuforia::Matrix44F& m)
+    {
+        // The columns of the inverse transpose are the cross products of
+        // the other two columns divided by the determinant
+        Vuforia::Vec3F c0(m.data[0], m.data[1], m.data[2]);
+        Vuforia::Vec3F c1(m.data[4], m.data[5], m.data[6]);
+        Vuforia::Vec3F c2(m.data[8], m.data[9], m.data[10]);
+        Vuforia::Vec3F n0 = MathUtils::Vec3FCross(c1, c2);
+        Vuforia::Vec3F n1 = MathUtils::Vec3FCross(c2, c0);
+        Vuforia::Vec3F n2 = MathUtils::Vec3FCross(c0, c1);
+        float determinant = MathUtils::Vec3FDot(c0, n0);
+        // The normals are normalized, only a mirroring sign matters for a singular matrix
+        float scale = determinant != 0.0f ? 1.0f / determinant : 1.0f;
+
+        Vuforia::Matrix44F r = MathUtils::Matrix44FIdentity();
+        for (int i = 0; i < 3; i++)
+        {
+            r.data[i] = n0.data[i] * scale;
+            r.data[4 + i] = n1.data[i] * scale;
+            r.data[8 + i] = n2.data[i] * scale;
+        }
+        return r;
+    }
 
-float
-MathUtils::Vec2FDist(const Vuforia::Vec2F& v1, const Vuforia::Vec2F& v2)
-{
-    float dx = v1.data[0] - v2.data[0];
-    float dy = v1.data[1] - v2.data[1];
+    Math::Quat loadQuaternion(const float* data)
+    {
+        return Math::Quat(data[0], data[1], data[2], data[3]);
+    }
 
-    return sqrtf(dx * dx + dy * dy);
-}
+    void storeQuaternion(float* data, const Math::Quat& q)
+    {
+        std::copy(q.data, q.data + 4, data);
+    }
 
-Vuforia::Vec2F
-MathUtils::Vec2FScale(const Vuforia::Vec2F& v, float s)
-{
-    Vuforia::Vec2F r;
+#if defined(MATH_CORE_SIMD)
+    /// Load 4 quaternions stride floats apart as a vector per component
+    inline void loadQuaternions(const float* data, size_t stride, Vector q[4])
+    {
+        for (size_t i = 0; i < 4; ++i)
+        {
+            q[i] = load(data + i * stride);
+        }
+        transpose(q);
+    }
 
-    r.data[0] = v.data[0] * s;
-    r.data[1] = v.data[1] * s;
+    inline void storeQuaternions(float* data, size_t stride, Vector q[4])
+    {
+        transpose(q);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            store(data + i * stride, q[i]);
+        }
+    }
 
-    return r;
-}
+    /// Math::dot of 4 pairs of quaternions
+    inline Vector quaternionDot(const Vector a[4], const Vector b[4])
+    {
+        return add(add(add(mul(a[0], b[0]), mul(a[1], b[1])), mul(a[2], b[2])), mul(a[3], b[3]));
+    }
 
-float
-MathUtils::Vec2FNorm(const Vuforia::Vec2F& v)
-{
-    return sqrtf(v.data[0] * v.data[0] + v.data[1] * v.data[1]);
+    /// Math::normalize(a * weight0 + b * weight1) of 4 pairs of quaternions, result may be a or b
+    inline void blendQuaternions(const Vector a[4], const Vector b[4], Vector weight0, Vector weight1, Vector result[4])
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            result[i] = add(mul(a[i], weight0), mul(b[i], weight1));
+        }
+        Vector scale = reciprocalSqrt(quaternionDot(result, result));
+        for (int i = 0; i < 4; ++i)
+        {
+            result[i] = mul(result[i], scale);
+        }
+    }
+#endif
 }
 
 
@@ -103,130 +351,7 @@ MathUtils::printVector(const Vuforia::Vec2F& v)
 
 
 Vuforia::Vec3F
-MathUtils::Vec3FZero()
-{
-    Vuforia::Vec3F v;
-
-    v.data[0] = 0.0f;
-    v.data[1] = 0.0f;
-    v.data[2] = 0.0f;
-
-    return v;
-}
-
-
-Vuforia::Vec3F
-MathUtils::Vec3FUnit()
-{
-    Vuforia::Vec3F v;
-
-    v.data[0] = 1.0f;
-    v.data[1] = 1.0f;
-    v.data[2] = 1.0f;
-
-    return v;
-}
-
-Vuforia::Vec3F
-MathUtils::Vec3FOpposite(const Vuforia::Vec3F& v)
-{
-    Vuforia::Vec3F r;
-
-    r.data[0] = -v.data[0];
-    r.data[1] = -v.data[1];
-    r.data[2] = -v.data[2];
-
-    return r;
-}
-
-
-Vuforia::Vec3F
-MathUtils::Vec3FAdd(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
-{
-    Vuforia::Vec3F r;
-
-    r.data[0] = v1.data[0] + v2.data[0];
-    r.data[1] = v1.data[1] + v2.data[1];
-    r.data[2] = v1.data[2] + v2.data[2];
-
-    return r;
-}
-
-
-Vuforia::Vec3F
-MathUtils::Vec3FSub(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
-{
-    Vuforia::Vec3F r;
-
-    r.data[0] = v1.data[0] - v2.data[0];
-    r.data[1] = v1.data[1] - v2.data[1];
-    r.data[2] = v1.data[2] - v2.data[2];
-
-    return r;
-}
-
-float
-MathUtils::Vec3FDist(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
-{
-    float dx = v1.data[0] - v2.data[0];
-    float dy = v1.data[1] - v2.data[1];
-    float dz = v1.data[2] - v2.data[2];
-
-    return sqrtf(dx * dx + dy * dy + dz* dz);
-}
-
-Vuforia::Vec3F
-MathUtils::Vec3FScale(const Vuforia::Vec3F& v, float s)
-{
-    Vuforia::Vec3F r;
-
-    r.data[0] = v.data[0] * s;
-    r.data[1] = v.data[1] * s;
-    r.data[2] = v.data[2] * s;
-
-    return r;
-}
-
-
-float
-MathUtils::Vec3FDot(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
-{
-    return v1.data[0] * v2.data[0] + v1.data[1] * v2.data[1] + v1.data[2] * v2.data[2];
-}
-
-
-Vuforia::Vec3F
-MathUtils::Vec3FCross(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
-{
-    Vuforia::Vec3F r;
-
-    r.data[0] = v1.data[1] * v2.data[2] - v1.data[2] * v2.data[1];
-    r.data[1] = v1.data[2] * v2.data[0] - v1.data[0] * v2.data[2];
-    r.data[2] = v1.data[0] * v2.data[1] - v1.data[1] * v2.data[0];
-
-    return r;
-}
-
-
-Vuforia::Vec3F
-MathUtils::Vec3FNormalize(const Vuforia::Vec3F& v)
-{
-    Vuforia::Vec3F r;
-
-    float length = sqrtf(v.data[0] * v.data[0] + v.data[1] * v.data[1] + v.data[2] * v.data[2]);
-    if (length != 0.0f)
-        length = 1.0f / length;
-
-    r.data[0] = v.data[0] * length;
-    r.data[1] = v.data[1] * length;
-    r.data[2] = v.data[2] * length;
-
-    return r;
-}
-
-
-Vuforia::Vec3F
-MathUtils::Vec3FTransform(const Vuforia::Matrix44F& m, const Vuforia::Vec3F& v)
+MathUtils::Vec3FTransformScalar(const Vuforia::Matrix44F& m, const Vuforia::Vec3F& v)
 {
     Vuforia::Vec3F r;
 
@@ -279,23 +404,6 @@ MathUtils::Vec3FTransformR(const Vuforia::Vec3F& v, const Vuforia::Matrix44F& m)
     return r;
 }
 
-Vuforia::Vec3F
-MathUtils::Vec3FTransformNormal(const Vuforia::Matrix44F& m, const Vuforia::Vec3F& v)
-{
-    Vuforia::Vec3F r;
-
-    r.data[0] = m.data[0] * v.data[0] +
-        m.data[4] * v.data[1] +
-        m.data[8] * v.data[2];
-    r.data[1] = m.data[1] * v.data[0] +
-        m.data[5] * v.data[1] +
-        m.data[9] * v.data[2];
-    r.data[2] = m.data[2] * v.data[0] +
-        m.data[6] * v.data[1] +
-        m.data[10] * v.data[2];
-
-    return r;
-}
 
 Vuforia::Vec3F
 MathUtils::Vec3FTransformNormalR(const Vuforia::Vec3F& v, const Vuforia::Matrix44F& m)
@@ -316,61 +424,15 @@ MathUtils::Vec3FTransformNormalR(const Vuforia::Vec3F& v, const Vuforia::Matrix4
 }
 
 
-
-float
-MathUtils::Vec3FNorm(const Vuforia::Vec3F& v)
-{
-    return sqrtf(v.data[0] * v.data[0] + v.data[1] * v.data[1] + v.data[2] * v.data[2]);
-}
-
-
 void
 MathUtils::printVector(const Vuforia::Vec3F& v)
 {
     LOG("Vector = { %7.3f %7.3f %7.3f}\n", v.data[0], v.data[1], v.data[2]);
 }
 
-Vuforia::Vec4F
-MathUtils::Vec4FZero()
-{
-    Vuforia::Vec4F v;
-
-    v.data[0] = 0.0f;
-    v.data[1] = 0.0f;
-    v.data[2] = 0.0f;
-    v.data[3] = 0.0f;
-
-    return v;
-}
-
-Vuforia::Vec4F
-MathUtils::Vec4FUnit()
-{
-    Vuforia::Vec4F v;
-
-    v.data[0] = 1.0f;
-    v.data[1] = 1.0f;
-    v.data[2] = 1.0f;
-    v.data[3] = 1.0f;
-
-    return v;
-}
 
 Vuforia::Vec4F
-MathUtils::Vec4FScale(const Vuforia::Vec4F& v, float s)
-{
-    Vuforia::Vec4F r;
-
-    r.data[0] = v.data[0] * s;
-    r.data[1] = v.data[1] * s;
-    r.data[2] = v.data[2] * s;
-    r.data[3] = v.data[3] * s;
-
-    return r;
-}
-
-Vuforia::Vec4F
-MathUtils::Vec4FTransform(const Vuforia::Matrix44F& m, const Vuforia::Vec4F& v)
+MathUtils::Vec4FTransformScalar(const Vuforia::Matrix44F& m, const Vuforia::Vec4F& v)
 {
     Vuforia::Vec4F r;
 
@@ -441,34 +503,6 @@ MathUtils::Matrix34FIdentity()
 }
 
 
-Vuforia::Matrix44F
-MathUtils::Matrix44FIdentity()
-{
-    Vuforia::Matrix44F r;
-
-    for (int i = 0; i < 16; i++)
-        r.data[i] = 0.0f;
-
-    r.data[0] = 1.0f;
-    r.data[5] = 1.0f;
-    r.data[10] = 1.0f;
-    r.data[15] = 1.0f;
-
-    return r;
-}
-
-
-Vuforia::Matrix44F
-MathUtils::Matrix44FTranspose(const Vuforia::Matrix44F& m)
-{
-    Vuforia::Matrix44F r;
-    for (int i = 0; i < 4; i++)
-        for (int j = 0; j < 4; j++)
-            r.data[i * 4 + j] = m.data[i + 4 * j];
-    return r;
-}
-
-
 float
 MathUtils::Matrix44FDeterminate(const Vuforia::Matrix44F& m)
 {
@@ -566,16 +600,32 @@ MathUtils::Matrix44FInverse(const Vuforia::Matrix44F& m)
 
 
 Vuforia::Matrix44F
-MathUtils::Matrix44FTranslate(const Vuforia::Vec3F& trans, const Vuforia::Matrix44F& m)
+MathUtils::Matrix44FViewFromPose(const Vuforia::Matrix34F& pose)
 {
     Vuforia::Matrix44F r;
 
-    r = copyMatrix(m);
-    translateMatrix(trans, r);
+    // The pose is stored row by row, so its rotation read in order is the
+    // transpose in GL storage, the inverse rotation
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            r.data[i * 4 + j] = pose.data[i * 4 + j];
+        r.data[i * 4 + 3] = 0.0f;
+    }
+
+    // -transpose(R) * t, with t the last column of the pose
+    for (int i = 0; i < 3; i++)
+    {
+        r.data[12 + i] = -(pose.data[i] * pose.data[3] +
+            pose.data[4 + i] * pose.data[7] +
+            pose.data[8 + i] * pose.data[11]);
+    }
+    r.data[15] = 1.0f;
 
     return r;
 }
 
+
 Vuforia::Matrix44F
 MathUtils::Matrix44FRotate(float angle, const Vuforia::Vec3F& axis, const Vuforia::Matrix44F& m)
 {
@@ -587,17 +637,6 @@ MathUtils::Matrix44FRotate(float angle, const Vuforia::Vec3F& axis, const Vufori
     return r;
 }
 
-Vuforia::Matrix44F
-MathUtils::Matrix44FScale(const Vuforia::Vec3F& scale, const Vuforia::Matrix44F& m)
-{
-    Vuforia::Matrix44F r;
-
-    r = copyMatrix(m);
-    scaleMatrix(scale, r);
-
-    return r;
-}
-
 
 Vuforia::Matrix44F
 MathUtils::Matrix44FPerspective(float fovy, float aspectRatio, float nearPlane, float farPlane)
@@ -663,13 +702,6 @@ MathUtils::printMatrix(const Vuforia::Matrix44F& m)
 }
 
 
-Vuforia::Matrix44F
-MathUtils::copyMatrix(const Vuforia::Matrix44F& m)
-{
-    return m;
-}
-
-
 void
 MathUtils::makeRotationMatrix(float angle, const Vuforia::Vec3F& axis, Vuforia::Matrix44F& m)
 {
@@ -710,26 +742,6 @@ MathUtils::makeRotationMatrix(float angle, const Vuforia::Vec3F& axis, Vuforia::
 }
 
 
-void
-MathUtils::makeTranslationMatrix(const Vuforia::Vec3F& trans, Vuforia::Matrix44F& m)
-{
-    m = Matrix44FIdentity();
-
-    m.data[12] = trans.data[0];
-    m.data[13] = trans.data[1];
-    m.data[14] = trans.data[2];
-}
-
-void
-MathUtils::makeScalingMatrix(const Vuforia::Vec3F& scale, Vuforia::Matrix44F& m)
-{
-    m = Matrix44FIdentity();
-
-    m.data[0] = scale.data[0];
-    m.data[5] = scale.data[1];
-    m.data[10] = scale.data[2];
-}
-
 void
 MathUtils::makePerspectiveMatrix(float fovy, float aspectRatio, float nearPlane, float farPlane, Vuforia::Matrix44F& m)
 {
@@ -818,19 +830,6 @@ MathUtils::makeLookAtMatrix(const Vuforia::Vec3F& eye, const Vuforia::Vec3F& cen
 
 }
 
-void
-MathUtils::translateMatrix(const Vuforia::Vec3F& v, Vuforia::Matrix44F& m)
-{
-    // m = m * translate_m
-    m.data[12] += (m.data[0] * v.data[0] + m.data[4] * v.data[1] + m.data[8] * v.data[2]);
-
-    m.data[13] += (m.data[1] * v.data[0] + m.data[5] * v.data[1] + m.data[9] * v.data[2]);
-
-    m.data[14] += (m.data[2] * v.data[0] + m.data[6] * v.data[1] + m.data[10] * v.data[2]);
-
-    m.data[15] += (m.data[3] * v.data[0] + m.data[7] * v.data[1] + m.data[11] * v.data[2]);
-}
-
 
 void
 MathUtils::rotateMatrix(float angle, const Vuforia::Vec3F& axis, Vuforia::Matrix44F& m)
@@ -846,28 +845,7 @@ MathUtils::rotateMatrix(float angle, const Vuforia::Vec3F& axis, Vuforia::Matrix
 
 
 void
-MathUtils::scaleMatrix(const Vuforia::Vec3F& scale, Vuforia::Matrix44F & m)
-{
-    //m =  m * scale_m
-    m.data[0] *= scale.data[0];
-    m.data[1] *= scale.data[0];
-    m.data[2] *= scale.data[0];
-    m.data[3] *= scale.data[0];
-
-    m.data[4] *= scale.data[1];
-    m.data[5] *= scale.data[1];
-    m.data[6] *= scale.data[1];
-    m.data[7] *= scale.data[1];
-
-    m.data[8] *= scale.data[2];
-    m.data[9] *= scale.data[2];
-    m.data[10] *= scale.data[2];
-    m.data[11] *= scale.data[2];
-}
-
-
-void
-MathUtils::multiplyMatrix(const Vuforia::Matrix44F& matrixA, const Vuforia::Matrix44F& matrixB, Vuforia::Matrix44F& matrixC)
+MathUtils::multiplyMatrixScalar(const Vuforia::Matrix44F& matrixA, const Vuforia::Matrix44F& matrixB, Vuforia::Matrix44F& matrixC)
 {
     int i, j, k;
     Vuforia::Matrix44F aTmp;
@@ -889,6 +867,18 @@ MathUtils::multiplyMatrix(const Vuforia::Matrix44F& matrixA, const Vuforia::Matr
 }
 
 
+Vuforia::Matrix44F
+MathUtils::Matrix44FInterpolateRigid(const Vuforia::Matrix44F& m0, const Vuforia::Matrix44F& m1, float t)
+{
+    const Math::Quat q0 = Math::Quat::fromMatrix(m0);
+    const Math::Quat q1 = Math::Quat::fromMatrix(m1);
+    Vuforia::Matrix44F r = Math::slerp(q0, q1, t).toMatrix<Vuforia::Matrix44F>();
+    for (int i = 12; i < 15; i++)
+        r.data[i] = m0.data[i] * (1.0f - t) + m1.data[i] * t;
+    return r;
+}
+
+
 void
 MathUtils::getScissorRect(const Vuforia::Matrix44F& projectionMatrix,
     const Vuforia::Vec4I& viewport,
@@ -936,3 +926,210 @@ MathUtils::convertPoseBetweenWorldAndCamera(const Vuforia::Matrix44F& matrixIn,
     for (int i = 0; i < 16; i++)
         matrixOut.data[i] = tmp.data[i];
 }
+
+
+const char*
+MathUtils::getKernelName()
+{
+#if defined(MATH_CORE_NEON)
+    return "NEON";
+#elif defined(MATH_CORE_SSE)
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
+
+
+void
+MathUtils::transformPoints(const Vuforia::Matrix44F& m, const float* points, float* result,
+                           size_t count, unsigned int threadCount)
+{
+    splitBetweenThreads(count, threadCount, [&](size_t begin, size_t end)
+    {
+        transformRange(m, points, result, begin, end, TRANSFORM_POINT);
+    });
+}
+
+
+void
+MathUtils::transformDirections(const Vuforia::Matrix44F& m, const float* directions, float* result,
+                               size_t count, unsigned int threadCount)
+{
+    splitBetweenThreads(count, threadCount, [&](size_t begin, size_t end)
+    {
+        transformRange(m, directions, result, begin, end, TRANSFORM_DIRECTION);
+    });
+}
+
+
+void
+MathUtils::transformNormals(const Vuforia::Matrix44F& m, const float* normals, float* result,
+                            size_t count, unsigned int threadCount)
+{
+    const Vuforia::Matrix44F n = normalMatrix(m);
+    splitBetweenThreads(count, threadCount, [&](size_t begin, size_t end)
+    {
+        transformRange(n, normals, result, begin, end, TRANSFORM_NORMAL);
+    });
+}
+
+
+void
+MathUtils::transformPointsSoA(const Vuforia::Matrix44F& m, const float* x, const float* y, const float* z,
+                              float* resultX, float* resultY, float* resultZ,
+                              size_t count, unsigned int threadCount)
+{
+    splitBetweenThreads(count, threadCount, [&](size_t begin, size_t end)
+    {
+        transformRangeSoA(m, x, y, z, resultX, resultY, resultZ, begin, end, TRANSFORM_POINT);
+    });
+}
+
+
+void
+MathUtils::transformDirectionsSoA(const Vuforia::Matrix44F& m, const float* x, const float* y, const float* z,
+                                  float* resultX, float* resultY, float* resultZ,
+                                  size_t count, unsigned int threadCount)
+{
+    splitBetweenThreads(count, threadCount, [&](size_t begin, size_t end)
+    {
+        transformRangeSoA(m, x, y, z, resultX, resultY, resultZ, begin, end, TRANSFORM_DIRECTION);
+    });
+}
+
+
+void
+MathUtils::transformNormalsSoA(const Vuforia::Matrix44F& m, const float* x, const float* y, const float* z,
+                               float* resultX, float* resultY, float* resultZ,
+                               size_t count, unsigned int threadCount)
+{
+    const Vuforia::Matrix44F n = normalMatrix(m);
+    splitBetweenThreads(count, threadCount, [&](size_t begin, size_t end)
+    {
+        transformRangeSoA(n, x, y, z, resultX, resultY, resultZ, begin, end, TRANSFORM_NORMAL);
+    });
+}
+
+
+void
+MathUtils::slerpQuaternions(const float* q0, const float* q1, float t, float* result, size_t count)
+{
+    size_t i = 0;
+#if defined(MATH_CORE_SIMD)
+    for (; i + 4 <= count; i += 4)
+    {
+        Vector a[4];
+        Vector b[4];
+        loadQuaternions(q0 + i * 4, 4, a);
+        loadQuaternions(q1 + i * 4, 4, b);
+
+        // The shorter arc, as Math::slerp
+        Vector cosAngle = quaternionDot(a, b);
+        for (int j = 0; j < 4; ++j)
+        {
+            b[j] = negateWhereNegative(b[j], cosAngle);
+        }
+        cosAngle = negateWhereNegative(cosAngle, cosAngle);
+
+        // The weights need acos and sin, they are computed per lane as Math::slerp does
+        float cosines[4];
+        float weights0[4];
+        float weights1[4];
+        store(cosines, cosAngle);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            Math::slerpWeights(cosines[lane], t, weights0[lane], weights1[lane]);
+        }
+        blendQuaternions(a, b, load(weights0), load(weights1), b);
+        storeQuaternions(result + i * 4, 4, b);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        storeQuaternion(result + i * 4, Math::slerp(loadQuaternion(q0 + i * 4), loadQuaternion(q1 + i * 4), t));
+    }
+}
+
+
+void
+MathUtils::nlerpQuaternions(const float* q0, const float* q1, float t, float* result, size_t count)
+{
+    size_t i = 0;
+#if defined(MATH_CORE_SIMD)
+    const Vector weight0 = splat(1.0f - t);
+    const Vector weight1 = splat(t);
+    for (; i + 4 <= count; i += 4)
+    {
+        Vector a[4];
+        Vector b[4];
+        loadQuaternions(q0 + i * 4, 4, a);
+        loadQuaternions(q1 + i * 4, 4, b);
+        Vector cosAngle = quaternionDot(a, b);
+        for (int j = 0; j < 4; ++j)
+        {
+            b[j] = negateWhereNegative(b[j], cosAngle);
+        }
+        blendQuaternions(a, b, weight0, weight1, b);
+        storeQuaternions(result + i * 4, 4, b);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        storeQuaternion(result + i * 4, Math::nlerp(loadQuaternion(q0 + i * 4), loadQuaternion(q1 + i * 4), t));
+    }
+}
+
+
+void
+MathUtils::nlerpDualQuaternions(const float* dq0, const float* dq1, float t, float* result, size_t count)
+{
+    size_t i = 0;
+#if defined(MATH_CORE_SIMD)
+    const Vector weight0 = splat(1.0f - t);
+    const Vector weight1 = splat(t);
+    for (; i + 4 <= count; i += 4)
+    {
+        Vector realA[4];
+        Vector dualA[4];
+        Vector realB[4];
+        Vector dualB[4];
+        loadQuaternions(dq0 + i * 8, 8, realA);
+        loadQuaternions(dq0 + i * 8 + 4, 8, dualA);
+        loadQuaternions(dq1 + i * 8, 8, realB);
+        loadQuaternions(dq1 + i * 8 + 4, 8, dualB);
+
+        Vector cosAngle = quaternionDot(realA, realB);
+        for (int j = 0; j < 4; ++j)
+        {
+            realB[j] = add(mul(realA[j], weight0), mul(negateWhereNegative(realB[j], cosAngle), weight1));
+            dualB[j] = add(mul(dualA[j], weight0), mul(negateWhereNegative(dualB[j], cosAngle), weight1));
+        }
+
+        // Math::normalize, unit real part and the dual part made orthogonal to it
+        Vector scale = reciprocalSqrt(quaternionDot(realB, realB));
+        for (int j = 0; j < 4; ++j)
+        {
+            realB[j] = mul(realB[j], scale);
+            dualB[j] = mul(dualB[j], scale);
+        }
+        Vector realDual = quaternionDot(realB, dualB);
+        for (int j = 0; j < 4; ++j)
+        {
+            dualB[j] = sub(dualB[j], mul(realB[j], realDual));
+        }
+
+        storeQuaternions(result + i * 8, 8, realB);
+        storeQuaternions(result + i * 8 + 4, 8, dualB);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        const float* a = dq0 + i * 8;
+        const float* b = dq1 + i * 8;
+        Math::DualQuat r = Math::nlerp(Math::DualQuat(loadQuaternion(a), loadQuaternion(a + 4)),
+                                       Math::DualQuat(loadQuaternion(b), loadQuaternion(b + 4)), t);
+        storeQuaternion(result + i * 8, r.real);
+        storeQuaternion(result + i * 8 + 4, r.dual);
+    }
+}
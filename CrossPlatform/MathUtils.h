@@ -8,14 +8,35 @@ countries.
 #ifndef __MATH_UTILS_H__
 #define __MATH_UTILS_H__
 
+#include "MathCore.h"
+
 #include <Vuforia/Vectors.h>
 #include <Vuforia/Matrices.h>
 
+#include <cstddef>
+
 /// Utility class for Math operations.
 /**
  *
  * Provide a set of linear algebra operations for Vufoira vector and matrix.
  * All 4x4 matrix transformation consider row storage
+ *
+ * multiplyMatrix, Vec3FTransform and Vec4FTransform, called for every
+ * tracked object each frame, use NEON on ARM and SSE on x86 and otherwise
+ * their scalar versions. Both compute each element with the same
+ * operations in the same order.
+ *
+ * The batch methods transform arrays of vertices, e.g. for CPU skinning
+ * or picking, 4 at a time with the same kernels. Large arrays can be split
+ * between threads.
+ *
+ * The quaternion batch methods interpolate arrays of poses 4 at a time,
+ * e.g. to smooth or predict the poses of many targets.
+ *
+ * The vector and quaternion operations and the simpler matrix methods are
+ * defined below, forwarding to the inline types of MathCore.h, so
+ * existing callers inline them too. New code can use the Math types
+ * directly.
  */
 class MathUtils
 {
@@ -80,6 +101,9 @@ public:
     /// Transform a 3D vector by 4x4 matrix and return the result (pre multiply,  result = m * v)
     static Vuforia::Vec3F Vec3FTransform(const Vuforia::Matrix44F& m, const Vuforia::Vec3F& v);
 
+    /// Vec3FTransform without SIMD, the reference for the vector kernel
+    static Vuforia::Vec3F Vec3FTransformScalar(const Vuforia::Matrix44F& m, const Vuforia::Vec3F& v);
+
     /// Transform a 3D vector by 4x4 matrix and return the result (post multiply, result = v * m)
     static Vuforia::Vec3F Vec3FTransformR(const Vuforia::Vec3F& v, const Vuforia::Matrix44F& m);
 
@@ -107,6 +131,9 @@ public:
     /// Transform a 4D vector by matrix and return the result (pre multiply, result = m * v)
     static Vuforia::Vec4F Vec4FTransform(const Vuforia::Matrix44F& m, const Vuforia::Vec4F& v);
 
+    /// Vec4FTransform without SIMD, the reference for the vector kernel
+    static Vuforia::Vec4F Vec4FTransformScalar(const Vuforia::Matrix44F& m, const Vuforia::Vec4F& v);
+
     /// Transform a 4D vector by matrix and return the result (post multiply, result = v * m)
     static Vuforia::Vec4F Vec4FTransformR(const Vuforia::Vec4F& v, const Vuforia::Matrix44F& m);
 
@@ -130,6 +157,13 @@ public:
     /// Computer the inverse of the matrix and return the result ( result = inverse(m) )
     static Vuforia::Matrix44F Matrix44FInverse(const Vuforia::Matrix44F& m);
 
+    /// Compute the inverse of a rotation and translation matrix and return the result ( result = transpose(Matrix44FInverse(m)) )
+    /// The rotation is transposed rather than inverted, m must have no scale, shear or projection
+    static Vuforia::Matrix44F Matrix44FRigidInverse(const Vuforia::Matrix44F& m);
+
+    /// Create the view matrix of a camera from its pose and return the result ( result = Matrix44FRigidInverse(convertPose2GLMatrix(pose)) )
+    static Vuforia::Matrix44F Matrix44FViewFromPose(const Vuforia::Matrix34F& pose);
+
     /// Translate the matrix m by a vector v and return the result (post-multiply, result = M * T(trans) )
     static Vuforia::Matrix44F Matrix44FTranslate(const Vuforia::Vec3F& trans, const Vuforia::Matrix44F& m);
 
@@ -201,8 +235,12 @@ public:
     static void scaleMatrix(const Vuforia::Vec3F& scale, Vuforia::Matrix44F& m);
 
     /// Multiply the two matrices A and B and writes the result to C (C = mA*mB)
+    /// mC may be the same matrix as mA or mB
     static void multiplyMatrix(const Vuforia::Matrix44F& mA, const Vuforia::Matrix44F& mB, Vuforia::Matrix44F& mC);
 
+    /// multiplyMatrix without SIMD, the reference for the vector kernel
+    static void multiplyMatrixScalar(const Vuforia::Matrix44F& mA, const Vuforia::Matrix44F& mB, Vuforia::Matrix44F& mC);
+
     /// Use the matrix to project the extents of the video background to the viewport
     /// This will generate normalized coordinates (i.e. full viewport has -1,+1 range)
     /// to create a rectangle that can be used to set a scissor on the video background
@@ -212,7 +250,220 @@ public:
 
     /// Convert world pose matrix to camera pose matrix or camera pose matrix to world pose matrix
     static void convertPoseBetweenWorldAndCamera(const Vuforia::Matrix44F& matrixIn, Vuforia::Matrix44F& matrixOut);
+
+    // BATCH METHODS (arrays of count vertices, the result may be the input but not otherwise overlap it)
+
+    /// Transform 3D points by a 4x4 matrix (pre multiply, result[i] = m * points[i], w = 1)
+    /// The points are stored x, y, z one after another. Arrays of more than
+    /// 16384 points per thread are split between up to threadCount threads.
+    static void transformPoints(const Vuforia::Matrix44F& m, const float* points, float* result,
+                                size_t count, unsigned int threadCount = 1);
+
+    /// Transform 3D directions by the rotation and scale of a 4x4 matrix (pre multiply, result[i] = m * directions[i], w = 0)
+    static void transformDirections(const Vuforia::Matrix44F& m, const float* directions, float* result,
+                                    size_t count, unsigned int threadCount = 1);
+
+    /// Transform 3D normals by the inverse transpose of the rotation and scale of a 4x4 matrix and normalize them
+    /// Normals stay perpendicular to the transformed surface under non-uniform scale.
+    static void transformNormals(const Vuforia::Matrix44F& m, const float* normals, float* result,
+                                 size_t count, unsigned int threadCount = 1);
+
+    /// transformPoints for vertices stored as separate x, y and z arrays
+    static void transformPointsSoA(const Vuforia::Matrix44F& m, const float* x, const float* y, const float* z,
+                                   float* resultX, float* resultY, float* resultZ,
+                                   size_t count, unsigned int threadCount = 1);
+
+    /// transformDirections for vertices stored as separate x, y and z arrays
+    static void transformDirectionsSoA(const Vuforia::Matrix44F& m, const float* x, const float* y, const float* z,
+                                       float* resultX, float* resultY, float* resultZ,
+                                       size_t count, unsigned int threadCount = 1);
+
+    /// transformNormals for vertices stored as separate x, y and z arrays
+    static void transformNormalsSoA(const Vuforia::Matrix44F& m, const float* x, const float* y, const float* z,
+                                    float* resultX, float* resultY, float* resultZ,
+                                    size_t count, unsigned int threadCount = 1);
+
+    // QUATERNION METHODS (unit quaternions stored x, y, z, w in a Vec4F or 4 floats, see Math::Quat)
+
+    /// Compute the rotation quaternion of the rotation part of a 4x4 matrix and return the result
+    static Vuforia::Vec4F QuaternionFromMatrix(const Vuforia::Matrix44F& m);
+
+    /// Create the rotation matrix of a quaternion and return the result
+    static Vuforia::Matrix44F Matrix44FFromQuaternion(const Vuforia::Vec4F& q);
+
+    /// Interpolate two rotations along the shorter arc at constant speed and return the result
+    /// t outside [0, 1] extrapolates, e.g. to predict a pose
+    static Vuforia::Vec4F QuaternionSlerp(const Vuforia::Vec4F& q0, const Vuforia::Vec4F& q1, float t);
+
+    /// Interpolate two rotations linearly and normalize the result, cheaper than slerp but not at constant speed
+    static Vuforia::Vec4F QuaternionNlerp(const Vuforia::Vec4F& q0, const Vuforia::Vec4F& q1, float t);
+
+    /// Interpolate two rotation and translation matrices and return the result
+    /// The rotation is slerped and the translation interpolated linearly, t outside [0, 1] extrapolates.
+    static Vuforia::Matrix44F Matrix44FInterpolateRigid(const Vuforia::Matrix44F& m0, const Vuforia::Matrix44F& m1, float t);
+
+    /// QuaternionSlerp of count pairs of quaternions at the same t, result may be q0 or q1
+    static void slerpQuaternions(const float* q0, const float* q1, float t, float* result, size_t count);
+
+    /// QuaternionNlerp of count pairs of quaternions at the same t, result may be q0 or q1
+    static void nlerpQuaternions(const float* q0, const float* q1, float t, float* result, size_t count);
+
+    /// Math::nlerp of count pairs of dual quaternions of 8 floats at the same t, result may be dq0 or dq1
+    static void nlerpDualQuaternions(const float* dq0, const float* dq1, float t, float* result, size_t count);
+
+    /// Instruction set of the vector kernels, e.g. for benchmark output
+    static const char* getKernelName();
 };
 
 
+// Inline forwards to MathCore.h
+
+inline Vuforia::Vec2F MathUtils::Vec2FZero() { return Math::Vec2(); }
+
+inline Vuforia::Vec2F MathUtils::Vec2FUnit() { return Math::Vec2(1.0f, 1.0f); }
+
+inline Vuforia::Vec2F MathUtils::Vec2FOpposite(const Vuforia::Vec2F& v) { return -Math::Vec2(v); }
+
+inline Vuforia::Vec2F MathUtils::Vec2FAdd(const Vuforia::Vec2F& v1, const Vuforia::Vec2F& v2)
+{
+    return Math::Vec2(v1) + Math::Vec2(v2);
+}
+
+inline Vuforia::Vec2F MathUtils::Vec2FSub(const Vuforia::Vec2F& v1, const Vuforia::Vec2F& v2)
+{
+    return Math::Vec2(v1) - Math::Vec2(v2);
+}
+
+inline float MathUtils::Vec2FDist(const Vuforia::Vec2F& v1, const Vuforia::Vec2F& v2)
+{
+    return Math::distance(Math::Vec2(v1), Math::Vec2(v2));
+}
+
+inline Vuforia::Vec2F MathUtils::Vec2FScale(const Vuforia::Vec2F& v, float s) { return Math::Vec2(v) * s; }
+
+inline float MathUtils::Vec2FNorm(const Vuforia::Vec2F& v) { return Math::length(Math::Vec2(v)); }
+
+inline Vuforia::Vec3F MathUtils::Vec3FZero() { return Math::Vec3(); }
+
+inline Vuforia::Vec3F MathUtils::Vec3FUnit() { return Math::Vec3(1.0f, 1.0f, 1.0f); }
+
+inline Vuforia::Vec3F MathUtils::Vec3FOpposite(const Vuforia::Vec3F& v) { return -Math::Vec3(v); }
+
+inline Vuforia::Vec3F MathUtils::Vec3FAdd(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
+{
+    return Math::Vec3(v1) + Math::Vec3(v2);
+}
+
+inline Vuforia::Vec3F MathUtils::Vec3FSub(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
+{
+    return Math::Vec3(v1) - Math::Vec3(v2);
+}
+
+inline float MathUtils::Vec3FDist(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
+{
+    return Math::distance(Math::Vec3(v1), Math::Vec3(v2));
+}
+
+inline Vuforia::Vec3F MathUtils::Vec3FScale(const Vuforia::Vec3F& v, float s) { return Math::Vec3(v) * s; }
+
+inline float MathUtils::Vec3FDot(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
+{
+    return Math::dot(Math::Vec3(v1), Math::Vec3(v2));
+}
+
+inline Vuforia::Vec3F MathUtils::Vec3FCross(const Vuforia::Vec3F& v1, const Vuforia::Vec3F& v2)
+{
+    return Math::cross(Math::Vec3(v1), Math::Vec3(v2));
+}
+
+inline Vuforia::Vec3F MathUtils::Vec3FNormalize(const Vuforia::Vec3F& v) { return Math::normalize(Math::Vec3(v)); }
+
+inline Vuforia::Vec3F MathUtils::Vec3FTransform(const Vuforia::Matrix44F& m, const Vuforia::Vec3F& v)
+{
+    return Math::transformPoint(m, v);
+}
+
+inline Vuforia::Vec3F MathUtils::Vec3FTransformNormal(const Vuforia::Matrix44F& m, const Vuforia::Vec3F& v)
+{
+    return Math::transformDirection(m, v);
+}
+
+inline float MathUtils::Vec3FNorm(const Vuforia::Vec3F& v) { return Math::length(Math::Vec3(v)); }
+
+inline Vuforia::Vec4F MathUtils::Vec4FZero() { return Math::Vec4(); }
+
+inline Vuforia::Vec4F MathUtils::Vec4FUnit() { return Math::Vec4(1.0f, 1.0f, 1.0f, 1.0f); }
+
+inline Vuforia::Vec4F MathUtils::Vec4FScale(const Vuforia::Vec4F& v, float s) { return Math::Vec4(v) * s; }
+
+inline Vuforia::Vec4F MathUtils::Vec4FTransform(const Vuforia::Matrix44F& m, const Vuforia::Vec4F& v)
+{
+    return Math::transform(m, Math::Vec4(v));
+}
+
+inline Vuforia::Matrix44F MathUtils::Matrix44FIdentity() { return Math::identity<Vuforia::Matrix44F>(); }
+
+inline Vuforia::Matrix44F MathUtils::Matrix44FTranspose(const Vuforia::Matrix44F& m)
+{
+    return Math::transposed(m);
+}
+
+inline Vuforia::Matrix44F MathUtils::Matrix44FRigidInverse(const Vuforia::Matrix44F& m)
+{
+    return Math::rigidInverse(m);
+}
+
+inline Vuforia::Matrix44F MathUtils::Matrix44FTranslate(const Vuforia::Vec3F& trans, const Vuforia::Matrix44F& m)
+{
+    return Math::translated(m, trans);
+}
+
+inline Vuforia::Matrix44F MathUtils::Matrix44FScale(const Vuforia::Vec3F& scale, const Vuforia::Matrix44F& m)
+{
+    return Math::scaled(m, scale);
+}
+
+inline Vuforia::Vec4F MathUtils::QuaternionFromMatrix(const Vuforia::Matrix44F& m) { return Math::Quat::fromMatrix(m); }
+
+inline Vuforia::Matrix44F MathUtils::Matrix44FFromQuaternion(const Vuforia::Vec4F& q) { return Math::Quat(q).toMatrix<Vuforia::Matrix44F>(); }
+
+inline Vuforia::Vec4F MathUtils::QuaternionSlerp(const Vuforia::Vec4F& q0, const Vuforia::Vec4F& q1, float t)
+{
+    return Math::slerp(q0, q1, t);
+}
+
+inline Vuforia::Vec4F MathUtils::QuaternionNlerp(const Vuforia::Vec4F& q0, const Vuforia::Vec4F& q1, float t)
+{
+    return Math::nlerp(q0, q1, t);
+}
+
+inline Vuforia::Matrix44F MathUtils::copyMatrix(const Vuforia::Matrix44F& m) { return m; }
+
+inline void MathUtils::multiplyMatrix(const Vuforia::Matrix44F& mA, const Vuforia::Matrix44F& mB, Vuforia::Matrix44F& mC)
+{
+    // The product is complete before mC is written, so it may be mA or mB
+    mC = Math::multiply(mA, mB);
+}
+
+inline void MathUtils::makeTranslationMatrix(const Vuforia::Vec3F& v, Vuforia::Matrix44F& m)
+{
+    m = Math::translation<Vuforia::Matrix44F>(v);
+}
+
+inline void MathUtils::makeScalingMatrix(const Vuforia::Vec3F& scale, Vuforia::Matrix44F& m)
+{
+    m = Math::scaling<Vuforia::Matrix44F>(scale);
+}
+
+inline void MathUtils::translateMatrix(const Vuforia::Vec3F& v, Vuforia::Matrix44F& m)
+{
+    m = Math::translated(m, v);
+}
+
+inline void MathUtils::scaleMatrix(const Vuforia::Vec3F& scale, Vuforia::Matrix44F& m)
+{
+    m = Math::scaled(m, scale);
+}
+
+
 #endif  // __MATH_UTILS_H__
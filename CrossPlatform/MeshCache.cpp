@@ -0,0 +1,278 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "MeshCache.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <unordered_map>
+
+
+namespace
+{
+    /// Round size up to the next multiple of 4 bytes
+    constexpr size_t align4(size_t size) { return (size + 3) & ~size_t(3); }
+
+    /// Largest of count indices of type Index, the buffer may be unaligned
+    template <typename Index>
+    uint32_t getMaxIndex(const char* indices, uint32_t count)
+    {
+        uint32_t maxIndex = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Index index;
+            memcpy(&index, indices + size_t(i) * sizeof(Index), sizeof(Index));
+            maxIndex = std::max<uint32_t>(maxIndex, index);
+        }
+        return maxIndex;
+    }
+
+
+    /// Hash for OBJ face corners, used to weld identical vertices
+    struct IndexHash
+    {
+        size_t operator()(const tinyobj::index_t& idx) const
+        {
+            size_t h = static_cast<uint32_t>(idx.vertex_index);
+            h = h * 31 + static_cast<uint32_t>(idx.texcoord_index);
+            h = h * 31 + static_cast<uint32_t>(idx.normal_index);
+            return h;
+        }
+    };
+
+    struct IndexEqual
+    {
+        bool operator()(const tinyobj::index_t& a, const tinyobj::index_t& b) const
+        {
+            return a.vertex_index == b.vertex_index &&
+                   a.texcoord_index == b.texcoord_index &&
+                   a.normal_index == b.normal_index;
+        }
+    };
+}
+
+
+bool
+MeshCache::buildFromObj(const tinyobj::attrib_t& attrib,
+                        const std::vector<tinyobj::shape_t>& shapes, Mesh& mesh)
+{
+    mesh.vertices.clear();
+    mesh.indices.clear();
+
+    // Maps each distinct face corner to its vertex in the mesh
+    size_t cornerCount = 0;
+    for (const auto& shape : shapes)
+    {
+        cornerCount += shape.mesh.indices.size();
+    }
+    std::unordered_map<tinyobj::index_t, uint32_t, IndexHash, IndexEqual> vertexMap;
+    vertexMap.reserve(cornerCount);
+    mesh.indices.reserve(cornerCount);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        mesh.boundsMin[i] = FLT_MAX;
+        mesh.boundsMax[i] = -FLT_MAX;
+    }
+
+    // Loop over shapes
+    // s is the index into the shapes vector
+    // f is the index of the current face
+    // v is the index of the current vertex
+    for (size_t s = 0; s < shapes.size(); ++s)
+    {
+        const tinyobj::mesh_t& shapeMesh = shapes[s].mesh;
+
+        // Loop over faces(polygon)
+        size_t indexOffset = 0;
+        for (size_t f = 0; f < shapeMesh.num_face_vertices.size(); ++f)
+        {
+            size_t fv = shapeMesh.num_face_vertices[f];
+            if (fv != 3)
+            {
+                LOG("Error: mesh cache only supports triangulated models");
+                return false;
+            }
+
+            // Loop over vertices in the face.
+            for (size_t v = 0; v < fv; ++v)
+            {
+                // access to vertex
+                tinyobj::index_t idx = shapeMesh.indices[indexOffset + v];
+                if (idx.vertex_index < 0 || size_t(idx.vertex_index) * 3 + 2 >= attrib.vertices.size())
+                {
+                    LOG("Error: invalid vertex index %d in model", idx.vertex_index);
+                    return false;
+                }
+                if (idx.texcoord_index >= 0 && size_t(idx.texcoord_index) * 2 + 1 >= attrib.texcoords.size())
+                {
+                    LOG("Error: invalid texture coordinate index %d in model", idx.texcoord_index);
+                    return false;
+                }
+                if (idx.normal_index >= 0 && size_t(idx.normal_index) * 3 + 2 >= attrib.normals.size())
+                {
+                    LOG("Error: invalid normal index %d in model", idx.normal_index);
+                    return false;
+                }
+
+                // Reuse the vertex if this combination of indices has been seen before
+                auto inserted = vertexMap.emplace(idx, mesh.vertexCount());
+                mesh.indices.push_back(inserted.first->second);
+                if (!inserted.second)
+                {
+                    continue;
+                }
+
+                for (int i = 0; i < 3; ++i)
+                {
+                    float position = attrib.vertices[3 * idx.vertex_index + i];
+                    mesh.vertices.push_back(position);
+                    mesh.boundsMin[i] = std::min(mesh.boundsMin[i], position);
+                    mesh.boundsMax[i] = std::max(mesh.boundsMax[i], position);
+                }
+
+                // The model may not have texture coordinates for every vertex
+                // If a texture coordinate is missing we just set it to 0,0
+                // This may not be suitable for rendering some OBJ model files
+                if (idx.texcoord_index < 0)
+                {
+                    mesh.vertices.push_back(0.f);
+                    mesh.vertices.push_back(0.f);
+                }
+                else
+                {
+                    mesh.vertices.push_back(attrib.texcoords[2 * idx.texcoord_index + 0]);
+                    mesh.vertices.push_back(attrib.texcoords[2 * idx.texcoord_index + 1]);
+                }
+
+                // Missing normals are written as zero vectors
+                if (idx.normal_index < 0)
+                {
+                    mesh.vertices.push_back(0.f);
+                    mesh.vertices.push_back(0.f);
+                    mesh.vertices.push_back(0.f);
+                }
+                else
+                {
+                    mesh.vertices.push_back(attrib.normals[3 * idx.normal_index + 0]);
+                    mesh.vertices.push_back(attrib.normals[3 * idx.normal_index + 1]);
+                    mesh.vertices.push_back(attrib.normals[3 * idx.normal_index + 2]);
+                }
+            }
+            indexOffset += fv;
+        }
+    }
+
+    if (mesh.indices.empty())
+    {
+        LOG("Error: model contains no faces");
+        return false;
+    }
+
+    return true;
+}
+
+
+void
+MeshCache::serialize(const Mesh& mesh, std::vector<char>& data)
+{
+    Header header {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertexCount = mesh.vertexCount();
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    // Use 16-bit indices whenever every index fits
+    header.indexSize = header.vertexCount <= 0x10000 ? 2 : 4;
+    header.vertexOffset = static_cast<uint32_t>(align4(sizeof(Header)));
+    header.indexOffset = static_cast<uint32_t>(align4(header.vertexOffset + header.vertexCount * VERTEX_STRIDE));
+    std::copy(mesh.boundsMin, mesh.boundsMin + 3, header.boundsMin);
+    std::copy(mesh.boundsMax, mesh.boundsMax + 3, header.boundsMax);
+
+    size_t indexBytes = size_t(header.indexCount) * header.indexSize;
+    data.assign(align4(header.indexOffset + indexBytes), 0);
+
+    memcpy(data.data(), &header, sizeof(Header));
+    memcpy(data.data() + header.vertexOffset, mesh.vertices.data(), header.vertexCount * VERTEX_STRIDE);
+
+    if (header.indexSize == 2)
+    {
+        auto indices = reinterpret_cast<uint16_t*>(data.data() + header.indexOffset);
+        for (size_t i = 0; i < mesh.indices.size(); ++i)
+        {
+            indices[i] = static_cast<uint16_t>(mesh.indices[i]);
+        }
+    }
+    else
+    {
+        memcpy(data.data() + header.indexOffset, mesh.indices.data(), indexBytes);
+    }
+}
+
+
+bool
+MeshCache::parse(const void* data, size_t size, View& view)
+{
+    if (data == nullptr || size < sizeof(Header))
+    {
+        LOG("Error: mesh cache is too small");
+        return false;
+    }
+
+    // Copy the header as the buffer is not guaranteed to be aligned
+    Header header;
+    memcpy(&header, data, sizeof(Header));
+
+    if (header.magic != MAGIC)
+    {
+        LOG("Error: data is not a mesh cache");
+        return false;
+    }
+    if (header.version != VERSION)
+    {
+        LOG("Error: mesh cache version %u is not supported (expected %u)", header.version, VERSION);
+        return false;
+    }
+    if (header.indexSize != 2 && header.indexSize != 4)
+    {
+        LOG("Error: mesh cache has invalid index size %u", header.indexSize);
+        return false;
+    }
+
+    // Compared in 64 bits, the products can't wrap around on 32-bit devices
+    uint64_t vertexBytes = uint64_t(header.vertexCount) * VERTEX_STRIDE;
+    uint64_t indexBytes = uint64_t(header.indexCount) * header.indexSize;
+    if (header.vertexOffset < sizeof(Header) ||
+        header.vertexOffset + vertexBytes > size ||
+        header.indexOffset + indexBytes > size)
+    {
+        LOG("Error: mesh cache is truncated");
+        return false;
+    }
+
+    // Checked once here so draws never read past the vertex buffer
+    auto bytes = static_cast<const char*>(data);
+    if (header.indexCount > 0)
+    {
+        uint32_t maxIndex = header.indexSize == 2 ? getMaxIndex<uint16_t>(bytes + header.indexOffset, header.indexCount)
+                                                  : getMaxIndex<uint32_t>(bytes + header.indexOffset, header.indexCount);
+        if (maxIndex >= header.vertexCount)
+        {
+            LOG("Error: mesh cache index %u is out of range for %u vertices", maxIndex, header.vertexCount);
+            return false;
+        }
+    }
+
+    view.header = header;
+    view.vertices = bytes + header.vertexOffset;
+    view.vertexBytes = static_cast<size_t>(vertexBytes);
+    view.indices = bytes + header.indexOffset;
+    view.indexBytes = static_cast<size_t>(indexBytes);
+
+    return true;
+}
@@ -0,0 +1,105 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __MESH_CACHE_H__
+#define __MESH_CACHE_H__
+
+#include <tiny_obj_loader.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Binary mesh format used to avoid parsing OBJ text at runtime.
+/**
+ * A mesh cache file is laid out so that it can be used in place from a
+ * memory mapped buffer:
+ *
+ *     Header | vertex data | index data
+ *
+ * Vertices are interleaved position (3 floats), texture coordinate (2 floats)
+ * and normal (3 floats). Indices are 16-bit when the vertex count allows it,
+ * 32-bit otherwise. All values are little-endian and every section starts on
+ * a 4-byte boundary.
+ *
+ * Mesh cache files are created offline with the ObjToMesh tool, which uses
+ * the same OBJ conversion as the runtime fallback path.
+ */
+class MeshCache
+{
+public:
+    /// File identifier, "VMSH" when read as bytes
+    static constexpr uint32_t MAGIC = 0x48534D56;
+    /// Increment whenever the layout of the file changes
+    static constexpr uint32_t VERSION = 1;
+
+    /// Number of floats per interleaved vertex
+    static constexpr uint32_t VERTEX_FLOATS = 8;
+    /// Size in bytes of one interleaved vertex
+    static constexpr uint32_t VERTEX_STRIDE = VERTEX_FLOATS * sizeof(float);
+    /// Byte offsets of the attributes within a vertex
+    static constexpr uint32_t POSITION_OFFSET = 0;
+    static constexpr uint32_t TEXCOORD_OFFSET = 3 * sizeof(float);
+    static constexpr uint32_t NORMAL_OFFSET = 5 * sizeof(float);
+
+    /// File header, stored at the start of the file
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        /// Size of one index in bytes, either 2 or 4
+        uint32_t indexSize;
+        /// Byte offset of the vertex data from the start of the file
+        uint32_t vertexOffset;
+        /// Byte offset of the index data from the start of the file
+        uint32_t indexOffset;
+        uint32_t reserved;
+        /// Axis aligned bounding box of the vertex positions
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    /// An indexed triangle mesh held in memory
+    struct Mesh
+    {
+        /// VERTEX_FLOATS floats per vertex
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+        float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+
+        uint32_t vertexCount() const { return static_cast<uint32_t>(vertices.size() / VERTEX_FLOATS); }
+    };
+
+    /// Read-only view of a mesh cache, the pointers refer into the buffer passed to parse
+    struct View
+    {
+        Header header {};
+        const void* vertices = nullptr;
+        size_t vertexBytes = 0;
+        const void* indices = nullptr;
+        size_t indexBytes = 0;
+    };
+
+    /// Build an indexed triangle mesh from the output of tinyobj::LoadObj
+    /// All shapes are merged into a single mesh. Face corners sharing the same
+    /// vertex, texture coordinate and normal indices are welded into one vertex.
+    static bool buildFromObj(const tinyobj::attrib_t& attrib,
+                             const std::vector<tinyobj::shape_t>& shapes, Mesh& mesh);
+
+    /// Write the mesh in the mesh cache format to the data buffer
+    static void serialize(const Mesh& mesh, std::vector<char>& data);
+
+    /// Validate a mesh cache held in memory and populate view to refer to its contents
+    /// No data is copied, the buffer must remain valid while the view is used.
+    /// Every index is checked to refer to a vertex of the cache.
+    static bool parse(const void* data, size_t size, View& view);
+};
+
+#endif // __MESH_CACHE_H__
@@ -0,0 +1,427 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+
+namespace
+{
+    // Parameters of the Forsyth vertex cache optimization
+    // See https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+    constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    constexpr uint32_t INVALID_INDEX = ~0u;
+
+
+    /// Score of a vertex given its position in the LRU cache (-1 when not cached)
+    /// and the number of triangles using it which have not been emitted yet
+    float vertexScore(int cachePosition, uint32_t remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                // The vertices of the last triangle get a fixed score so that
+                // the next triangle doesn't simply reuse the same edge
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+
+        // Boost vertices with few remaining triangles to avoid leaving isolated triangles behind
+        score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+
+    /// Count the FIFO cache misses for each triangle
+    void simulateCache(const uint32_t* indices, size_t triangleCount, uint32_t vertexCount,
+                       uint32_t cacheSize, std::vector<uint32_t>& misses)
+    {
+        // A vertex is in the cache when fewer than cacheSize vertices were
+        // added since it was itself added
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        uint32_t timestamp = cacheSize + 1;
+
+        misses.assign(triangleCount, 0);
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t v = indices[t * 3 + k];
+                if (timestamp - timestamps[v] > cacheSize)
+                {
+                    timestamps[v] = timestamp++;
+                    misses[t]++;
+                }
+            }
+        }
+    }
+
+
+    /// Area weighted normal of the triangle (the length is twice the triangle area)
+    void triangleNormal(const float* p0, const float* p1, const float* p2, float* n)
+    {
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+        n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+}
+
+
+void
+MeshOptimizer::optimize(MeshCache::Mesh& mesh)
+{
+    optimizeVertexCache(mesh.indices, mesh.vertexCount());
+    optimizeOverdraw(mesh.indices, mesh.vertices);
+    optimizeVertexFetch(mesh.indices, mesh.vertices);
+}
+
+
+void
+MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Build the list of triangles using each vertex
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t index : indices)
+    {
+        remaining[index]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    std::partial_sum(remaining.begin(), remaining.end(), adjacencyOffsets.begin() + 1);
+
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScores[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3]] +
+                            vertexScores[indices[t * 3 + 1]] +
+                            vertexScores[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t bestTriangle = static_cast<uint32_t>(
+        std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+    size_t searchCursor = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if (bestTriangle == INVALID_INDEX)
+        {
+            // No cached vertex has remaining triangles, continue with the next unused triangle
+            while (emitted[searchCursor])
+            {
+                ++searchCursor;
+            }
+            bestTriangle = static_cast<uint32_t>(searchCursor);
+        }
+
+        const uint32_t* triangle = &indices[bestTriangle * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[bestTriangle] = true;
+
+        // Remove the triangle from the adjacency of its vertices
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t v = triangle[k];
+            uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+            uint32_t* end = begin + remaining[v];
+            *std::find(begin, end, bestTriangle) = *(end - 1);
+            remaining[v]--;
+        }
+
+        // Move the triangle vertices to the front of the LRU cache
+        newCache.assign(triangle, triangle + 3);
+        for (uint32_t v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                newCache.push_back(v);
+            }
+        }
+        cache.swap(newCache);
+
+        // Update the scores of the cached vertices, evicting any beyond the cache size
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            uint32_t v = cache[i];
+            cachePositions[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            vertexScores[v] = vertexScore(cachePositions[v], remaining[v]);
+        }
+
+        // Update the scores of the triangles using the cached vertices and select the best one
+        bestTriangle = INVALID_INDEX;
+        float bestScore = -1.0f;
+        for (uint32_t v : cache)
+        {
+            const uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+            for (const uint32_t* t = begin; t != begin + remaining[v]; ++t)
+            {
+                float score = vertexScores[indices[*t * 3]] +
+                              vertexScores[indices[*t * 3 + 1]] +
+                              vertexScores[indices[*t * 3 + 2]];
+                triangleScores[*t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = *t;
+                }
+            }
+        }
+
+        if (cache.size() > FORSYTH_CACHE_SIZE)
+        {
+            cache.resize(FORSYTH_CACHE_SIZE);
+        }
+    }
+
+    indices.swap(output);
+}
+
+
+void
+MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<float>& vertices,
+                                float threshold)
+{
+    const size_t triangleCount = indices.size() / 3;
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size() / MeshCache::VERTEX_FLOATS);
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Hard boundaries are where the vertex cache is cold, i.e. all three vertices miss
+    std::vector<uint32_t> misses;
+    simulateCache(indices.data(), triangleCount, vertexCount, DEFAULT_CACHE_SIZE, misses);
+
+    std::vector<uint32_t> clusterStarts;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (t == 0 || misses[t] == 3)
+        {
+            clusterStarts.push_back(static_cast<uint32_t>(t));
+        }
+    }
+    clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Split hard clusters further while the cache efficiency of each part
+    // stays within the threshold of the whole cluster
+    std::vector<uint32_t> softStarts;
+    std::vector<uint32_t> clusterMisses;
+    for (size_t c = 0; c + 1 < clusterStarts.size(); ++c)
+    {
+        uint32_t start = clusterStarts[c];
+        uint32_t end = clusterStarts[c + 1];
+
+        uint32_t totalMisses = 0;
+        for (uint32_t t = start; t < end; ++t)
+        {
+            totalMisses += misses[t];
+        }
+        const float targetAcmr = threshold * totalMisses / (end - start);
+
+        softStarts.push_back(start);
+        while (start < end)
+        {
+            simulateCache(&indices[start * 3], end - start, vertexCount, DEFAULT_CACHE_SIZE, clusterMisses);
+
+            uint32_t partMisses = 0;
+            uint32_t split = end;
+            for (uint32_t t = start; t < end; ++t)
+            {
+                partMisses += clusterMisses[t - start];
+                // Don't create tiny clusters, they increase the cache misses without reducing overdraw
+                if (t + 1 - start >= 32 && t + 1 < end &&
+                    float(partMisses) / (t + 1 - start) <= targetAcmr)
+                {
+                    split = t + 1;
+                    break;
+                }
+            }
+
+            if (split < end)
+            {
+                softStarts.push_back(split);
+            }
+            start = split;
+        }
+    }
+    softStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Compute the area weighted centroid of the mesh and of each cluster
+    const size_t clusterCount = softStarts.size() - 1;
+    std::vector<float> clusterCentroids(clusterCount * 3, 0.0f);
+    std::vector<float> clusterNormals(clusterCount * 3, 0.0f);
+    float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        float clusterArea = 0.0f;
+        for (uint32_t t = softStarts[c]; t < softStarts[c + 1]; ++t)
+        {
+            const float* p0 = &vertices[indices[t * 3] * MeshCache::VERTEX_FLOATS];
+            const float* p1 = &vertices[indices[t * 3 + 1] * MeshCache::VERTEX_FLOATS];
+            const float* p2 = &vertices[indices[t * 3 + 2] * MeshCache::VERTEX_FLOATS];
+
+            float normal[3];
+            triangleNormal(p0, p1, p2, normal);
+            float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+            for (int i = 0; i < 3; ++i)
+            {
+                float centre = (p0[i] + p1[i] + p2[i]) / 3.0f;
+                clusterCentroids[c * 3 + i] += centre * area;
+                clusterNormals[c * 3 + i] += normal[i];
+                meshCentroid[i] += centre * area;
+            }
+            clusterArea += area;
+        }
+
+        if (clusterArea > 0.0f)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                clusterCentroids[c * 3 + i] /= clusterArea;
+            }
+        }
+        meshArea += clusterArea;
+    }
+
+    if (meshArea > 0.0f)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            meshCentroid[i] /= meshArea;
+        }
+    }
+
+    // Clusters which face away from the centre of the mesh are likely to occlude
+    // the rest of the mesh, draw those first
+    std::vector<float> clusterSortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        const float* centroid = &clusterCentroids[c * 3];
+        const float* normal = &clusterNormals[c * 3];
+        clusterSortKeys[c] = (centroid[0] - meshCentroid[0]) * normal[0] +
+                             (centroid[1] - meshCentroid[1]) * normal[1] +
+                             (centroid[2] - meshCentroid[2]) * normal[2];
+    }
+
+    std::vector<uint32_t> clusterOrder(clusterCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+                     [&clusterSortKeys](uint32_t a, uint32_t b) { return clusterSortKeys[a] > clusterSortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : clusterOrder)
+    {
+        output.insert(output.end(), indices.begin() + softStarts[c] * 3, indices.begin() + softStarts[c + 1] * 3);
+    }
+    indices.swap(output);
+}
+
+
+void
+MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<float>& vertices)
+{
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size() / MeshCache::VERTEX_FLOATS);
+
+    std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+    std::vector<float> output;
+    output.reserve(vertices.size());
+
+    uint32_t nextVertex = 0;
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == INVALID_INDEX)
+        {
+            remap[index] = nextVertex++;
+            const float* vertex = &vertices[index * MeshCache::VERTEX_FLOATS];
+            output.insert(output.end(), vertex, vertex + MeshCache::VERTEX_FLOATS);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(output);
+}
+
+
+MeshOptimizer::Statistics
+MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+                                  uint32_t cacheSize)
+{
+    Statistics statistics;
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+    {
+        return statistics;
+    }
+
+    std::vector<uint32_t> misses;
+    simulateCache(indices.data(), triangleCount, vertexCount, cacheSize, misses);
+    uint32_t totalMisses = std::accumulate(misses.begin(), misses.end(), 0u);
+
+    statistics.acmr = float(totalMisses) / triangleCount;
+    statistics.atvr = float(totalMisses) / vertexCount;
+    return statistics;
+}
@@ -0,0 +1,63 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __MESH_OPTIMIZER_H__
+#define __MESH_OPTIMIZER_H__
+
+#include "MeshCache.h"
+
+#include <cstdint>
+#include <vector>
+
+/// Reorders indexed meshes for efficient rendering.
+/**
+ * The optimizations only change the order of triangles and vertices, the
+ * rendered result is unchanged:
+ *  - triangles are reordered for the post-transform vertex cache (Forsyth)
+ *  - triangles are then grouped into clusters which are sorted to reduce overdraw
+ *  - vertices are reordered to match the order in which they are fetched
+ */
+class MeshOptimizer
+{
+public:
+    /// Vertex cache efficiency of an index buffer
+    struct Statistics
+    {
+        /// Average cache miss ratio, transformed vertices per triangle (1/3 is optimal)
+        float acmr = 0.0f;
+        /// Average transform to vertex ratio, transformed vertices per vertex (1 is optimal)
+        float atvr = 0.0f;
+    };
+
+    /// Size of the FIFO cache used to analyze meshes, a typical value for mobile GPUs
+    static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+
+    /// Apply all optimizations to the mesh
+    static void optimize(MeshCache::Mesh& mesh);
+
+    /// Reorder triangles to improve post-transform vertex cache hit rate
+    static void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+    /// Reorder clusters of triangles to reduce overdraw
+    /*
+    * Cluster boundaries are placed where the vertex cache would be cold,
+    * clusters are then drawn starting with those facing away from the mesh centre.
+    * threshold limits how much the ACMR may degrade compared to the input order.
+    */
+    static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<float>& vertices,
+                                 float threshold = 1.05f);
+
+    /// Reorder vertices in the order they are first referenced by the indices
+    /// Vertices which are not referenced are removed.
+    static void optimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<float>& vertices);
+
+    /// Simulate a FIFO vertex cache and return the resulting statistics
+    static Statistics analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+                                         uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+};
+
+#endif // __MESH_OPTIMIZER_H__
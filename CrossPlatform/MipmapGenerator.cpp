@@ -0,0 +1,190 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "MipmapGenerator.h"
+
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MIPMAP_GENERATOR_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIPMAP_GENERATOR_SSE2 1
+#endif
+
+
+namespace
+{
+    /// Downsample texels [begin, end) of a destination row from two source rows
+    /// row1 is row0 when the source is a single row.
+    void downsampleRowScalar(const uint8_t* row0, const uint8_t* row1, uint32_t width,
+                             uint32_t begin, uint32_t end, uint8_t* destination)
+    {
+        for (uint32_t x = begin; x < end; ++x)
+        {
+            // A single column repeats its texel
+            const size_t left = size_t(2 * x) * MipmapGenerator::PIXEL_SIZE;
+            const size_t right = size_t(std::min(2 * x + 1, width - 1)) * MipmapGenerator::PIXEL_SIZE;
+            uint8_t* out = destination + size_t(x) * MipmapGenerator::PIXEL_SIZE;
+            for (size_t c = 0; c < MipmapGenerator::PIXEL_SIZE; ++c)
+            {
+                out[c] = static_cast<uint8_t>((row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c] + 2) >> 2);
+            }
+        }
+    }
+
+
+    /// Downsample a destination row, as many texels as possible 4 at a time
+    /// Returns the number of texels written, the scalar version completes the row.
+    uint32_t downsampleRowVector(const uint8_t* row0, const uint8_t* row1, uint32_t width, uint8_t* destination)
+    {
+        const uint32_t destinationWidth = width / 2;
+        uint32_t x = 0;
+
+#if defined(MIPMAP_GENERATOR_NEON)
+        for (; x + 4 <= destinationWidth; x += 4)
+        {
+            const uint8_t* top = row0 + size_t(x) * 8;
+            const uint8_t* bottom = row1 + size_t(x) * 8;
+            // Split the 8 source texels of each row into the even and odd ones
+            uint32x4x2_t t = vuzpq_u32(vreinterpretq_u32_u8(vld1q_u8(top)), vreinterpretq_u32_u8(vld1q_u8(top + 16)));
+            uint32x4x2_t b = vuzpq_u32(vreinterpretq_u32_u8(vld1q_u8(bottom)), vreinterpretq_u32_u8(vld1q_u8(bottom + 16)));
+            uint8x16_t topEven = vreinterpretq_u8_u32(t.val[0]);
+            uint8x16_t topOdd = vreinterpretq_u8_u32(t.val[1]);
+            uint8x16_t bottomEven = vreinterpretq_u8_u32(b.val[0]);
+            uint8x16_t bottomOdd = vreinterpretq_u8_u32(b.val[1]);
+
+            uint16x8_t low = vaddq_u16(vaddl_u8(vget_low_u8(topEven), vget_low_u8(topOdd)),
+                                       vaddl_u8(vget_low_u8(bottomEven), vget_low_u8(bottomOdd)));
+            uint16x8_t high = vaddq_u16(vaddl_u8(vget_high_u8(topEven), vget_high_u8(topOdd)),
+                                        vaddl_u8(vget_high_u8(bottomEven), vget_high_u8(bottomOdd)));
+            // Rounding narrow, (sum + 2) >> 2 as in the scalar version
+            vst1q_u8(destination + size_t(x) * 4, vcombine_u8(vrshrn_n_u16(low, 2), vrshrn_n_u16(high, 2)));
+        }
+#elif defined(MIPMAP_GENERATOR_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rounding = _mm_set1_epi16(2);
+        for (; x + 4 <= destinationWidth; x += 4)
+        {
+            const uint8_t* top = row0 + size_t(x) * 8;
+            const uint8_t* bottom = row1 + size_t(x) * 8;
+            __m128i top0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top));
+            __m128i top1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + 16));
+            __m128i bottom0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom));
+            __m128i bottom1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + 16));
+
+            // Column sums widened to 16 bits, 2 source texels per register
+            __m128i sum01 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+            __m128i sum23 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+            __m128i sum45 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+            __m128i sum67 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+            // Add the odd texel of each register to the even one
+            sum01 = _mm_add_epi16(sum01, _mm_srli_si128(sum01, 8));
+            sum23 = _mm_add_epi16(sum23, _mm_srli_si128(sum23, 8));
+            sum45 = _mm_add_epi16(sum45, _mm_srli_si128(sum45, 8));
+            sum67 = _mm_add_epi16(sum67, _mm_srli_si128(sum67, 8));
+
+            __m128i out01 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum01, sum23), rounding), 2);
+            __m128i out23 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum45, sum67), rounding), 2);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + size_t(x) * 4), _mm_packus_epi16(out01, out23));
+        }
+#else
+        (void)row0;
+        (void)row1;
+        (void)destination;
+#endif
+
+        return x;
+    }
+}
+
+
+uint32_t
+MipmapGenerator::getLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levelCount = 1;
+    while ((std::max(width, height) >> levelCount) != 0)
+    {
+        ++levelCount;
+    }
+    return levelCount;
+}
+
+
+void
+MipmapGenerator::downsample(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination)
+{
+    const uint32_t destinationWidth = std::max(width / 2, 1u);
+    const uint32_t destinationHeight = std::max(height / 2, 1u);
+    const size_t sourceStride = size_t(width) * PIXEL_SIZE;
+    const size_t destinationStride = size_t(destinationWidth) * PIXEL_SIZE;
+
+    for (uint32_t y = 0; y < destinationHeight; ++y)
+    {
+        const uint8_t* row0 = source + size_t(2 * y) * sourceStride;
+        const uint8_t* row1 = source + size_t(std::min(2 * y + 1, height - 1)) * sourceStride;
+        uint8_t* out = destination + size_t(y) * destinationStride;
+
+        // A single column has no texel pairs for the vector kernel
+        uint32_t done = width > 1 ? downsampleRowVector(row0, row1, width, out) : 0;
+        downsampleRowScalar(row0, row1, width, done, destinationWidth, out);
+    }
+}
+
+
+void
+MipmapGenerator::downsampleScalar(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination)
+{
+    const uint32_t destinationWidth = std::max(width / 2, 1u);
+    const uint32_t destinationHeight = std::max(height / 2, 1u);
+    const size_t sourceStride = size_t(width) * PIXEL_SIZE;
+    const size_t destinationStride = size_t(destinationWidth) * PIXEL_SIZE;
+
+    for (uint32_t y = 0; y < destinationHeight; ++y)
+    {
+        const uint8_t* row0 = source + size_t(2 * y) * sourceStride;
+        const uint8_t* row1 = source + size_t(std::min(2 * y + 1, height - 1)) * sourceStride;
+        downsampleRowScalar(row0, row1, width, 0, destinationWidth, destination + size_t(y) * destinationStride);
+    }
+}
+
+
+void
+MipmapGenerator::generate(const uint8_t* data, uint32_t width, uint32_t height,
+                          std::vector<std::vector<uint8_t>>& levels)
+{
+    levels.clear();
+    levels.reserve(getLevelCount(width, height) - 1);
+
+    const uint8_t* source = data;
+    while (width > 1 || height > 1)
+    {
+        const uint32_t levelWidth = std::max(width / 2, 1u);
+        const uint32_t levelHeight = std::max(height / 2, 1u);
+        levels.emplace_back(size_t(levelWidth) * levelHeight * PIXEL_SIZE);
+        downsample(source, width, height, levels.back().data());
+
+        source = levels.back().data();
+        width = levelWidth;
+        height = levelHeight;
+    }
+}
+
+
+const char*
+MipmapGenerator::getKernelName()
+{
+#if defined(MIPMAP_GENERATOR_NEON)
+    return "NEON";
+#elif defined(MIPMAP_GENERATOR_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
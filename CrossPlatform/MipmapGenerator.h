@@ -0,0 +1,51 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __MIPMAP_GENERATOR_H__
+#define __MIPMAP_GENERATOR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Generates the mip chain of RGBA8 images on the CPU.
+/**
+ * Each level is the previous one downsampled with a 2x2 box filter, the
+ * filter glGenerateMipmap uses on most drivers. Odd dimensions drop the
+ * last row or column and a dimension of 1 repeats its texel, so the level
+ * sizes are those GL expects: max(1, size >> level).
+ *
+ * Rows are filtered with NEON on ARM and SSE2 on x86, 8 source texels at
+ * a time. The scalar version gives identical results and handles the
+ * remaining texels.
+ */
+class MipmapGenerator
+{
+public:
+    /// Bytes per texel
+    static constexpr size_t PIXEL_SIZE = 4;
+
+    /// Number of levels in a full mip chain, level 0 included
+    static uint32_t getLevelCount(uint32_t width, uint32_t height);
+
+    /// Downsample an RGBA8 image to max(1, width / 2) x max(1, height / 2) texels
+    /// Both images are tightly packed.
+    static void downsample(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination);
+
+    /// downsample without SIMD, the reference for the vector kernels
+    static void downsampleScalar(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination);
+
+    /// Generate every level below level 0 of an RGBA8 image down to 1x1
+    /// levels[0] receives level 1, an image of 1x1 has no levels to generate.
+    static void generate(const uint8_t* data, uint32_t width, uint32_t height,
+                         std::vector<std::vector<uint8_t>>& levels);
+
+    /// Instruction set of the downsample kernel, e.g. for benchmark output
+    static const char* getKernelName();
+};
+
+#endif // __MIPMAP_GENERATOR_H__
@@ -22,6 +22,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 
+//
+// Local changes: parse from a memory buffer (LoadObjFromBuffer), optionally
+// on several threads, and a faster number parser. Define
+// TINYOBJLOADER_DISABLE_FAST_FLOAT to use the original number parser.
 //
 // version 1.0.6 : Add TINYOBJLOADER_USE_DOUBLE option(#124)
 // version 1.0.5 : Ignore `Tr` when `d` exists in MTL(#43)
@@ -336,6 +340,27 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
              std::istream *inStream, MaterialReader *readMatFn = NULL,
              bool triangulate = true);
 
+/// Loads .obj from a buffer in memory, e.g. a mapped asset.
+/// Produces the same 'attrib' and 'shapes' as the std::istream LoadObj
+/// without a MaterialReader, `usemtl` and `mtllib` are ignored.
+/// The buffer is scanned in place: a first pass counts the elements so the
+/// output arrays are allocated once, a second pass parses into them.
+/// Files using subdivision tags (`t`) are passed to LoadObj.
+/// Returns warning and error message into `err`
+/// 'num_threads' parses parts of the buffer in parallel, the result is the
+/// same whatever the number of threads. There are at most as many parts as
+/// 256 KB chunks of the buffer, so buffers smaller than that are parsed on
+/// the calling thread, and no more threads than cores are started.
+bool LoadObjFromBuffer(attrib_t *attrib, std::vector<shape_t> *shapes,
+                       std::string *err, const char *buffer, size_t size,
+                       bool triangulate = true, unsigned int num_threads = 1);
+
+/// Parses a number like the .obj and .mtl parsers do. Reading stops at
+/// `s_end` or at the first character which isn't part of the number, `*s_end`
+/// must be readable. Exposed to check and measure the parser.
+/// Returns false when there is no number at `s`.
+bool ParseDouble(const char *s, const char *s_end, double *result);
+
 /// Loads materials into std::map
 void LoadMtl(std::map<std::string, int> *material_map,
              std::vector<material_t> *materials, std::istream *inStream,
@@ -346,12 +371,14 @@ void LoadMtl(std::map<std::string, int> *material_map,
 #endif  // TINY_OBJ_LOADER_H_
 
 #ifdef TINYOBJLOADER_IMPLEMENTATION
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <cmath>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <thread>
 #include <utility>
 
 #include <fstream>
@@ -471,6 +498,121 @@ static inline int parseInt(const char **token) {
 //  - s >= s_end.
 //  - parse failure.
 //
+#ifndef TINYOBJLOADER_DISABLE_FAST_FLOAT
+// The digits are read into an integer mantissa and a decimal exponent. When
+// both are small enough to be exact doubles, i.e. a mantissa of at most 2^53
+// and |exponent| <= 22, a single multiplication or division gives the
+// correctly rounded result (Clinger's fast path). This covers the fixed
+// precision numbers written by exporters. Other numbers are converted with
+// strtod, so the result is always the same as strtod's.
+static bool tryParseDouble(const char *s, const char *s_end, double *result) {
+  if (s >= s_end) {
+    return false;
+  }
+
+  static const double pow10_lut[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+  const int max_exponent = sizeof pow10_lut / sizeof pow10_lut[0] - 1;
+  const unsigned long long max_mantissa = 1ULL << 53;
+  // 19 digits always fit in 64 bits
+  const int max_digits = 19;
+
+  unsigned long long mantissa = 0;
+  int digits = 0;
+  bool truncated = false;
+  int exponent = 0;
+  bool negative = false;
+  const char *curr = s;
+
+  // Find out what sign we've got.
+  if (*curr == '+' || *curr == '-') {
+    negative = (*curr == '-');
+    curr++;
+  } else if (!IS_DIGIT(*curr)) {
+    return false;
+  }
+
+  // Read the integer part, leading zeros aren't significant digits.
+  const char *integer_begin = curr;
+  while (curr != s_end && IS_DIGIT(*curr)) {
+    if (digits < max_digits) {
+      mantissa = mantissa * 10 + static_cast<unsigned int>(*curr - '0');
+      digits += (mantissa != 0);
+    } else {
+      truncated = true;
+    }
+    curr++;
+  }
+
+  // We must make sure we actually got something.
+  if (curr == integer_begin) {
+    return false;
+  }
+
+  // Read the decimal part.
+  if (curr != s_end && *curr == '.') {
+    curr++;
+    while (curr != s_end && IS_DIGIT(*curr)) {
+      if (digits < max_digits) {
+        mantissa = mantissa * 10 + static_cast<unsigned int>(*curr - '0');
+        digits += (mantissa != 0);
+        exponent--;
+      } else {
+        truncated = true;
+      }
+      curr++;
+    }
+  }
+
+  // Read the exponent part.
+  if (curr != s_end && (*curr == 'e' || *curr == 'E')) {
+    curr++;
+    bool exponent_negative = false;
+    if (curr != s_end && (*curr == '+' || *curr == '-')) {
+      exponent_negative = (*curr == '-');
+      curr++;
+    }
+
+    // Empty E is not allowed.
+    const char *exponent_begin = curr;
+    int value = 0;
+    while (curr != s_end && IS_DIGIT(*curr)) {
+      // Beyond this any mantissa is 0 or infinite, strtod handles it
+      if (value < 100000) {
+        value = value * 10 + static_cast<int>(*curr - '0');
+      }
+      curr++;
+    }
+    if (curr == exponent_begin) {
+      return false;
+    }
+    exponent += exponent_negative ? -value : value;
+  }
+
+  if (!truncated && mantissa <= max_mantissa && exponent >= -max_exponent &&
+      exponent <= max_exponent) {
+    double value = static_cast<double>(mantissa);
+    value = (exponent < 0) ? value / pow10_lut[-exponent]
+                           : value * pow10_lut[exponent];
+    *result = negative ? -value : value;
+    return true;
+  }
+
+  // strtod needs the number terminated
+  char buffer[64];
+  const size_t length = static_cast<size_t>(curr - s);
+  if (length < sizeof(buffer)) {
+    memcpy(buffer, s, length);
+    buffer[length] = '\0';
+    *result = strtod(buffer, NULL);
+  } else {
+    *result = strtod(std::string(s, curr).c_str(), NULL);
+  }
+  return true;
+}
+#else
 static bool tryParseDouble(const char *s, const char *s_end, double *result) {
   if (s >= s_end) {
     return false;
@@ -585,6 +727,11 @@ assemble:
 fail:
   return false;
 }
+#endif  // TINYOBJLOADER_DISABLE_FAST_FLOAT
+
+bool ParseDouble(const char *s, const char *s_end, double *result) {
+  return tryParseDouble(s, s_end, result);
+}
 
 static inline real_t parseReal(const char **token, double default_value = 0.0) {
   (*token) += strspn((*token), " \t");
@@ -1729,6 +1876,498 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
   return true;
 }
 
+// Helpers for LoadObj from a buffer. [token, end) is the rest of a line
+// without its line ending, *end is always readable.
+
+static inline const char *skipSpaces(const char *token, const char *end) {
+  while (token < end && IS_SPACE(*token)) token++;
+  return token;
+}
+
+// strcspn(token, " \t\r") within the line
+static inline const char *skipToken(const char *token, const char *end) {
+  while (token < end && !IS_SPACE(*token)) token++;
+  return token;
+}
+
+// strcspn(token, "/ \t\r") within the line
+static inline const char *skipIndex(const char *token, const char *end) {
+  while (token < end && *token != '/' && !IS_SPACE(*token)) token++;
+  return token;
+}
+
+// atoi within the line
+static inline int parseIndex(const char *token, const char *end) {
+  while (token < end && (IS_SPACE(*token) || *token == '\v' || *token == '\f'))
+    token++;
+  bool negative = false;
+  if (token < end && (*token == '+' || *token == '-')) {
+    negative = (*token == '-');
+    token++;
+  }
+  int value = 0;
+  while (token < end && IS_DIGIT(*token)) {
+    value = value * 10 + (*token - '0');
+    token++;
+  }
+  return negative ? -value : value;
+}
+
+static inline real_t parseRealInLine(const char **token, const char *end) {
+  (*token) = skipSpaces(*token, end);
+  const char *token_end = skipToken(*token, end);
+  double val = 0.0;
+  tryParseDouble((*token), token_end, &val);
+  (*token) = token_end;
+  return static_cast<real_t>(val);
+}
+
+// parseTriple within the line
+static vertex_index parseTripleInLine(const char **token, const char *end,
+                                      int vsize, int vnsize, int vtsize) {
+  vertex_index vi(-1);
+
+  vi.v_idx = fixIndex(parseIndex(*token, end), vsize);
+  (*token) = skipIndex(*token, end);
+  if ((*token) == end || (*token)[0] != '/') {
+    return vi;
+  }
+  (*token)++;
+
+  // i//k
+  if ((*token) < end && (*token)[0] == '/') {
+    (*token)++;
+    vi.vn_idx = fixIndex(parseIndex(*token, end), vnsize);
+    (*token) = skipIndex(*token, end);
+    return vi;
+  }
+
+  // i/j/k or i/j
+  vi.vt_idx = fixIndex(parseIndex(*token, end), vtsize);
+  (*token) = skipIndex(*token, end);
+  if ((*token) == end || (*token)[0] != '/') {
+    return vi;
+  }
+
+  // i/j/k
+  (*token)++;  // skip '/'
+  vi.vn_idx = fixIndex(parseIndex(*token, end), vnsize);
+  (*token) = skipIndex(*token, end);
+  return vi;
+}
+
+// Calls line(begin, end) for each line of the buffer. Lines end with "\n",
+// "\r\n" or "\r" like safeGetline. The last line is copied when it has no
+// line ending so that *end is readable for every line.
+template <typename LineFunction>
+static void forEachLine(const char *buffer, size_t size, LineFunction line) {
+  const char *p = buffer;
+  const char *buffer_end = buffer + size;
+  while (p < buffer_end) {
+    const char *line_end = p;
+    while (line_end < buffer_end && *line_end != '\n' && *line_end != '\r')
+      line_end++;
+
+    if (line_end == buffer_end) {
+      std::string last(p, line_end);
+      line(last.c_str(), last.c_str() + last.size());
+      return;
+    }
+    line(p, line_end);
+
+    p = line_end + 1;
+    if (*line_end == '\r' && p < buffer_end && *p == '\n') p++;
+  }
+}
+
+// Parse state of a part of the buffer for LoadObjFromBuffer. The faces of
+// a chunk are split into segments at each `g` or `o` line, the segments of
+// all chunks joined in order form the shapes.
+struct obj_segment {
+  mesh_t mesh;
+  bool has_faces;
+  // Name given by the `g` or `o` line which starts the segment, the first
+  // segment of a chunk continues the last one of the previous chunk.
+  std::string name;
+  // Counted in the first pass to reserve the mesh, then set to the offset
+  // of the segment in its shape when the shape has several segments
+  size_t num_indices;
+  size_t num_faces;
+
+  obj_segment() : has_faces(false), num_indices(0), num_faces(0) {}
+};
+
+struct obj_chunk {
+  const char *begin;
+  const char *end;
+  // Vertex attributes of the chunk, and of the chunks before it
+  size_t num_v, num_vn, num_vt;
+  size_t v_offset, vn_offset, vt_offset;
+  bool has_tags;
+  std::vector<obj_segment> segments;
+
+  obj_chunk()
+      : begin(NULL),
+        end(NULL),
+        num_v(0),
+        num_vn(0),
+        num_vt(0),
+        v_offset(0),
+        vn_offset(0),
+        vt_offset(0),
+        has_tags(false) {}
+};
+
+// Counting pass over a chunk: vertex attributes, and triangles (or faces and
+// face vertices) of each segment.
+static void countObjChunk(obj_chunk *chunk, bool triangulate) {
+  chunk->segments.assign(1, obj_segment());
+  forEachLine(chunk->begin, static_cast<size_t>(chunk->end - chunk->begin),
+              [&](const char *token, const char *end) {
+    token = skipSpaces(token, end);
+    if (token == end) return;
+    const char c0 = token[0];
+    const char c1 = (token + 1 < end) ? token[1] : '\0';
+    const char c2 = (token + 2 < end) ? token[2] : '\0';
+    if (c0 == 'v') {
+      if (IS_SPACE(c1)) chunk->num_v++;
+      else if (c1 == 'n' && IS_SPACE(c2)) chunk->num_vn++;
+      else if (c1 == 't' && IS_SPACE(c2)) chunk->num_vt++;
+    } else if (c0 == 'f' && IS_SPACE(c1)) {
+      size_t corners = 0;
+      for (token = skipSpaces(token + 2, end); token < end;
+           token = skipSpaces(skipToken(token, end), end)) {
+        corners++;
+      }
+      obj_segment &segment = chunk->segments.back();
+      if (triangulate) {
+        size_t triangles = corners > 2 ? corners - 2 : 0;
+        segment.num_indices += 3 * triangles;
+        segment.num_faces += triangles;
+      } else {
+        segment.num_indices += corners;
+        segment.num_faces++;
+      }
+    } else if ((c0 == 'g' || c0 == 'o') && IS_SPACE(c1)) {
+      chunk->segments.push_back(obj_segment());
+    } else if (c0 == 't' && IS_SPACE(c1)) {
+      chunk->has_tags = true;
+    }
+  });
+}
+
+// Parsing pass over a chunk. The vertex attributes are written to their
+// place in 'attrib', sized by the counting pass, the faces to the segments.
+static void parseObjChunk(obj_chunk *chunk, attrib_t *attrib,
+                          bool triangulate) {
+  real_t *v = attrib->vertices.data() + 3 * chunk->v_offset;
+  real_t *vn = attrib->normals.data() + 3 * chunk->vn_offset;
+  real_t *vt = attrib->texcoords.data() + 2 * chunk->vt_offset;
+
+  // Number of attributes defined so far, for relative indices
+  int vsize = static_cast<int>(chunk->v_offset);
+  int vnsize = static_cast<int>(chunk->vn_offset);
+  int vtsize = static_cast<int>(chunk->vt_offset);
+
+  size_t segment_index = 0;
+  for (size_t i = 0; i < chunk->segments.size(); i++) {
+    obj_segment &segment = chunk->segments[i];
+    segment.mesh.indices.reserve(segment.num_indices);
+    segment.mesh.num_face_vertices.reserve(segment.num_faces);
+    segment.mesh.material_ids.reserve(segment.num_faces);
+  }
+
+  forEachLine(chunk->begin, static_cast<size_t>(chunk->end - chunk->begin),
+              [&](const char *token, const char *end) {
+    token = skipSpaces(token, end);
+    if (token == end || token[0] == '#') return;
+    const char c1 = (token + 1 < end) ? token[1] : '\0';
+    const char c2 = (token + 2 < end) ? token[2] : '\0';
+
+    // vertex
+    if (token[0] == 'v' && IS_SPACE(c1)) {
+      token += 2;
+      *v++ = parseRealInLine(&token, end);
+      *v++ = parseRealInLine(&token, end);
+      *v++ = parseRealInLine(&token, end);
+      vsize++;
+      return;
+    }
+
+    // normal
+    if (token[0] == 'v' && c1 == 'n' && IS_SPACE(c2)) {
+      token += 3;
+      *vn++ = parseRealInLine(&token, end);
+      *vn++ = parseRealInLine(&token, end);
+      *vn++ = parseRealInLine(&token, end);
+      vnsize++;
+      return;
+    }
+
+    // texcoord
+    if (token[0] == 'v' && c1 == 't' && IS_SPACE(c2)) {
+      token += 3;
+      *vt++ = parseRealInLine(&token, end);
+      *vt++ = parseRealInLine(&token, end);
+      vtsize++;
+      return;
+    }
+
+    // face, written straight to the segment
+    if (token[0] == 'f' && IS_SPACE(c1)) {
+      token = skipSpaces(token + 2, end);
+
+      obj_segment &segment = chunk->segments[segment_index];
+      mesh_t &mesh = segment.mesh;
+      segment.has_faces = true;
+
+      index_t first = {-1, -1, -1}, previous = {-1, -1, -1};
+      size_t corners = 0;
+      while (token < end) {
+        vertex_index vi = parseTripleInLine(&token, end, vsize, vnsize, vtsize);
+        index_t idx;
+        idx.vertex_index = vi.v_idx;
+        idx.normal_index = vi.vn_idx;
+        idx.texcoord_index = vi.vt_idx;
+
+        if (!triangulate) {
+          mesh.indices.push_back(idx);
+        } else if (corners == 0) {
+          first = idx;
+        } else if (corners >= 2) {
+          // Polygon -> triangle fan conversion
+          mesh.indices.push_back(first);
+          mesh.indices.push_back(previous);
+          mesh.indices.push_back(idx);
+          mesh.num_face_vertices.push_back(3);
+          mesh.material_ids.push_back(-1);
+        }
+        previous = idx;
+        corners++;
+        token = skipSpaces(token, end);
+      }
+
+      if (!triangulate && corners > 0) {
+        mesh.num_face_vertices.push_back(static_cast<unsigned char>(corners));
+        mesh.material_ids.push_back(-1);
+      }
+      return;
+    }
+
+    // group name, the first name after `g`
+    if (token[0] == 'g' && IS_SPACE(c1)) {
+      token = skipSpaces(token + 1, end);
+      chunk->segments[++segment_index].name.assign(token,
+                                                   skipToken(token, end));
+      return;
+    }
+
+    // object name
+    if (token[0] == 'o' && IS_SPACE(c1)) {
+      token = skipSpaces(token + 2, end);
+      chunk->segments[++segment_index].name.assign(token,
+                                                   skipToken(token, end));
+      return;
+    }
+
+    // Ignore unknown command, `usemtl` and `mtllib`.
+  });
+}
+
+// Appends 'src' to 'dst' at 'offset', 'dst' is already sized
+template <typename T>
+static void copyToOffset(const std::vector<T> &src, std::vector<T> *dst,
+                         size_t offset) {
+  if (!src.empty()) {
+    memcpy(dst->data() + offset, src.data(), src.size() * sizeof(T));
+  }
+}
+
+// Runs task(i) for i in [0, count), on up to 'count' threads but no more
+// than there are cores. Each thread runs every n-th task.
+template <typename Task>
+static void runParallel(size_t count, Task task) {
+  size_t num_workers = std::min<size_t>(count, std::thread::hardware_concurrency());
+  if (num_workers <= 1) {
+    for (size_t i = 0; i < count; i++) task(i);
+    return;
+  }
+  auto worker = [&](size_t first) {
+    for (size_t i = first; i < count; i += num_workers) task(i);
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_workers - 1);
+  for (size_t w = 1; w < num_workers; w++) {
+    threads.push_back(std::thread(worker, w));
+  }
+  worker(0);
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+}
+
+bool LoadObjFromBuffer(attrib_t *attrib, std::vector<shape_t> *shapes,
+                       std::string *err, const char *buffer, size_t size,
+                       bool triangulate, unsigned int num_threads) {
+  // Split the buffer at line endings. Small chunks aren't worth a thread.
+  const size_t kMinChunkSize = 256 * 1024;
+  size_t num_chunks = num_threads > 0 ? num_threads : 1;
+  if (num_chunks > size / kMinChunkSize) {
+    num_chunks = size / kMinChunkSize > 0 ? size / kMinChunkSize : 1;
+  }
+
+  std::vector<obj_chunk> chunks;
+  chunks.reserve(num_chunks);
+  const char *buffer_end = buffer + size;
+  const char *chunk_begin = buffer;
+  for (size_t i = 1; i <= num_chunks && chunk_begin < buffer_end; i++) {
+    const char *chunk_end = buffer_end;
+    if (i < num_chunks) {
+      chunk_end = std::max(chunk_begin, buffer + i * (size / num_chunks));
+      while (chunk_end < buffer_end && *chunk_end != '\n' && *chunk_end != '\r')
+        chunk_end++;
+      if (chunk_end < buffer_end) chunk_end++;
+    }
+    chunks.push_back(obj_chunk());
+    chunks.back().begin = chunk_begin;
+    chunks.back().end = chunk_end;
+    chunk_begin = chunk_end;
+  }
+  if (chunks.empty()) {
+    chunks.push_back(obj_chunk());
+    chunks.back().begin = chunks.back().end = buffer;
+  }
+
+  runParallel(chunks.size(),
+              [&](size_t i) { countObjChunk(&chunks[i], triangulate); });
+
+  bool has_tags = false;
+  size_t num_v = 0, num_vn = 0, num_vt = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    obj_chunk &chunk = chunks[i];
+    has_tags = has_tags || chunk.has_tags;
+    chunk.v_offset = num_v;
+    chunk.vn_offset = num_vn;
+    chunk.vt_offset = num_vt;
+    num_v += chunk.num_v;
+    num_vn += chunk.num_vn;
+    num_vt += chunk.num_vt;
+  }
+
+  if (has_tags) {
+    std::string text(buffer, size);
+    std::istringstream stream(text);
+    std::vector<material_t> materials;
+    return LoadObj(attrib, shapes, &materials, err, &stream, NULL,
+                   triangulate);
+  }
+
+  std::vector<real_t>(3 * num_v).swap(attrib->vertices);
+  std::vector<real_t>(3 * num_vn).swap(attrib->normals);
+  std::vector<real_t>(2 * num_vt).swap(attrib->texcoords);
+
+  runParallel(chunks.size(), [&](size_t i) {
+    parseObjChunk(&chunks[i], attrib, triangulate);
+  });
+
+  // Join the segments into shapes. A shape ends at each `g` or `o` line and
+  // is kept when it has faces, with the name current at that point.
+  struct shape_range {
+    size_t first_chunk, first_segment;
+    size_t last_chunk, last_segment;
+  };
+  std::vector<shape_range> ranges;
+  std::string name;
+  bool has_faces = false;
+  shape_range range = {0, 0, 0, 0};
+  for (size_t i = 0; i < chunks.size(); i++) {
+    for (size_t j = 0; j < chunks[i].segments.size(); j++) {
+      const obj_segment &segment = chunks[i].segments[j];
+      if (j > 0) {
+        if (has_faces) {
+          ranges.push_back(range);
+          shapes->push_back(shape_t());
+          shapes->back().name = name;
+        }
+        name = segment.name;
+        has_faces = false;
+        range.first_chunk = i;
+        range.first_segment = j;
+      }
+      has_faces = has_faces || segment.has_faces;
+      range.last_chunk = i;
+      range.last_segment = j;
+    }
+  }
+  if (has_faces) {
+    ranges.push_back(range);
+    shapes->push_back(shape_t());
+    shapes->back().name = name;
+  }
+
+  const size_t first_shape = shapes->size() - ranges.size();
+  for (size_t s = 0; s < ranges.size(); s++) {
+    const shape_range &r = ranges[s];
+    mesh_t &mesh = (*shapes)[first_shape + s].mesh;
+    if (r.first_chunk == r.last_chunk && r.first_segment == r.last_segment) {
+      // A shape in a single segment takes its storage
+      obj_segment &segment = chunks[r.first_chunk].segments[r.first_segment];
+      mesh.indices.swap(segment.mesh.indices);
+      mesh.num_face_vertices.swap(segment.mesh.num_face_vertices);
+      mesh.material_ids.swap(segment.mesh.material_ids);
+      continue;
+    }
+
+    // Otherwise size it, the segments are copied in by their chunk's thread
+    size_t num_indices = 0, num_faces = 0;
+    for (size_t i = r.first_chunk; i <= r.last_chunk; i++) {
+      obj_chunk &chunk = chunks[i];
+      size_t first = (i == r.first_chunk) ? r.first_segment : 0;
+      size_t last =
+          (i == r.last_chunk) ? r.last_segment : chunk.segments.size() - 1;
+      for (size_t j = first; j <= last; j++) {
+        obj_segment &segment = chunk.segments[j];
+        segment.num_indices = num_indices;
+        segment.num_faces = num_faces;
+        num_indices += segment.mesh.indices.size();
+        num_faces += segment.mesh.num_face_vertices.size();
+      }
+    }
+    mesh.indices.resize(num_indices);
+    mesh.num_face_vertices.resize(num_faces);
+    mesh.material_ids.resize(num_faces);
+  }
+
+  runParallel(chunks.size(), [&](size_t i) {
+    for (size_t s = 0; s < ranges.size(); s++) {
+      const shape_range &r = ranges[s];
+      if (i < r.first_chunk || i > r.last_chunk ||
+          (r.first_chunk == r.last_chunk &&
+           r.first_segment == r.last_segment)) {
+        continue;
+      }
+      mesh_t &mesh = (*shapes)[first_shape + s].mesh;
+      size_t first = (i == r.first_chunk) ? r.first_segment : 0;
+      size_t last =
+          (i == r.last_chunk) ? r.last_segment : chunks[i].segments.size() - 1;
+      for (size_t j = first; j <= last; j++) {
+        const obj_segment &segment = chunks[i].segments[j];
+        copyToOffset(segment.mesh.indices, &mesh.indices,
+                     segment.num_indices);
+        copyToOffset(segment.mesh.num_face_vertices, &mesh.num_face_vertices,
+                     segment.num_faces);
+        copyToOffset(segment.mesh.material_ids, &mesh.material_ids,
+                     segment.num_faces);
+      }
+    }
+  });
+
+  if (err) {
+    err->clear();
+  }
+  return true;
+}
+
 bool LoadObjWithCallback(std::istream &inStream, const callback_t &callback,
                          void *user_data /*= NULL*/,
                          MaterialReader *readMatFn /*= NULL*/,
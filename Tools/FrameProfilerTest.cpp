@@ -0,0 +1,158 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Host test of FrameProfiler, run by ctest.
+//
+// Usage: FrameProfilerTest
+//
+// Known samples are recorded and their percentiles checked, including after
+// the sample ring wraps, then a reader thread reads percentiles while the
+// writer records samples and checks every result it sees is consistent.
+// PROFILE_SCOPE is checked to record a sample, or nothing when built with
+// ENABLE_FRAME_PROFILER=0.
+
+#include <FrameProfiler.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+
+namespace
+{
+    int gFailures = 0;
+
+    void expect(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            fprintf(stderr, "FAILED: %s\n", description);
+            ++gFailures;
+        }
+    }
+
+
+    bool samePercentiles(const FrameProfiler::Percentiles& percentiles, float p50, float p95, float p99)
+    {
+        return percentiles.p50 == p50 && percentiles.p95 == p95 && percentiles.p99 == p99;
+    }
+
+
+    void checkKnownSamples()
+    {
+        FrameProfiler::reset();
+        expect(samePercentiles(FrameProfiler::getPercentiles(FrameProfiler::STAGE_FRAME), 0.0f, 0.0f, 0.0f),
+               "no samples give zero percentiles");
+
+        // 1 to 100 in a shuffled order, nearest rank percentiles are the sample values
+        for (int i = 0; i < 100; ++i)
+        {
+            FrameProfiler::record(FrameProfiler::STAGE_FRAME, static_cast<float>((i * 37) % 100 + 1));
+        }
+        expect(samePercentiles(FrameProfiler::getPercentiles(FrameProfiler::STAGE_FRAME), 50.0f, 95.0f, 99.0f),
+               "percentiles of 1 to 100");
+        expect(samePercentiles(FrameProfiler::getPercentiles(FrameProfiler::STAGE_UPDATE_STATE), 0.0f, 0.0f, 0.0f),
+               "stages are recorded separately");
+
+        // A single sample is every percentile
+        FrameProfiler::record(FrameProfiler::STAGE_GPU_AUGMENTATIONS, 4.0f);
+        expect(samePercentiles(FrameProfiler::getPercentiles(FrameProfiler::STAGE_GPU_AUGMENTATIONS), 4.0f, 4.0f, 4.0f),
+               "percentiles of a single sample");
+
+        // Only the newest SAMPLE_COUNT samples are kept, 1 to 300 leaves 45 to 300
+        FrameProfiler::reset();
+        for (int i = 1; i <= 300; ++i)
+        {
+            FrameProfiler::record(FrameProfiler::STAGE_AUGMENTATIONS, static_cast<float>(i));
+        }
+        expect(samePercentiles(FrameProfiler::getPercentiles(FrameProfiler::STAGE_AUGMENTATIONS), 172.0f, 287.0f, 297.0f),
+               "percentiles after the ring wraps");
+
+        // Stages out of range are ignored
+        FrameProfiler::record(FrameProfiler::STAGE_COUNT, 1.0f);
+        expect(samePercentiles(FrameProfiler::getPercentiles(FrameProfiler::STAGE_COUNT), 0.0f, 0.0f, 0.0f),
+               "stages out of range");
+
+        FrameProfiler::reset();
+        expect(samePercentiles(FrameProfiler::getPercentiles(FrameProfiler::STAGE_AUGMENTATIONS), 0.0f, 0.0f, 0.0f),
+               "reset drops the samples");
+    }
+
+
+    void checkConcurrentReader()
+    {
+        FrameProfiler::reset();
+
+        // The writer records samples between 1 and 2 ms, any percentile read
+        // while it runs is either 0 before the first sample or in that range
+        const int SAMPLES = 200000;
+        std::atomic<bool> writing { true };
+        std::atomic<int> reads { 0 };
+        std::atomic<int> badReads { 0 };
+        std::thread reader([&]()
+        {
+            while (writing.load(std::memory_order_acquire))
+            {
+                FrameProfiler::Percentiles percentiles = FrameProfiler::getPercentiles(FrameProfiler::STAGE_FRAME);
+                bool empty = samePercentiles(percentiles, 0.0f, 0.0f, 0.0f);
+                bool inRange = percentiles.p50 >= 1.0f && percentiles.p99 <= 2.0f &&
+                               percentiles.p50 <= percentiles.p95 && percentiles.p95 <= percentiles.p99;
+                if (!empty && !inRange)
+                {
+                    badReads.fetch_add(1, std::memory_order_relaxed);
+                }
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        for (int i = 0; i < SAMPLES; ++i)
+        {
+            FrameProfiler::record(FrameProfiler::STAGE_FRAME, 1.0f + static_cast<float>(i % 101) / 100.0f);
+        }
+        writing.store(false, std::memory_order_release);
+        reader.join();
+
+        expect(badReads.load() == 0, "concurrent reads see consistent percentiles");
+        FrameProfiler::Percentiles percentiles = FrameProfiler::getPercentiles(FrameProfiler::STAGE_FRAME);
+        expect(percentiles.p50 >= 1.0f && percentiles.p99 <= 2.0f, "percentiles after the concurrent writes");
+        printf("Concurrent: %d samples recorded, %d percentile reads\n", SAMPLES, reads.load());
+    }
+
+
+    void checkProfileScope()
+    {
+        FrameProfiler::reset();
+        {
+            PROFILE_SCOPE(STAGE_VIDEO_BACKGROUND);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        FrameProfiler::Percentiles percentiles = FrameProfiler::getPercentiles(FrameProfiler::STAGE_VIDEO_BACKGROUND);
+#if ENABLE_FRAME_PROFILER
+        expect(percentiles.p50 >= 2.0f, "PROFILE_SCOPE records the scope duration");
+#else
+        expect(samePercentiles(percentiles, 0.0f, 0.0f, 0.0f), "PROFILE_SCOPE is compiled out");
+#endif
+    }
+}
+
+
+int main()
+{
+    checkKnownSamples();
+    checkConcurrentReader();
+    checkProfileScope();
+
+    if (gFailures > 0)
+    {
+        fprintf(stderr, "%d checks failed\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    printf("All checks passed, ENABLE_FRAME_PROFILER=%d\n", ENABLE_FRAME_PROFILER);
+    return EXIT_SUCCESS;
+}
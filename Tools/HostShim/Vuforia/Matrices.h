@@ -0,0 +1,31 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Host stand-in for the matrix types of the Vuforia Engine headers, see
+// Vectors.h.
+
+#ifndef _VUFORIA_MATRICES_H_
+#define _VUFORIA_MATRICES_H_
+
+namespace Vuforia
+{
+
+/// Matrix with 3 rows and 4 columns of float items
+struct Matrix34F
+{
+    float data[3 * 4];
+};
+
+/// Matrix with 4 rows and 4 columns of float items
+struct Matrix44F
+{
+    float data[4 * 4];
+};
+
+} // namespace Vuforia
+
+#endif // _VUFORIA_MATRICES_H_
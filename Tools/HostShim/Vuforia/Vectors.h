@@ -0,0 +1,70 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Host stand-in for the vector types of the Vuforia Engine headers, with the
+// same layout, so the math code can be built and tested without the SDK.
+// The real header is used instead when the SDK is next to the sample.
+
+#ifndef _VUFORIA_VECTORS_H_
+#define _VUFORIA_VECTORS_H_
+
+namespace Vuforia
+{
+
+/// 2D vector of float items
+struct Vec2F
+{
+    Vec2F() {}
+    explicit Vec2F(const float* v) { for (int i = 0; i < 2; ++i) data[i] = v[i]; }
+    Vec2F(float v0, float v1) { data[0] = v0; data[1] = v1; }
+
+    float data[2];
+};
+
+/// 3D vector of float items
+struct Vec3F
+{
+    Vec3F() {}
+    explicit Vec3F(const float* v) { for (int i = 0; i < 3; ++i) data[i] = v[i]; }
+    Vec3F(float v0, float v1, float v2) { data[0] = v0; data[1] = v1; data[2] = v2; }
+
+    float data[3];
+};
+
+/// 4D vector of float items
+struct Vec4F
+{
+    Vec4F() {}
+    explicit Vec4F(const float* v) { for (int i = 0; i < 4; ++i) data[i] = v[i]; }
+    Vec4F(float v0, float v1, float v2, float v3) { data[0] = v0; data[1] = v1; data[2] = v2; data[3] = v3; }
+
+    float data[4];
+};
+
+/// 2D vector of int items
+struct Vec2I
+{
+    Vec2I() {}
+    explicit Vec2I(const int* v) { for (int i = 0; i < 2; ++i) data[i] = v[i]; }
+    Vec2I(int v0, int v1) { data[0] = v0; data[1] = v1; }
+
+    int data[2];
+};
+
+/// 4D vector of int items
+struct Vec4I
+{
+    Vec4I() {}
+    explicit Vec4I(const int* v) { for (int i = 0; i < 4; ++i) data[i] = v[i]; }
+    Vec4I(int v0, int v1, int v2, int v3) { data[0] = v0; data[1] = v1; data[2] = v2; data[3] = v3; }
+
+    int data[4];
+};
+
+} // namespace Vuforia
+
+#endif // _VUFORIA_VECTORS_H_
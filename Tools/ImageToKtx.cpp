@@ -0,0 +1,676 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Offline converter from images to ETC2 compressed KTX textures.
+//
+// Usage: ImageToKtx input.jpg|input.png|input.ppm output.ktx
+//        ImageToKtx -v file.ktx [file.ktx ...]
+//        ImageToKtx -m iterations
+//        ImageToKtx -d iterations image [image ...]
+//
+// The image is written as ETC2 RGB8 with a full mip chain, bottom row first
+// like the textures decoded by the app. Name the output <texture>.etc2.ktx
+// and add it to the app assets, the renderer loads it in preference to the
+// JPEG. JPEG and PNG images are read with ImageDecoder, the decoder of the
+// app, other formats can be converted to a binary PPM first.
+// Blocks are encoded with the ETC1 modes, which ETC2 decoders read
+// unchanged, searching both subblock orientations, individual and
+// differential base colors and every modifier table. The PSNR of level 0
+// and the size compared with uncompressed RGBA8 are reported.
+// With -v KTX files are validated, e.g. ASTC files written by astcenc, and
+// their size and parse time are reported.
+// With -m the SIMD mipmap downsampler is checked against the scalar one on
+// images of assorted sizes and both are timed on a 2048x2048 image.
+// With -d the decode throughput of ImageDecoder is measured, e.g. on the
+// JPEG assets of the app.
+
+#include <FileAssetSource.h>
+#include <ImageDecoder.h>
+#include <KtxTexture.h>
+#include <MipmapGenerator.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    /// GL_RGB, the base internal format of ETC2 RGB8
+    constexpr uint32_t GL_RGB_FORMAT = 0x1907;
+
+    /// An RGBA8 image, the alpha of PPM images is opaque
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+
+        const uint8_t* at(uint32_t x, uint32_t y) const
+        {
+            // Blocks past the edge repeat the last row and column
+            x = std::min(x, width - 1);
+            y = std::min(y, height - 1);
+            return &pixels[(size_t(y) * width + x) * MipmapGenerator::PIXEL_SIZE];
+        }
+    };
+
+
+    /// Skip whitespace and comments in a PPM header
+    void skipPpmSpace(const char*& p, const char* end)
+    {
+        while (p < end && (isspace(static_cast<unsigned char>(*p)) || *p == '#'))
+        {
+            if (*p == '#')
+            {
+                while (p < end && *p != '\n')
+                {
+                    ++p;
+                }
+            }
+            else
+            {
+                ++p;
+            }
+        }
+    }
+
+
+    unsigned readPpmNumber(const char*& p, const char* end)
+    {
+        skipPpmSpace(p, end);
+        unsigned value = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            value = value * 10 + static_cast<unsigned>(*p - '0');
+            ++p;
+        }
+        return value;
+    }
+
+
+    /// Read a binary PPM (P6) with 8-bit samples
+    bool readPpm(const char* filename, const Asset& asset, Image& image)
+    {
+        const char* p = asset.getData() + 2;
+        const char* end = asset.getData() + asset.getSize();
+        image.width = readPpmNumber(p, end);
+        image.height = readPpmNumber(p, end);
+        unsigned maxValue = readPpmNumber(p, end);
+        // A single whitespace character separates the header from the samples
+        ++p;
+
+        size_t pixelCount = size_t(image.width) * image.height;
+        if (image.width == 0 || image.height == 0 || maxValue != 255 || p > end || size_t(end - p) < pixelCount * 3)
+        {
+            fprintf(stderr, "%s: unsupported or truncated PPM\n", filename);
+            return false;
+        }
+        image.pixels.resize(pixelCount * MipmapGenerator::PIXEL_SIZE);
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            // Bottom row first
+            size_t x = i % image.width;
+            size_t y = image.height - 1 - i / image.width;
+            uint8_t* out = &image.pixels[(y * image.width + x) * MipmapGenerator::PIXEL_SIZE];
+            memcpy(out, p + i * 3, 3);
+            out[3] = 255;
+        }
+        return true;
+    }
+
+
+    /// Read a JPEG, PNG or PPM image, bottom row first
+    bool readImage(const char* filename, Image& image)
+    {
+        std::unique_ptr<Asset> asset = FileAssetSource().open(filename);
+        if (asset == nullptr)
+        {
+            fprintf(stderr, "Cannot open %s\n", filename);
+            return false;
+        }
+        if (asset->getSize() >= 2 && memcmp(asset->getData(), "P6", 2) == 0)
+        {
+            return readPpm(filename, *asset, image);
+        }
+
+        ImageDecoder::Info info;
+        if (!ImageDecoder::getInfo(asset->getData(), asset->getSize(), info))
+        {
+            fprintf(stderr, "%s is not a supported image\n", filename);
+            return false;
+        }
+        image.width = info.width;
+        image.height = info.height;
+        image.pixels.resize(size_t(info.width) * info.height * ImageDecoder::PIXEL_SIZE);
+        if (!ImageDecoder::decode(asset->getData(), asset->getSize(), image.pixels.data(),
+                                  size_t(info.width) * ImageDecoder::PIXEL_SIZE, true))
+        {
+            fprintf(stderr, "%s: decoding failed\n", filename);
+            return false;
+        }
+        return true;
+    }
+
+
+    /// Next mip level, each texel the average of a 2x2 box
+    Image downsample(const Image& image)
+    {
+        Image level;
+        level.width = std::max(image.width / 2, 1u);
+        level.height = std::max(image.height / 2, 1u);
+        level.pixels.resize(size_t(level.width) * level.height * MipmapGenerator::PIXEL_SIZE);
+        MipmapGenerator::downsample(image.pixels.data(), image.width, image.height, level.pixels.data());
+        return level;
+    }
+
+
+    /// Intensity modifiers of the ETC1 tables, in the order of the pixel index values
+    const int ETC_MODIFIERS[8][4] =
+    {
+        { 2, 8, -2, -8 }, { 5, 17, -5, -17 }, { 9, 29, -9, -29 }, { 13, 42, -13, -42 },
+        { 18, 60, -18, -60 }, { 24, 80, -24, -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 },
+    };
+
+    int clamp255(int value)
+    {
+        return std::min(std::max(value, 0), 255);
+    }
+
+    /// Subblock of a pixel, pixels are numbered x * 4 + y as in the index bits
+    int getSubblock(int pixel, bool flip)
+    {
+        return flip ? (pixel % 4) / 2 : (pixel / 4) / 2;
+    }
+
+
+    /// Best table and pixel indices of a subblock for a base color
+    struct SubblockFit
+    {
+        int table = 0;
+        uint32_t error = 0;
+        uint8_t indices[16] = {};
+    };
+
+    SubblockFit fitSubblock(const uint8_t block[16][3], int subblock, bool flip, const int base[3])
+    {
+        SubblockFit best;
+        best.error = UINT32_MAX;
+        for (int table = 0; table < 8; ++table)
+        {
+            SubblockFit fit;
+            fit.table = table;
+            for (int pixel = 0; pixel < 16 && fit.error < best.error; ++pixel)
+            {
+                if (getSubblock(pixel, flip) != subblock)
+                {
+                    continue;
+                }
+                uint32_t pixelError = UINT32_MAX;
+                for (int index = 0; index < 4; ++index)
+                {
+                    uint32_t error = 0;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        int d = clamp255(base[c] + ETC_MODIFIERS[table][index]) - block[pixel][c];
+                        error += static_cast<uint32_t>(d * d);
+                    }
+                    if (error < pixelError)
+                    {
+                        pixelError = error;
+                        fit.indices[pixel] = static_cast<uint8_t>(index);
+                    }
+                }
+                fit.error += pixelError;
+            }
+            if (fit.error < best.error)
+            {
+                best = fit;
+            }
+        }
+        return best;
+    }
+
+
+    /// Encode a 4x4 block, block[x * 4 + y] is the pixel at (x, y)
+    /// Returns the 64-bit block, the most significant byte is written first.
+    uint64_t encodeBlock(const uint8_t block[16][3])
+    {
+        uint64_t bestBits = 0;
+        uint32_t bestError = UINT32_MAX;
+
+        for (int flip = 0; flip < 2; ++flip)
+        {
+            int sum[2][3] = {};
+            for (int pixel = 0; pixel < 16; ++pixel)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    sum[getSubblock(pixel, flip != 0)][c] += block[pixel][c];
+                }
+            }
+
+            for (int differential = 0; differential < 2; ++differential)
+            {
+                int quantized[2][3];
+                int base[2][3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    for (int s = 0; s < 2; ++s)
+                    {
+                        // Average of 8 pixels, rounded to 4 or 5 bits
+                        quantized[s][c] = differential ? (sum[s][c] * 31 + 8 * 255 / 2) / (8 * 255)
+                                                       : (sum[s][c] * 15 + 8 * 255 / 2) / (8 * 255);
+                    }
+                    if (differential)
+                    {
+                        // The second color is stored as a 3-bit delta from the first
+                        int delta = std::min(std::max(quantized[1][c] - quantized[0][c], -4), 3);
+                        quantized[1][c] = quantized[0][c] + delta;
+                        base[0][c] = (quantized[0][c] << 3) | (quantized[0][c] >> 2);
+                        base[1][c] = (quantized[1][c] << 3) | (quantized[1][c] >> 2);
+                    }
+                    else
+                    {
+                        base[0][c] = quantized[0][c] * 17;
+                        base[1][c] = quantized[1][c] * 17;
+                    }
+                }
+
+                SubblockFit fits[2] =
+                {
+                    fitSubblock(block, 0, flip != 0, base[0]),
+                    fitSubblock(block, 1, flip != 0, base[1]),
+                };
+                uint32_t error = fits[0].error + fits[1].error;
+                if (error >= bestError)
+                {
+                    continue;
+                }
+                bestError = error;
+
+                uint32_t high = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    int shift = 24 - 8 * c;
+                    if (differential)
+                    {
+                        uint32_t delta = static_cast<uint32_t>(quantized[1][c] - quantized[0][c]) & 7;
+                        high |= (static_cast<uint32_t>(quantized[0][c]) << 3 | delta) << shift;
+                    }
+                    else
+                    {
+                        high |= (static_cast<uint32_t>(quantized[0][c]) << 4 |
+                                 static_cast<uint32_t>(quantized[1][c])) << shift;
+                    }
+                }
+                high |= static_cast<uint32_t>(fits[0].table) << 5 | static_cast<uint32_t>(fits[1].table) << 2;
+                high |= static_cast<uint32_t>(differential) << 1 | static_cast<uint32_t>(flip);
+
+                uint32_t low = 0;
+                for (int pixel = 0; pixel < 16; ++pixel)
+                {
+                    uint32_t index = fits[getSubblock(pixel, flip != 0)].indices[pixel];
+                    low |= (index >> 1) << (16 + pixel) | (index & 1) << pixel;
+                }
+                bestBits = static_cast<uint64_t>(high) << 32 | low;
+            }
+        }
+        return bestBits;
+    }
+
+
+    /// Decode a block written by encodeBlock, for the PSNR
+    void decodeBlock(uint64_t bits, uint8_t block[16][3])
+    {
+        uint32_t high = static_cast<uint32_t>(bits >> 32);
+        uint32_t low = static_cast<uint32_t>(bits);
+        bool flip = (high & 1) != 0;
+        bool differential = (high & 2) != 0;
+        int tables[2] = { static_cast<int>(high >> 5 & 7), static_cast<int>(high >> 2 & 7) };
+
+        int base[2][3];
+        for (int c = 0; c < 3; ++c)
+        {
+            uint32_t byte = high >> (24 - 8 * c) & 0xFF;
+            if (differential)
+            {
+                int first = static_cast<int>(byte >> 3);
+                int delta = static_cast<int>(byte & 7);
+                int second = first + (delta >= 4 ? delta - 8 : delta);
+                base[0][c] = (first << 3) | (first >> 2);
+                base[1][c] = (second << 3) | (second >> 2);
+            }
+            else
+            {
+                base[0][c] = static_cast<int>(byte >> 4) * 17;
+                base[1][c] = static_cast<int>(byte & 15) * 17;
+            }
+        }
+
+        for (int pixel = 0; pixel < 16; ++pixel)
+        {
+            int subblock = getSubblock(pixel, flip);
+            int index = static_cast<int>((low >> (16 + pixel) & 1) << 1 | (low >> pixel & 1));
+            for (int c = 0; c < 3; ++c)
+            {
+                block[pixel][c] = static_cast<uint8_t>(
+                    clamp255(base[subblock][c] + ETC_MODIFIERS[tables[subblock]][index]));
+            }
+        }
+    }
+
+
+    /// Encode an image as ETC2 RGB8, sumSquaredError accumulates the encoding error
+    std::vector<char> encodeImage(const Image& image, double& sumSquaredError)
+    {
+        uint32_t blocksX = (image.width + 3) / 4;
+        uint32_t blocksY = (image.height + 3) / 4;
+        std::vector<char> data(size_t(blocksX) * blocksY * 8);
+        char* out = data.data();
+        sumSquaredError = 0.0;
+
+        for (uint32_t by = 0; by < blocksY; ++by)
+        {
+            for (uint32_t bx = 0; bx < blocksX; ++bx)
+            {
+                uint8_t block[16][3];
+                for (int x = 0; x < 4; ++x)
+                {
+                    for (int y = 0; y < 4; ++y)
+                    {
+                        memcpy(block[x * 4 + y], image.at(bx * 4 + x, by * 4 + y), 3);
+                    }
+                }
+
+                uint64_t bits = encodeBlock(block);
+                for (int i = 0; i < 8; ++i)
+                {
+                    *out++ = static_cast<char>(bits >> (56 - 8 * i));
+                }
+
+                uint8_t decoded[16][3];
+                decodeBlock(bits, decoded);
+                for (int x = 0; x < 4; ++x)
+                {
+                    for (int y = 0; y < 4; ++y)
+                    {
+                        if (bx * 4 + x >= image.width || by * 4 + y >= image.height)
+                        {
+                            continue;
+                        }
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            double d = double(decoded[x * 4 + y][c]) - block[x * 4 + y][c];
+                            sumSquaredError += d * d;
+                        }
+                    }
+                }
+            }
+        }
+        return data;
+    }
+
+
+    bool writeFile(const char* filename, const std::vector<char>& data)
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file.write(data.data(), data.size());
+        return file.good();
+    }
+
+
+    /// Size of a texture and its mip chain as uncompressed RGBA8
+    size_t getRgba8Size(uint32_t width, uint32_t height, size_t levelCount)
+    {
+        size_t size = 0;
+        for (size_t i = 0; i < levelCount; ++i)
+        {
+            size += size_t(std::max(width >> i, 1u)) * std::max(height >> i, 1u) * 4;
+        }
+        return size;
+    }
+
+
+    bool convert(const char* inputFilename, const char* outputFilename)
+    {
+        Image image;
+        if (!readImage(inputFilename, image))
+        {
+            return false;
+        }
+
+        auto start = Clock::now();
+        std::vector<std::vector<char>> levels;
+        double level0Error = 0.0;
+        for (Image level = image;; level = downsample(level))
+        {
+            double sumSquaredError;
+            levels.push_back(encodeImage(level, sumSquaredError));
+            if (levels.size() == 1)
+            {
+                level0Error = sumSquaredError;
+            }
+            if (level.width == 1 && level.height == 1)
+            {
+                break;
+            }
+        }
+        double encodeMs = elapsedMs(start);
+
+        std::vector<char> data;
+        KtxTexture::serialize(KtxTexture::COMPRESSED_RGB8_ETC2, GL_RGB_FORMAT, image.width, image.height, levels, data);
+
+        // Check the file reads back as the renderer will read it
+        KtxTexture::View view;
+        if (!KtxTexture::parse(data.data(), data.size(), view) || view.levels.size() != levels.size())
+        {
+            fprintf(stderr, "%s: the encoded texture doesn't parse\n", outputFilename);
+            return false;
+        }
+        if (!writeFile(outputFilename, data))
+        {
+            fprintf(stderr, "Cannot write %s\n", outputFilename);
+            return false;
+        }
+
+        double mse = level0Error / (double(image.width) * image.height * 3);
+        double psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY;
+        size_t rgba8Size = getRgba8Size(image.width, image.height, levels.size());
+        printf("%s: ETC2 RGB8 %ux%u, %zu levels, %zu bytes (%zu as RGBA8, %.1fx smaller), "
+               "level 0 PSNR %.2f dB, encoded in %.0f ms\n",
+               outputFilename, image.width, image.height, levels.size(), data.size(), rgba8Size,
+               double(rgba8Size) / data.size(), psnr, encodeMs);
+        return true;
+    }
+
+
+    /// Check the SIMD downsampler matches the scalar one and time both
+    bool checkMipmapGenerator(int iterations)
+    {
+        std::mt19937 random(42);
+        std::uniform_int_distribution<int> byte(0, 255);
+        auto makeImage = [&](uint32_t width, uint32_t height)
+        {
+            std::vector<uint8_t> pixels(size_t(width) * height * MipmapGenerator::PIXEL_SIZE);
+            for (uint8_t& value : pixels)
+            {
+                value = static_cast<uint8_t>(byte(random));
+            }
+            return pixels;
+        };
+
+        // Odd sizes, single rows and columns and sizes around the 4 texel vector width
+        const uint32_t SIZES[] = { 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 64, 129 };
+        int sizeCount = 0;
+        int mismatches = 0;
+        for (uint32_t width : SIZES)
+        {
+            for (uint32_t height : SIZES)
+            {
+                std::vector<uint8_t> source = makeImage(width, height);
+                size_t size = size_t(std::max(width / 2, 1u)) * std::max(height / 2, 1u) * MipmapGenerator::PIXEL_SIZE;
+                std::vector<uint8_t> vector(size), scalar(size);
+                MipmapGenerator::downsample(source.data(), width, height, vector.data());
+                MipmapGenerator::downsampleScalar(source.data(), width, height, scalar.data());
+                ++sizeCount;
+                if (vector != scalar)
+                {
+                    fprintf(stderr, "Mismatch downsampling %ux%u\n", width, height);
+                    ++mismatches;
+                }
+            }
+        }
+
+        const uint32_t SIZE = 2048;
+        std::vector<uint8_t> source = makeImage(SIZE, SIZE);
+        std::vector<uint8_t> destination(size_t(SIZE / 2) * (SIZE / 2) * MipmapGenerator::PIXEL_SIZE);
+        double megabytes = double(source.size()) / (1024.0 * 1024.0);
+
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            MipmapGenerator::downsample(source.data(), SIZE, SIZE, destination.data());
+        }
+        double vectorMs = elapsedMs(start) / iterations;
+
+        start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            MipmapGenerator::downsampleScalar(source.data(), SIZE, SIZE, destination.data());
+        }
+        double scalarMs = elapsedMs(start) / iterations;
+
+        start = Clock::now();
+        std::vector<std::vector<uint8_t>> levels;
+        for (int i = 0; i < iterations; ++i)
+        {
+            MipmapGenerator::generate(source.data(), SIZE, SIZE, levels);
+        }
+        double chainMs = elapsedMs(start) / iterations;
+
+        printf("Downsample %ux%u RGBA8: %s %.2f ms (%.0f MB/s), scalar %.2f ms (%.0f MB/s), %.1fx\n",
+               SIZE, SIZE, MipmapGenerator::getKernelName(), vectorMs, megabytes * 1000.0 / vectorMs,
+               scalarMs, megabytes * 1000.0 / scalarMs, scalarMs / vectorMs);
+        printf("Full mip chain of %zu levels: %.2f ms\n", levels.size(), chainMs);
+        printf("%d of %d sizes differ from the scalar version\n", mismatches, sizeCount);
+        return mismatches == 0;
+    }
+
+
+    /// Time decoding an image with ImageDecoder
+    bool benchmarkDecode(const char* filename, int iterations)
+    {
+        std::unique_ptr<Asset> asset = FileAssetSource().open(filename);
+        ImageDecoder::Info info;
+        if (asset == nullptr || !ImageDecoder::getInfo(asset->getData(), asset->getSize(), info))
+        {
+            fprintf(stderr, "%s is not a supported image\n", filename);
+            return false;
+        }
+
+        const size_t stride = size_t(info.width) * ImageDecoder::PIXEL_SIZE;
+        std::vector<uint8_t> pixels(stride * info.height);
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            if (!ImageDecoder::decode(asset->getData(), asset->getSize(), pixels.data(), stride, true))
+            {
+                fprintf(stderr, "%s: decoding failed\n", filename);
+                return false;
+            }
+        }
+        double decodeMs = elapsedMs(start) / iterations;
+
+        printf("%s: %s %ux%u, %zu bytes, decoded in %.2f ms (%.1f MB/s in, %.1f Mpixel/s)\n",
+               filename, info.format == ImageDecoder::FORMAT_JPEG ? "JPEG" : "PNG", info.width, info.height,
+               asset->getSize(), decodeMs, asset->getSize() / (1024.0 * 1024.0) * 1000.0 / decodeMs,
+               double(info.width) * info.height / 1000.0 / decodeMs);
+        return true;
+    }
+
+
+    bool validate(const char* filename)
+    {
+        std::unique_ptr<Asset> asset = FileAssetSource().open(filename);
+        if (asset == nullptr)
+        {
+            fprintf(stderr, "Cannot open %s\n", filename);
+            return false;
+        }
+
+        auto start = Clock::now();
+        KtxTexture::View view;
+        bool valid = KtxTexture::parse(asset->getData(), asset->getSize(), view);
+        double parseMs = elapsedMs(start);
+        if (!valid)
+        {
+            fprintf(stderr, "%s: invalid KTX file\n", filename);
+            return false;
+        }
+
+        size_t rgba8Size = getRgba8Size(view.header.pixelWidth, view.header.pixelHeight, view.levels.size());
+        printf("%s: %s %ux%u, %zu levels, %zu bytes (%zu as RGBA8, %.1fx smaller), parsed in %.3f ms\n",
+               filename, KtxTexture::getFormatName(view.header.glInternalFormat),
+               view.header.pixelWidth, view.header.pixelHeight, view.levels.size(), asset->getSize(),
+               rgba8Size, double(rgba8Size) / asset->getSize(), parseMs);
+        return true;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc >= 3 && strcmp(argv[1], "-v") == 0)
+    {
+        bool valid = true;
+        for (int arg = 2; arg < argc; ++arg)
+        {
+            valid = validate(argv[arg]) && valid;
+        }
+        return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (argc >= 4 && strcmp(argv[1], "-d") == 0)
+    {
+        int iterations = atoi(argv[2]);
+        bool decoded = iterations > 0;
+        for (int arg = 3; arg < argc && decoded; ++arg)
+        {
+            decoded = benchmarkDecode(argv[arg], iterations);
+        }
+        return decoded ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (argc == 3 && strcmp(argv[1], "-m") == 0)
+    {
+        int iterations = atoi(argv[2]);
+        return iterations > 0 && checkMipmapGenerator(iterations) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s input.jpg|input.png|input.ppm output.ktx\n"
+                        "       %s -v file.ktx [file.ktx ...]\n"
+                        "       %s -m iterations\n"
+                        "       %s -d iterations image [image ...]\n", argv[0], argv[0], argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+    return convert(argv[1], argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
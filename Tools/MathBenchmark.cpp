@@ -0,0 +1,984 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Check and microbenchmark of the MathUtils vector kernels.
+//
+// Usage: MathBenchmark [iterations]
+//        MathBenchmark -b vertices [threads]
+//        MathBenchmark -f frames
+//        MathBenchmark -q quaternions
+//        MathBenchmark -t multiply|rigid|batch|core|quaternions
+//
+// The SIMD versions of multiplyMatrix, Vec4FTransform and Vec3FTransform
+// are compared with the scalar versions on random inputs, including
+// results written over an input. Elements must be within the rounding
+// error bound of a 4 term dot product of each other, the number which are
+// bitwise identical is reported.
+// Matrix44FRigidInverse and Matrix44FViewFromPose are compared with the
+// general inverse on random rotation and translation poses, and the
+// product of each inverse with its pose with the identity.
+// The batch transforms are compared with the single vertex functions on
+// AoS and SoA arrays of assorted lengths, split between threads and in
+// place. Normals are compared with the general inverse.
+// Each function is then timed over a set of matrices for the given number
+// of iterations, 1000 by default.
+// With -b the batch transforms are timed on arrays of the given number of
+// vertices, with one thread and with the given number of threads, all the
+// cores by default, and their throughput is reported in vertices/second.
+// With -f the matrix work of a frame of the image target sample, the view
+// matrix and the model view, scaled, cube and axis matrices of each
+// target, is timed through MathUtils, through the matrix functions of
+// MathCore.h on the Vuforia matrices and through Mat4 values, after
+// checking all three give the same matrices.
+// The quaternion and dual quaternion conversions are compared with the
+// matrices of random poses, slerp with the angles it should rotate by,
+// and the batch interpolations with the single ones. With -q the batch
+// interpolations are timed on arrays of the given number of quaternions
+// against a loop of single interpolations.
+// With -t only the named check is run, nothing is timed, ctest runs each.
+
+#include <MathCore.h>
+#include <MathUtils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    /// Matrices and vectors the benchmark iterates over
+    constexpr size_t SET_SIZE = 1024;
+
+    /// Random inputs compared between the kernels
+    constexpr int CHECK_COUNT = 100000;
+
+    /// Counts of the compared elements
+    struct Comparison
+    {
+        size_t elements = 0;
+        size_t identical = 0;
+        size_t failures = 0;
+
+        /// Compare an element, bound is the sum of the magnitudes of its terms
+        void add(float simd, float scalar, float bound)
+        {
+            ++elements;
+            if (memcmp(&simd, &scalar, sizeof(float)) == 0)
+            {
+                ++identical;
+            }
+            // Each result is within 4 epsilon of the exact dot product
+            else if (std::fabs(simd - scalar) > 8.0f * FLT_EPSILON * bound)
+            {
+                ++failures;
+            }
+        }
+
+        bool report(const char* name) const
+        {
+            printf("%-16s %zu elements, %zu bitwise identical, %zu outside tolerance\n",
+                   name, elements, identical, failures);
+            return failures == 0;
+        }
+    };
+
+
+    Vuforia::Matrix44F randomMatrix(std::mt19937& random)
+    {
+        // Exponents spread over a few orders of magnitude, like poses scaled to targets
+        std::uniform_real_distribution<float> mantissa(-1.0f, 1.0f);
+        std::uniform_int_distribution<int> exponent(-4, 4);
+        Vuforia::Matrix44F m;
+        for (float& value : m.data)
+        {
+            value = std::ldexp(mantissa(random), exponent(random));
+        }
+        return m;
+    }
+
+
+    /// A random rotation with a translation of up to 5 m, like the device poses
+    Vuforia::Matrix34F randomPose(std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        Vuforia::Vec3F axis(unit(random), unit(random), unit(random));
+        if (MathUtils::Vec3FNorm(axis) < 0.01f)
+        {
+            axis = Vuforia::Vec3F(0.0f, 0.0f, 1.0f);
+        }
+        Vuforia::Matrix44F rotation;
+        MathUtils::makeRotationMatrix(180.0f * unit(random), MathUtils::Vec3FNormalize(axis), rotation);
+
+        // Rows of the 3x4 pose are the rows of the rotation and the translation
+        Vuforia::Matrix34F pose;
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                pose.data[row * 4 + column] = rotation.data[column * 4 + row];
+            }
+            pose.data[row * 4 + 3] = 5.0f * unit(random);
+        }
+        return pose;
+    }
+
+
+    /// The GL matrix of a pose, as Vuforia::Tool::convertPose2GLMatrix returns it
+    Vuforia::Matrix44F poseToMatrix(const Vuforia::Matrix34F& pose)
+    {
+        Vuforia::Matrix44F m;
+        for (int column = 0; column < 4; ++column)
+        {
+            for (int row = 0; row < 3; ++row)
+            {
+                m.data[column * 4 + row] = pose.data[row * 4 + column];
+            }
+            m.data[column * 4 + 3] = column == 3 ? 1.0f : 0.0f;
+        }
+        return m;
+    }
+
+
+    /// Largest difference between the elements of two matrices
+    float maxDifference(const Vuforia::Matrix44F& a, const Vuforia::Matrix44F& b)
+    {
+        float difference = 0.0f;
+        for (int element = 0; element < 16; ++element)
+        {
+            difference = std::max(difference, std::fabs(a.data[element] - b.data[element]));
+        }
+        return difference;
+    }
+
+
+    /// Largest difference between m * inverse and the identity
+    float identityError(const Vuforia::Matrix44F& m, const Vuforia::Matrix44F& inverse)
+    {
+        Vuforia::Matrix44F product;
+        MathUtils::multiplyMatrix(m, inverse, product);
+        return maxDifference(product, MathUtils::Matrix44FIdentity());
+    }
+
+
+    bool checkRigidInverse()
+    {
+        std::mt19937 random(22);
+        float rigidDifference = 0.0f;
+        float viewDifference = 0.0f;
+        float generalError = 0.0f;
+        float rigidError = 0.0f;
+
+        for (int i = 0; i < CHECK_COUNT; ++i)
+        {
+            Vuforia::Matrix34F pose = randomPose(random);
+            Vuforia::Matrix44F m = poseToMatrix(pose);
+
+            // The expression AppController used for the view matrix
+            Vuforia::Matrix44F general = MathUtils::Matrix44FTranspose(MathUtils::Matrix44FInverse(m));
+            Vuforia::Matrix44F rigid = MathUtils::Matrix44FRigidInverse(m);
+            Vuforia::Matrix44F view = MathUtils::Matrix44FViewFromPose(pose);
+
+            rigidDifference = std::max(rigidDifference, maxDifference(rigid, general));
+            viewDifference = std::max(viewDifference, maxDifference(view, rigid));
+            generalError = std::max(generalError, identityError(m, general));
+            rigidError = std::max(rigidError, identityError(m, rigid));
+        }
+
+        printf("Rigid inverse: max difference %g from the general inverse, %g between the two rigid versions\n",
+               rigidDifference, viewDifference);
+        printf("               max error of pose * inverse from identity %g, %g for the general inverse\n",
+               rigidError, generalError);
+        // Translations of up to 5 m in single precision
+        return rigidDifference < 1e-5f && viewDifference == 0.0f && rigidError < 1e-5f;
+    }
+
+
+    /// Random coordinates for count vertices
+    std::vector<float> randomVertices(std::mt19937& random, size_t count)
+    {
+        std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+        std::vector<float> vertices(count * 3);
+        for (float& value : vertices)
+        {
+            value = coordinate(random);
+        }
+        return vertices;
+    }
+
+
+    /// Largest difference between a batch transform of vertices and transformVertex applied to each
+    template <typename Batch, typename Single>
+    float compareBatch(const std::vector<float>& vertices, Batch batch, Single transformVertex)
+    {
+        const size_t count = vertices.size() / 3;
+        std::vector<float> aos(vertices.size());
+        batch(vertices.data(), aos.data(), count, false);
+
+        // In place
+        std::vector<float> inPlace = vertices;
+        batch(inPlace.data(), inPlace.data(), count, false);
+
+        // Separate x, y and z arrays, split between threads
+        std::vector<float> soa(vertices.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            soa[i] = vertices[i * 3];
+            soa[count + i] = vertices[i * 3 + 1];
+            soa[2 * count + i] = vertices[i * 3 + 2];
+        }
+        std::vector<float> soaResult(vertices.size());
+        batch(soa.data(), soaResult.data(), count, true);
+
+        float difference = 0.0f;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Vuforia::Vec3F expected = transformVertex(Vuforia::Vec3F(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]));
+            for (int c = 0; c < 3; ++c)
+            {
+                difference = std::max(difference, std::fabs(aos[i * 3 + c] - expected.data[c]));
+                difference = std::max(difference, std::fabs(inPlace[i * 3 + c] - expected.data[c]));
+                difference = std::max(difference, std::fabs(soaResult[c * count + i] - expected.data[c]));
+            }
+        }
+        return difference;
+    }
+
+
+    bool checkBatch()
+    {
+        std::mt19937 random(23);
+        const unsigned int threadCount = 4;
+        // Tails of every length, one and several ranges per thread
+        const size_t counts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 1001, 65536 + 3, 200003 };
+
+        float pointDifference = 0.0f;
+        float directionDifference = 0.0f;
+        float normalDifference = 0.0f;
+        for (size_t count : counts)
+        {
+            Vuforia::Matrix44F m = randomMatrix(random);
+            m.data[3] = m.data[7] = m.data[11] = 0.0f;
+            m.data[15] = 1.0f;
+            std::vector<float> vertices = randomVertices(random, count);
+
+            // SoA batches read x, y and z from thirds of the array, see compareBatch
+            pointDifference = std::max(pointDifference, compareBatch(vertices,
+                [&](const float* in, float* out, size_t n, bool soa)
+                {
+                    if (soa)
+                        MathUtils::transformPointsSoA(m, in, in + n, in + 2 * n, out, out + n, out + 2 * n, n, threadCount);
+                    else
+                        MathUtils::transformPoints(m, in, out, n);
+                },
+                [&](const Vuforia::Vec3F& v) { return MathUtils::Vec3FTransform(m, v); }));
+
+            directionDifference = std::max(directionDifference, compareBatch(vertices,
+                [&](const float* in, float* out, size_t n, bool soa)
+                {
+                    if (soa)
+                        MathUtils::transformDirectionsSoA(m, in, in + n, in + 2 * n, out, out + n, out + 2 * n, n, threadCount);
+                    else
+                        MathUtils::transformDirections(m, in, out, n);
+                },
+                [&](const Vuforia::Vec3F& v) { return MathUtils::Vec3FTransformNormal(m, v); }));
+
+            // Matrix44FInverse returns the inverse transpose, the normal matrix
+            Vuforia::Matrix44F inverseTranspose = MathUtils::Matrix44FInverse(m);
+            normalDifference = std::max(normalDifference, compareBatch(vertices,
+                [&](const float* in, float* out, size_t n, bool soa)
+                {
+                    if (soa)
+                        MathUtils::transformNormalsSoA(m, in, in + n, in + 2 * n, out, out + n, out + 2 * n, n, threadCount);
+                    else
+                        MathUtils::transformNormals(m, in, out, n);
+                },
+                [&](const Vuforia::Vec3F& v)
+                {
+                    return MathUtils::Vec3FNormalize(MathUtils::Vec3FTransformNormal(inverseTranspose, v));
+                }));
+        }
+
+        printf("Batch transforms: max difference %g for points, %g for directions, %g for normals\n",
+               pointDifference, directionDifference, normalDifference);
+        // Points and directions use the single vertex operations, normals a different inverse
+        return pointDifference == 0.0f && directionDifference == 0.0f && normalDifference < 1e-5f;
+    }
+
+
+    /// Time a batch over count vertices, returns millions of vertices per second
+    template <typename Batch>
+    double timeBatch(size_t count, Batch batch, size_t total = 200000000)
+    {
+        // Enough repetitions for about a second at a few hundred million vertices per second
+        const int repetitions = static_cast<int>(std::max<size_t>(1, total / std::max<size_t>(count, 1)));
+        batch();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i)
+        {
+            batch();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return double(count) * repetitions / elapsed.count() / 1e6;
+    }
+
+
+    void benchmarkBatch(size_t count, unsigned int threadCount)
+    {
+        std::mt19937 random(1);
+        Vuforia::Matrix44F m = randomMatrix(random);
+        std::vector<float> vertices = randomVertices(random, count);
+        std::vector<float> result(vertices.size());
+        const float* x = vertices.data();
+        const float* y = x + count;
+        const float* z = y + count;
+        float* resultX = result.data();
+        float* resultY = resultX + count;
+        float* resultZ = resultY + count;
+
+        double single = timeBatch(count, [&]()
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                Vuforia::Vec3F v = MathUtils::Vec3FTransform(m, Vuforia::Vec3F(x[i * 3], x[i * 3 + 1], x[i * 3 + 2]));
+                resultX[i * 3] = v.data[0];
+                resultX[i * 3 + 1] = v.data[1];
+                resultX[i * 3 + 2] = v.data[2];
+            }
+        });
+
+        printf("%zu vertices, %s kernels, millions of vertices per second:\n", count, MathUtils::getKernelName());
+        printf("  Vec3FTransform per vertex %8.1f\n", single);
+        printf("  %-24s %8s %8s\n", "", "1 thread", "threads");
+        printf("  %-24s %8s %8u\n", "", "", threadCount);
+        printf("  %-24s %8.1f %8.1f\n", "transformPoints",
+               timeBatch(count, [&]() { MathUtils::transformPoints(m, x, resultX, count, 1); }),
+               timeBatch(count, [&]() { MathUtils::transformPoints(m, x, resultX, count, threadCount); }));
+        printf("  %-24s %8.1f %8.1f\n", "transformPointsSoA",
+               timeBatch(count, [&]() { MathUtils::transformPointsSoA(m, x, y, z, resultX, resultY, resultZ, count, 1); }),
+               timeBatch(count, [&]() { MathUtils::transformPointsSoA(m, x, y, z, resultX, resultY, resultZ, count, threadCount); }));
+        printf("  %-24s %8.1f %8.1f\n", "transformNormals",
+               timeBatch(count, [&]() { MathUtils::transformNormals(m, x, resultX, count, 1); }),
+               timeBatch(count, [&]() { MathUtils::transformNormals(m, x, resultX, count, threadCount); }));
+        printf("  %-24s %8.1f %8.1f\n", "transformNormalsSoA",
+               timeBatch(count, [&]() { MathUtils::transformNormalsSoA(m, x, y, z, resultX, resultY, resultZ, count, 1); }),
+               timeBatch(count, [&]() { MathUtils::transformNormalsSoA(m, x, y, z, resultX, resultY, resultZ, count, threadCount); }));
+    }
+
+
+    /// Sum of the magnitudes of the terms of element (row, column) of a * b
+    float productBound(const Vuforia::Matrix44F& a, const Vuforia::Matrix44F& b, int row, int column)
+    {
+        float bound = 0.0f;
+        for (int k = 0; k < 4; ++k)
+        {
+            bound += std::fabs(a.data[k * 4 + row] * b.data[column * 4 + k]);
+        }
+        return bound;
+    }
+
+
+    bool check()
+    {
+        std::mt19937 random(2020);
+        Comparison matrices;
+        Comparison aliased;
+        Comparison vectors4;
+        Comparison vectors3;
+
+        for (int i = 0; i < CHECK_COUNT; ++i)
+        {
+            Vuforia::Matrix44F a = randomMatrix(random);
+            Vuforia::Matrix44F b = randomMatrix(random);
+
+            Vuforia::Matrix44F simd;
+            Vuforia::Matrix44F scalar;
+            MathUtils::multiplyMatrix(a, b, simd);
+            MathUtils::multiplyMatrixScalar(a, b, scalar);
+            for (int element = 0; element < 16; ++element)
+            {
+                matrices.add(simd.data[element], scalar.data[element], productBound(a, b, element % 4, element / 4));
+            }
+
+            // The result written over either input, as AppController does
+            Vuforia::Matrix44F overA = a;
+            Vuforia::Matrix44F overB = b;
+            MathUtils::multiplyMatrix(overA, b, overA);
+            MathUtils::multiplyMatrix(a, overB, overB);
+            for (int element = 0; element < 16; ++element)
+            {
+                aliased.add(overA.data[element], simd.data[element], 0.0f);
+                aliased.add(overB.data[element], simd.data[element], 0.0f);
+            }
+
+            // Vectors from the columns of b, w = 1 for the 3D transform
+            Vuforia::Vec4F v4(b.data[0], b.data[1], b.data[2], b.data[3]);
+            Vuforia::Vec4F r4 = MathUtils::Vec4FTransform(a, v4);
+            Vuforia::Vec4F s4 = MathUtils::Vec4FTransformScalar(a, v4);
+            for (int row = 0; row < 4; ++row)
+            {
+                vectors4.add(r4.data[row], s4.data[row], productBound(a, b, row, 0));
+            }
+
+            Vuforia::Vec3F v3(b.data[4], b.data[5], b.data[6]);
+            Vuforia::Vec3F r3 = MathUtils::Vec3FTransform(a, v3);
+            Vuforia::Vec3F s3 = MathUtils::Vec3FTransformScalar(a, v3);
+            for (int row = 0; row < 3; ++row)
+            {
+                float bound = std::fabs(a.data[12 + row]);
+                for (int k = 0; k < 3; ++k)
+                {
+                    bound += std::fabs(a.data[k * 4 + row] * v3.data[k]);
+                }
+                vectors3.add(r3.data[row], s3.data[row], bound);
+            }
+        }
+
+        printf("Kernels: %s\n", MathUtils::getKernelName());
+        bool passed = matrices.report("multiplyMatrix");
+        // Writing over an input must not change the result at all
+        passed = aliased.report("  in place") && aliased.identical == aliased.elements && passed;
+        passed = vectors4.report("Vec4FTransform") && passed;
+        passed = vectors3.report("Vec3FTransform") && passed;
+        return passed;
+    }
+
+
+    /// Targets per simulated frame, as the sample shows with mocked results
+    constexpr size_t FRAME_TARGETS = 16;
+
+    /// Inputs and results of the matrix work of a frame
+    struct Frame
+    {
+        Vuforia::Matrix34F devicePose;
+        std::vector<Vuforia::Matrix44F> targetMatrices;
+        std::vector<Vuforia::Vec3F> targetSizes;
+
+        std::vector<Vuforia::Matrix44F> modelViews;
+        std::vector<Vuforia::Matrix44F> scaledModelViews;
+        std::vector<Vuforia::Matrix44F> cubeModelViews;
+        std::vector<Vuforia::Matrix44F> axisModelViews;
+
+        explicit Frame(std::mt19937& random)
+            : devicePose(randomPose(random)), modelViews(FRAME_TARGETS), scaledModelViews(FRAME_TARGETS),
+              cubeModelViews(FRAME_TARGETS), axisModelViews(FRAME_TARGETS)
+        {
+            std::uniform_real_distribution<float> size(0.05f, 0.5f);
+            for (size_t i = 0; i < FRAME_TARGETS; ++i)
+            {
+                targetMatrices.push_back(poseToMatrix(randomPose(random)));
+                float width = size(random);
+                float height = size(random);
+                targetSizes.emplace_back(width, height, std::max(width, height));
+            }
+        }
+    };
+
+    constexpr float CUBE_SCALE = 0.5f;
+    const Vuforia::Vec3F AXIS_SCALE(0.1f, 0.1f, 0.1f);
+
+
+    /// AppController::getImageTargetResults and the GLESRenderer draws through MathUtils
+    void frameMathUtils(Frame& frame)
+    {
+        Vuforia::Matrix44F viewMatrix = MathUtils::Matrix44FViewFromPose(frame.devicePose);
+        for (size_t i = 0; i < FRAME_TARGETS; ++i)
+        {
+            MathUtils::multiplyMatrix(viewMatrix, frame.targetMatrices[i], frame.modelViews[i]);
+            frame.scaledModelViews[i] = MathUtils::Matrix44FScale(frame.targetSizes[i], frame.modelViews[i]);
+            frame.cubeModelViews[i] = MathUtils::Matrix44FScale(Vuforia::Vec3F(CUBE_SCALE, CUBE_SCALE, CUBE_SCALE),
+                                                                frame.scaledModelViews[i]);
+            frame.axisModelViews[i] = MathUtils::Matrix44FScale(AXIS_SCALE, frame.modelViews[i]);
+        }
+    }
+
+
+    /// frameMathUtils with the matrix functions of MathCore.h on the Vuforia matrices
+    void frameMathCore(Frame& frame)
+    {
+        const Vuforia::Matrix44F viewMatrix = MathUtils::Matrix44FViewFromPose(frame.devicePose);
+        for (size_t i = 0; i < FRAME_TARGETS; ++i)
+        {
+            frame.modelViews[i] = Math::multiply(viewMatrix, frame.targetMatrices[i]);
+            frame.scaledModelViews[i] = Math::scaled(frame.modelViews[i], frame.targetSizes[i]);
+            frame.cubeModelViews[i] = Math::scaled(frame.scaledModelViews[i], Math::Vec3(CUBE_SCALE, CUBE_SCALE, CUBE_SCALE));
+            frame.axisModelViews[i] = Math::scaled(frame.modelViews[i], AXIS_SCALE);
+        }
+    }
+
+
+    /// frameMathUtils with Mat4 values, converting the Vuforia matrices in and out
+    void frameMat4(Frame& frame)
+    {
+        const Math::Mat4 viewMatrix(MathUtils::Matrix44FViewFromPose(frame.devicePose));
+        for (size_t i = 0; i < FRAME_TARGETS; ++i)
+        {
+            const Math::Mat4 modelView = viewMatrix * Math::Mat4(frame.targetMatrices[i]);
+            const Math::Mat4 scaledModelView = modelView.scaled(frame.targetSizes[i]);
+            frame.modelViews[i] = modelView.toMatrix44F();
+            frame.scaledModelViews[i] = scaledModelView.toMatrix44F();
+            frame.cubeModelViews[i] = scaledModelView.scaled(Math::Vec3(CUBE_SCALE, CUBE_SCALE, CUBE_SCALE)).toMatrix44F();
+            frame.axisModelViews[i] = modelView.scaled(AXIS_SCALE).toMatrix44F();
+        }
+    }
+
+
+    /// Largest difference between the matrices of two frames
+    float frameDifference(const Frame& a, const Frame& b)
+    {
+        float difference = 0.0f;
+        for (size_t i = 0; i < FRAME_TARGETS; ++i)
+        {
+            difference = std::max(difference, maxDifference(a.modelViews[i], b.modelViews[i]));
+            difference = std::max(difference, maxDifference(a.scaledModelViews[i], b.scaledModelViews[i]));
+            difference = std::max(difference, maxDifference(a.cubeModelViews[i], b.cubeModelViews[i]));
+            difference = std::max(difference, maxDifference(a.axisModelViews[i], b.axisModelViews[i]));
+        }
+        return difference;
+    }
+
+
+    /// The Math types agree with MathUtils, constexpr results are checked at compile time
+    bool checkMathCore()
+    {
+        constexpr Math::Mat4 scale = Math::Mat4::scaling(Math::Vec3(2.0f, 3.0f, 4.0f));
+        constexpr Math::Mat4 transform = Math::Mat4::translation(Math::Vec3(1.0f, 2.0f, 3.0f)) * scale;
+        static_assert(transform.transformPoint(Math::Vec3(1.0f, 1.0f, 1.0f)) == Math::Vec3(3.0f, 5.0f, 7.0f),
+                      "constexpr transform");
+        static_assert(Math::Mat4::translation(Math::Vec3(1.0f, 2.0f, 3.0f)).rigidInverse()(2, 3) == -3.0f,
+                      "constexpr inverse");
+        static_assert(Math::transformPoint(Math::translation<Vuforia::Matrix44F>(Math::Vec3(1.0f, 2.0f, 3.0f)),
+                                           Math::Vec3()) == Math::Vec3(1.0f, 2.0f, 3.0f),
+                      "constexpr Vuforia::Matrix44F");
+        static_assert(Math::cross(Math::Vec3(1.0f, 0.0f, 0.0f), Math::Vec3(0.0f, 1.0f, 0.0f)) == Math::Vec3(0.0f, 0.0f, 1.0f),
+                      "constexpr cross product");
+
+        std::mt19937 random(24);
+        float difference = 0.0f;
+        Comparison products;
+        for (int i = 0; i < CHECK_COUNT / 100; ++i)
+        {
+            Frame utils(random);
+            Frame core = utils;
+            Frame values = utils;
+            frameMathUtils(utils);
+            frameMathCore(core);
+            frameMat4(values);
+            difference = std::max(difference, frameDifference(utils, core));
+            difference = std::max(difference, frameDifference(utils, values));
+
+            // Products and transforms of general matrices against the scalar references
+            Vuforia::Matrix44F a = randomMatrix(random);
+            Vuforia::Matrix44F b = randomMatrix(random);
+            Vuforia::Matrix44F scalar;
+            MathUtils::multiplyMatrixScalar(a, b, scalar);
+            Vuforia::Matrix44F product = Math::multiply(a, b);
+            for (int element = 0; element < 16; ++element)
+            {
+                products.add(product.data[element], scalar.data[element], productBound(a, b, element % 4, element / 4));
+            }
+
+            Vuforia::Vec3F v(b.data[0], b.data[1], b.data[2]);
+            Vuforia::Vec3F point = Math::transformPoint(a, v);
+            Vuforia::Vec3F scalarPoint = MathUtils::Vec3FTransformScalar(a, v);
+            for (int row = 0; row < 3; ++row)
+            {
+                products.add(point.data[row], scalarPoint.data[row], productBound(a, b, row, 0) + std::fabs(a.data[12 + row]));
+            }
+        }
+
+        bool passed = products.report("Math::multiply");
+        // Both compute each element with the same operations
+        printf("Frame matrices differ from MathUtils by %g\n", difference);
+        return passed && difference == 0.0f;
+    }
+
+
+    /// Time the matrix work of frames through MathUtils and through the Math types
+    void benchmarkFrame(int frameCount)
+    {
+        std::mt19937 random(25);
+        std::vector<Frame> frames;
+        for (size_t i = 0; i < 64; ++i)
+        {
+            frames.emplace_back(random);
+        }
+
+        float sink = 0.0f;
+        auto timeFrames = [&](void (*work)(Frame&))
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frameCount; ++i)
+            {
+                work(frames[i % frames.size()]);
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            sink += frames[0].axisModelViews[FRAME_TARGETS - 1].data[0];
+            return elapsed.count() / frameCount;
+        };
+
+        double utilsNs = timeFrames(frameMathUtils);
+        double coreNs = timeFrames(frameMathCore);
+        double valuesNs = timeFrames(frameMat4);
+        printf("Frame of %zu targets: MathUtils %.1f ns, Math functions %.1f ns, Math::Mat4 %.1f ns (%s kernels)\n",
+               FRAME_TARGETS, utilsNs, coreNs, valuesNs, MathUtils::getKernelName());
+        printf("(checksum %g)\n", sink);
+    }
+
+
+    /// Angle of the rotation from a to b, atan2 keeps small angles accurate
+    float rotationAngle(const Math::Quat& a, const Math::Quat& b)
+    {
+        Math::Quat r = a.conjugate() * b;
+        return 2.0f * std::atan2(Math::length(r.vector()), std::fabs(r[3]));
+    }
+
+
+    /// Unit quaternions of random poses, half of them negated as both signs are the same rotation
+    std::vector<float> randomQuaternions(std::mt19937& random, size_t count)
+    {
+        std::vector<float> quaternions(count * 4);
+        for (size_t i = 0; i < count; ++i)
+        {
+            Math::Quat q = Math::Quat::fromMatrix(poseToMatrix(randomPose(random)));
+            if (random() % 2 == 0)
+            {
+                q = -q;
+            }
+            std::copy(q.data, q.data + 4, quaternions.begin() + i * 4);
+        }
+        return quaternions;
+    }
+
+
+    /// Dual quaternions of random poses, stored real then dual part
+    std::vector<float> randomDualQuaternions(std::mt19937& random, size_t count)
+    {
+        std::vector<float> dualQuaternions(count * 8);
+        for (size_t i = 0; i < count; ++i)
+        {
+            Math::DualQuat dq = Math::DualQuat::fromMatrix(poseToMatrix(randomPose(random)));
+            std::copy(dq.real.data, dq.real.data + 4, dualQuaternions.begin() + i * 8);
+            std::copy(dq.dual.data, dq.dual.data + 4, dualQuaternions.begin() + i * 8 + 4);
+        }
+        return dualQuaternions;
+    }
+
+
+    bool checkQuaternions()
+    {
+        std::mt19937 random(25);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        float matrixError = 0.0f;
+        float lengthError = 0.0f;
+        float rotateError = 0.0f;
+        float dualMatrixError = 0.0f;
+        float dualPointError = 0.0f;
+        float angleError = 0.0f;
+        float interpolateError = 0.0f;
+
+        for (int i = 0; i < CHECK_COUNT / 10; ++i)
+        {
+            Vuforia::Matrix44F m = poseToMatrix(randomPose(random));
+            Vuforia::Matrix44F m1 = poseToMatrix(randomPose(random));
+            Math::Vec3 v(unit(random), unit(random), unit(random));
+
+            // Conversions of the rotation, with the translation copied over
+            Math::Quat q = Math::Quat::fromMatrix(m);
+            Vuforia::Matrix44F rotation = q.toMatrix<Vuforia::Matrix44F>();
+            std::copy(m.data + 12, m.data + 15, rotation.data + 12);
+            matrixError = std::max(matrixError, maxDifference(rotation, m));
+            lengthError = std::max(lengthError, std::fabs(Math::length(q) - 1.0f));
+            rotateError = std::max(rotateError, Math::length(q.rotate(v) - Math::transformDirection(m, v)));
+
+            Math::DualQuat dq = Math::DualQuat::fromMatrix(m);
+            dualMatrixError = std::max(dualMatrixError, maxDifference(dq.toMatrix<Vuforia::Matrix44F>(), m));
+            dualPointError = std::max(dualPointError, Math::length(dq.transformPoint(v) - Math::transformPoint(m, v)));
+
+            // slerp turns t of the way to q1, extrapolating outside [0, 1]
+            // while the angle stays below half a turn
+            Math::Quat q1 = Math::Quat::fromMatrix(m1);
+            float angle = rotationAngle(q, q1);
+            float t = 2.0f * unit(random) + 0.5f;
+            if (std::fabs(t) * angle < 3.0f)
+            {
+                angleError = std::max(angleError, std::fabs(rotationAngle(q, Math::slerp(q, q1, t)) - std::fabs(t) * angle));
+            }
+
+            interpolateError = std::max(interpolateError, maxDifference(MathUtils::Matrix44FInterpolateRigid(m, m1, 0.0f), m));
+            interpolateError = std::max(interpolateError, maxDifference(MathUtils::Matrix44FInterpolateRigid(m, m1, 1.0f), m1));
+        }
+
+        // The batch interpolations against the single ones, over lengths
+        // with and without a scalar tail and written over an input
+        Comparison slerps;
+        Comparison nlerps;
+        Comparison dualNlerps;
+        std::uniform_real_distribution<float> parameter(-0.5f, 1.5f);
+        for (size_t count : { 0, 1, 3, 4, 5, 8, 13, 37, 1000 })
+        {
+            std::vector<float> q0 = randomQuaternions(random, count);
+            std::vector<float> q1 = randomQuaternions(random, count);
+            std::vector<float> dq0 = randomDualQuaternions(random, count);
+            std::vector<float> dq1 = randomDualQuaternions(random, count);
+            float t = parameter(random);
+
+            std::vector<float> slerped(q0.size());
+            std::vector<float> nlerped = q0;
+            std::vector<float> dualNlerped = dq1;
+            MathUtils::slerpQuaternions(q0.data(), q1.data(), t, slerped.data(), count);
+            MathUtils::nlerpQuaternions(nlerped.data(), q1.data(), t, nlerped.data(), count);
+            MathUtils::nlerpDualQuaternions(dq0.data(), dualNlerped.data(), t, dualNlerped.data(), count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                Math::Quat a(q0[i * 4], q0[i * 4 + 1], q0[i * 4 + 2], q0[i * 4 + 3]);
+                Math::Quat b(q1[i * 4], q1[i * 4 + 1], q1[i * 4 + 2], q1[i * 4 + 3]);
+                Math::Quat slerp = Math::slerp(a, b, t);
+                Math::Quat nlerp = Math::nlerp(a, b, t);
+                const float* dA = dq0.data() + i * 8;
+                const float* dB = dq1.data() + i * 8;
+                Math::DualQuat dualNlerp = Math::nlerp(
+                    Math::DualQuat(Math::Quat(dA[0], dA[1], dA[2], dA[3]), Math::Quat(dA[4], dA[5], dA[6], dA[7])),
+                    Math::DualQuat(Math::Quat(dB[0], dB[1], dB[2], dB[3]), Math::Quat(dB[4], dB[5], dB[6], dB[7])), t);
+                for (int j = 0; j < 4; ++j)
+                {
+                    slerps.add(slerped[i * 4 + j], slerp[j], 1.0f);
+                    nlerps.add(nlerped[i * 4 + j], nlerp[j], 1.0f);
+                    dualNlerps.add(dualNlerped[i * 8 + j], dualNlerp.real[j], 1.0f);
+                    // Half the translation, up to 5 m per axis
+                    dualNlerps.add(dualNlerped[i * 8 + 4 + j], dualNlerp.dual[j], 5.0f);
+                }
+            }
+        }
+
+        printf("Quaternions: max error %g of the matrix, %g of the length, %g of rotated vectors\n",
+               matrixError, lengthError, rotateError);
+        printf("             dual quaternions %g of the matrix, %g of transformed points\n",
+               dualMatrixError, dualPointError);
+        printf("             slerp angle error %g rad, Matrix44FInterpolateRigid end point error %g\n",
+               angleError, interpolateError);
+        bool passed = slerps.report("slerpQuaternions");
+        passed = nlerps.report("nlerpQuaternions") && passed;
+        passed = dualNlerps.report("nlerpDualQuaternions") && passed;
+        // Unit rotations and translations of up to 5 m in single precision
+        return passed && matrixError < 1e-5f && lengthError < 1e-5f && rotateError < 1e-5f &&
+            dualMatrixError < 1e-5f && dualPointError < 1e-5f && angleError < 1e-5f && interpolateError < 1e-5f;
+    }
+
+
+    void benchmarkQuaternions(size_t count)
+    {
+        std::mt19937 random(3);
+        std::vector<float> q0 = randomQuaternions(random, count);
+        std::vector<float> q1 = randomQuaternions(random, count);
+        std::vector<float> dq0 = randomDualQuaternions(random, count);
+        std::vector<float> dq1 = randomDualQuaternions(random, count);
+        std::vector<float> result(dq0.size());
+        const float t = 0.3f;
+
+        auto quaternion = [](const float* data) { return Math::Quat(data[0], data[1], data[2], data[3]); };
+        auto singleSlerp = [&]()
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                Math::Quat r = Math::slerp(quaternion(&q0[i * 4]), quaternion(&q1[i * 4]), t);
+                std::copy(r.data, r.data + 4, &result[i * 4]);
+            }
+        };
+        auto singleNlerp = [&]()
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                Math::Quat r = Math::nlerp(quaternion(&q0[i * 4]), quaternion(&q1[i * 4]), t);
+                std::copy(r.data, r.data + 4, &result[i * 4]);
+            }
+        };
+        auto singleDualNlerp = [&]()
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                Math::DualQuat r = Math::nlerp(Math::DualQuat(quaternion(&dq0[i * 8]), quaternion(&dq0[i * 8 + 4])),
+                                               Math::DualQuat(quaternion(&dq1[i * 8]), quaternion(&dq1[i * 8 + 4])), t);
+                std::copy(r.real.data, r.real.data + 4, &result[i * 8]);
+                std::copy(r.dual.data, r.dual.data + 4, &result[i * 8 + 4]);
+            }
+        };
+
+        // slerp runs at tens of millions per second, time fewer
+        const size_t slerpTotal = 20000000;
+        printf("%zu quaternions, millions/second  single    batch (%s)\n", count, MathUtils::getKernelName());
+        printf("slerp                           %8.1f %8.1f\n", timeBatch(count, singleSlerp, slerpTotal),
+               timeBatch(count, [&]() { MathUtils::slerpQuaternions(q0.data(), q1.data(), t, result.data(), count); }, slerpTotal));
+        printf("nlerp                           %8.1f %8.1f\n", timeBatch(count, singleNlerp),
+               timeBatch(count, [&]() { MathUtils::nlerpQuaternions(q0.data(), q1.data(), t, result.data(), count); }));
+        printf("dual quaternion nlerp           %8.1f %8.1f\n", timeBatch(count, singleDualNlerp),
+               timeBatch(count, [&]() { MathUtils::nlerpDualQuaternions(dq0.data(), dq1.data(), t, result.data(), count); }));
+        printf("(checksum %g)\n", result[0]);
+    }
+
+
+    /// Time a function over the matrix set, returns nanoseconds per call
+    template <typename Function>
+    double time(int iterations, Function function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            for (size_t j = 0; j < SET_SIZE; ++j)
+            {
+                function(j);
+            }
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (double(iterations) * SET_SIZE);
+    }
+
+
+    void benchmark(int iterations)
+    {
+        std::mt19937 random(16);
+        std::vector<Vuforia::Matrix44F> a(SET_SIZE);
+        std::vector<Vuforia::Matrix44F> b(SET_SIZE);
+        std::vector<Vuforia::Matrix44F> c(SET_SIZE);
+        std::vector<Vuforia::Vec4F> v4(SET_SIZE);
+        std::vector<Vuforia::Vec3F> v3(SET_SIZE);
+        std::vector<Vuforia::Matrix34F> poses(SET_SIZE);
+        std::vector<Vuforia::Matrix44F> poseMatrices(SET_SIZE);
+        for (size_t i = 0; i < SET_SIZE; ++i)
+        {
+            poses[i] = randomPose(random);
+            poseMatrices[i] = poseToMatrix(poses[i]);
+            a[i] = randomMatrix(random);
+            b[i] = randomMatrix(random);
+            v4[i] = Vuforia::Vec4F(b[i].data[0], b[i].data[1], b[i].data[2], b[i].data[3]);
+            v3[i] = Vuforia::Vec3F(b[i].data[4], b[i].data[5], b[i].data[6]);
+        }
+
+        // The results are summed so the calls can't be optimized away
+        float sink = 0.0f;
+        double multiplyNs = time(iterations, [&](size_t i) { MathUtils::multiplyMatrix(a[i], b[i], c[i]); });
+        sink += c[SET_SIZE - 1].data[0];
+        double multiplyScalarNs = time(iterations, [&](size_t i) { MathUtils::multiplyMatrixScalar(a[i], b[i], c[i]); });
+        sink += c[SET_SIZE - 1].data[0];
+        double transform4Ns = time(iterations, [&](size_t i) { sink += MathUtils::Vec4FTransform(a[i], v4[i]).data[3]; });
+        double transform4ScalarNs = time(iterations, [&](size_t i) { sink += MathUtils::Vec4FTransformScalar(a[i], v4[i]).data[3]; });
+        double transform3Ns = time(iterations, [&](size_t i) { sink += MathUtils::Vec3FTransform(a[i], v3[i]).data[2]; });
+        double transform3ScalarNs = time(iterations, [&](size_t i) { sink += MathUtils::Vec3FTransformScalar(a[i], v3[i]).data[2]; });
+
+        double generalInverseNs = time(iterations, [&](size_t i)
+        {
+            c[i] = MathUtils::Matrix44FTranspose(MathUtils::Matrix44FInverse(poseMatrices[i]));
+        });
+        sink += c[SET_SIZE - 1].data[12];
+        double rigidInverseNs = time(iterations, [&](size_t i) { c[i] = MathUtils::Matrix44FRigidInverse(poseMatrices[i]); });
+        sink += c[SET_SIZE - 1].data[12];
+        double viewFromPoseNs = time(iterations, [&](size_t i) { c[i] = MathUtils::Matrix44FViewFromPose(poses[i]); });
+        sink += c[SET_SIZE - 1].data[12];
+
+        printf("%-16s %8s %8s\n", "ns per call", MathUtils::getKernelName(), "scalar");
+        printf("%-16s %8.2f %8.2f\n", "multiplyMatrix", multiplyNs, multiplyScalarNs);
+        printf("%-16s %8.2f %8.2f\n", "Vec4FTransform", transform4Ns, transform4ScalarNs);
+        printf("%-16s %8.2f %8.2f\n", "Vec3FTransform", transform3Ns, transform3ScalarNs);
+        printf("Transpose(Inverse(m)) %.2f, Matrix44FRigidInverse %.2f, Matrix44FViewFromPose %.2f\n",
+               generalInverseNs, rigidInverseNs, viewFromPoseNs);
+        printf("(checksum %g)\n", sink);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc == 3 && strcmp(argv[1], "-t") == 0)
+    {
+        struct Check
+        {
+            const char* name;
+            bool (*run)();
+        };
+        static const Check CHECKS[] = {
+            { "multiply", check },
+            { "rigid", checkRigidInverse },
+            { "batch", checkBatch },
+            { "core", checkMathCore },
+            { "quaternions", checkQuaternions },
+        };
+        for (const Check& c : CHECKS)
+        {
+            if (strcmp(argv[2], c.name) == 0)
+            {
+                return c.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (argc >= 3 && argc <= 4 && strcmp(argv[1], "-b") == 0)
+    {
+        long long count = atoll(argv[2]);
+        int threadCount = argc == 4 ? atoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+        if (count > 0 && threadCount > 0)
+        {
+            benchmarkBatch(static_cast<size_t>(count), static_cast<unsigned int>(threadCount));
+            return EXIT_SUCCESS;
+        }
+    }
+
+    if (argc == 3 && strcmp(argv[1], "-q") == 0)
+    {
+        long long count = atoll(argv[2]);
+        if (count > 0)
+        {
+            benchmarkQuaternions(static_cast<size_t>(count));
+            return EXIT_SUCCESS;
+        }
+    }
+
+    if (argc == 3 && strcmp(argv[1], "-f") == 0)
+    {
+        int frameCount = atoi(argv[2]);
+        if (frameCount > 0)
+        {
+            if (!checkMathCore())
+            {
+                return EXIT_FAILURE;
+            }
+            benchmarkFrame(frameCount);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    int iterations = argc >= 2 ? atoi(argv[1]) : 1000;
+    if (argc > 2 || iterations <= 0)
+    {
+        fprintf(stderr, "Usage: %s [iterations]\n"
+                        "       %s -b vertices [threads]\n"
+                        "       %s -f frames\n"
+                        "       %s -q quaternions\n"
+                        "       %s -t multiply|rigid|batch|core|quaternions\n",
+                argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bool passed = check();
+    passed = checkRigidInverse() && passed;
+    passed = checkBatch() && passed;
+    passed = checkMathCore() && passed;
+    passed = checkQuaternions() && passed;
+    if (!passed)
+    {
+        return EXIT_FAILURE;
+    }
+    benchmark(iterations);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,468 @@
+/*===============================================================================
+Copyright (c) 2020, PTC Inc. All rights reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Offline converter from OBJ models to the binary mesh cache format.
+//
+// Usage: ObjToMesh [-o] [-b iterations] input.obj output.mesh
+//        ObjToMesh -p input.obj
+//        ObjToMesh -f count
+//
+// The resulting file can be added to the app assets next to the OBJ file,
+// the renderer loads it in preference to parsing the OBJ text.
+// With -o the mesh is optimized for the vertex cache and overdraw, the
+// ACMR/ATVR before and after the optimization are reported and the tool
+// fails if the ACMR got worse.
+// With -b the times to load the OBJ file and the mesh cache into the same
+// in memory mesh are measured over the given number of iterations and
+// reported, the buffer OBJ parser is checked against
+// the stream parser and the throughput of both is reported in MB/s, for the
+// buffer parser with 1, 2, 4 and 8 threads.
+// With -p only the buffer parser is checked against the stream parser.
+// With -f the OBJ number parser is checked against strtod on the given count
+// of random numbers, and the time per number of both is reported.
+
+#include <FileAssetSource.h>
+#include <MemoryStream.h>
+#include <MeshCache.h>
+#include <MeshOptimizer.h>
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+
+    bool writeFile(const char* filename, const std::vector<char>& data)
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file.write(data.data(), data.size());
+        return file.good();
+    }
+
+
+    bool loadObj(const char* filename, MeshCache::Mesh& mesh)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::string err;
+
+        // Parsed from the mapped file, as the renderer does from the asset buffer
+        std::unique_ptr<Asset> asset = FileAssetSource().open(filename);
+        if (asset == nullptr)
+        {
+            fprintf(stderr, "Cannot open %s\n", filename);
+            return false;
+        }
+
+        if (!tinyobj::LoadObjFromBuffer(&attrib, &shapes, &err, asset->getData(), asset->getSize(), true,
+                                        std::thread::hardware_concurrency()) ||
+            !err.empty())
+        {
+            fprintf(stderr, "Error loading %s (%s)\n", filename, err.c_str());
+            return false;
+        }
+        return MeshCache::buildFromObj(attrib, shapes, mesh);
+    }
+
+
+    /// Read a mesh cache into a mesh, the same result loadObj gives for its OBJ file
+    bool loadMesh(const char* filename, MeshCache::Mesh& mesh)
+    {
+        std::unique_ptr<Asset> asset = FileAssetSource().open(filename);
+        MeshCache::View view;
+        if (asset == nullptr || !MeshCache::parse(asset->getData(), asset->getSize(), view))
+        {
+            fprintf(stderr, "Cannot load %s\n", filename);
+            return false;
+        }
+
+        const float* vertices = static_cast<const float*>(view.vertices);
+        mesh.vertices.assign(vertices, vertices + view.vertexBytes / sizeof(float));
+        mesh.indices.resize(view.header.indexCount);
+        if (view.header.indexSize == sizeof(uint16_t))
+        {
+            const uint16_t* indices = static_cast<const uint16_t*>(view.indices);
+            std::copy(indices, indices + view.header.indexCount, mesh.indices.begin());
+        }
+        else
+        {
+            memcpy(mesh.indices.data(), view.indices, view.indexBytes);
+        }
+        memcpy(mesh.boundsMin, view.header.boundsMin, sizeof(mesh.boundsMin));
+        memcpy(mesh.boundsMax, view.header.boundsMax, sizeof(mesh.boundsMax));
+        return true;
+    }
+
+
+    /// Parse with the std::istream LoadObj, the reference for the buffer parser
+    bool loadObjFromStream(const Asset& asset, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes)
+    {
+        // Materials are not used by the renderer, don't attempt to load them
+        std::vector<tinyobj::material_t> materials;
+        std::string err;
+        MemoryInputStream stream(asset.getData(), asset.getSize());
+        return tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &stream) && err.empty();
+    }
+
+
+    bool loadObjFromBuffer(const Asset& asset, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes,
+                           unsigned int threadCount)
+    {
+        std::string err;
+        return tinyobj::LoadObjFromBuffer(&attrib, &shapes, &err, asset.getData(), asset.getSize(), true,
+                                          threadCount) && err.empty();
+    }
+
+
+    /// Thread counts the buffer parser is checked and measured with
+    const unsigned int THREAD_COUNTS[] = { 1, 2, 4, 8 };
+
+
+    bool sameIndex(const tinyobj::index_t& a, const tinyobj::index_t& b)
+    {
+        return a.vertex_index == b.vertex_index && a.normal_index == b.normal_index &&
+               a.texcoord_index == b.texcoord_index;
+    }
+
+
+    bool sameObj(const tinyobj::attrib_t& expectedAttrib, const std::vector<tinyobj::shape_t>& expectedShapes,
+                 const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes)
+    {
+        if (expectedAttrib.vertices != attrib.vertices ||
+            expectedAttrib.normals != attrib.normals ||
+            expectedAttrib.texcoords != attrib.texcoords)
+        {
+            fprintf(stderr, "Parity: vertex attributes differ\n");
+            return false;
+        }
+        if (expectedShapes.size() != shapes.size())
+        {
+            fprintf(stderr, "Parity: %zu shapes, expected %zu\n", shapes.size(), expectedShapes.size());
+            return false;
+        }
+        for (size_t i = 0; i < expectedShapes.size(); ++i)
+        {
+            const tinyobj::shape_t& expected = expectedShapes[i];
+            const tinyobj::shape_t& actual = shapes[i];
+            bool same = expected.name == actual.name &&
+                        expected.mesh.num_face_vertices == actual.mesh.num_face_vertices &&
+                        expected.mesh.material_ids == actual.mesh.material_ids &&
+                        expected.mesh.indices.size() == actual.mesh.indices.size() &&
+                        std::equal(expected.mesh.indices.begin(), expected.mesh.indices.end(),
+                                   actual.mesh.indices.begin(), sameIndex);
+            if (!same)
+            {
+                fprintf(stderr, "Parity: shape %zu (%s) differs\n", i, expected.name.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    /// Compare the output of the buffer parser with each thread count to the
+    /// stream parser, reports the first difference
+    bool checkParity(const char* objFilename)
+    {
+        std::unique_ptr<Asset> asset = FileAssetSource().open(objFilename);
+        tinyobj::attrib_t streamAttrib;
+        std::vector<tinyobj::shape_t> streamShapes;
+        if (asset == nullptr || !loadObjFromStream(*asset, streamAttrib, streamShapes))
+        {
+            fprintf(stderr, "Parity: cannot parse %s\n", objFilename);
+            return false;
+        }
+
+        for (unsigned int threadCount : THREAD_COUNTS)
+        {
+            tinyobj::attrib_t bufferAttrib;
+            std::vector<tinyobj::shape_t> bufferShapes;
+            if (!loadObjFromBuffer(*asset, bufferAttrib, bufferShapes, threadCount) ||
+                !sameObj(streamAttrib, streamShapes, bufferAttrib, bufferShapes))
+            {
+                fprintf(stderr, "Parity: buffer parser with %u threads differs\n", threadCount);
+                return false;
+            }
+        }
+        printf("Parity:    %zu shapes, %zu vertices match\n", streamShapes.size(), streamAttrib.vertices.size() / 3);
+        return true;
+    }
+
+
+    /// Average time of a parse over the iterations, in ms
+    template <typename ParseFunction>
+    double timeParse(const Asset& asset, int iterations, ParseFunction parse)
+    {
+        double ms = 0.0;
+        for (int i = 0; i < iterations; ++i)
+        {
+            tinyobj::attrib_t attrib;
+            std::vector<tinyobj::shape_t> shapes;
+            auto start = Clock::now();
+            parse(asset, attrib, shapes);
+            ms += elapsedMs(start);
+        }
+        return ms / iterations;
+    }
+
+
+    double megabytesPerSecond(size_t bytes, double ms)
+    {
+        return ms > 0.0 ? (bytes / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0;
+    }
+
+
+    void benchmark(const char* objFilename, const char* meshFilename, int iterations)
+    {
+        double objMs = 0.0;
+        double meshMs = 0.0;
+        for (int i = 0; i < iterations; ++i)
+        {
+            auto start = Clock::now();
+            MeshCache::Mesh mesh;
+            loadObj(objFilename, mesh);
+            objMs += elapsedMs(start);
+
+            // Copied into a mesh too, so both times end at the same vertex and index arrays
+            start = Clock::now();
+            MeshCache::Mesh cached;
+            loadMesh(meshFilename, cached);
+            meshMs += elapsedMs(start);
+        }
+        printf("OBJ load:  %8.3f ms\n", objMs / iterations);
+        printf("Mesh load: %8.3f ms\n", meshMs / iterations);
+
+        std::unique_ptr<Asset> asset = FileAssetSource().open(objFilename);
+        if (asset == nullptr)
+        {
+            return;
+        }
+        double streamMs = timeParse(*asset, iterations, loadObjFromStream);
+        printf("OBJ parse (stream):     %8.3f ms, %7.1f MB/s\n",
+               streamMs, megabytesPerSecond(asset->getSize(), streamMs));
+        for (unsigned int threadCount : THREAD_COUNTS)
+        {
+            double bufferMs = timeParse(*asset, iterations,
+                [threadCount](const Asset& asset, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes)
+                {
+                    return loadObjFromBuffer(asset, attrib, shapes, threadCount);
+                });
+            printf("OBJ parse (buffer, %ut): %8.3f ms, %7.1f MB/s\n",
+                   threadCount, bufferMs, megabytesPerSecond(asset->getSize(), bufferMs));
+        }
+    }
+
+    /// Random numbers as they appear in OBJ files, one per line
+    std::string makeNumbers(int count, std::vector<size_t>& offsets)
+    {
+        std::mt19937_64 random(42);
+        std::uniform_real_distribution<double> position(-1000.0, 1000.0);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::uniform_int_distribution<int> digit(0, 9);
+
+        std::string text;
+        char number[64];
+        for (int i = 0; i < count; ++i)
+        {
+            switch (i % 5)
+            {
+            case 0: // Exporter output: positions and normals
+                snprintf(number, sizeof(number), "%.6f", position(random));
+                break;
+            case 1: // Texture coordinates
+                snprintf(number, sizeof(number), "%.4f", unit(random));
+                break;
+            case 2: // Shortest round trip, with exponents
+                snprintf(number, sizeof(number), "%.9g", position(random) * std::pow(10.0, digit(random) - 5));
+                break;
+            case 3: // Any finite double
+            {
+                double value;
+                do
+                {
+                    uint64_t bits = random();
+                    memcpy(&value, &bits, sizeof(value));
+                } while (!std::isfinite(value));
+                snprintf(number, sizeof(number), "%.17g", value);
+                break;
+            }
+            default: // Long digit strings, past the exact mantissa range
+            {
+                int length = 1 + static_cast<int>(random() % 24);
+                int point = static_cast<int>(random() % (length + 1));
+                char* c = number;
+                for (int d = 0; d < length; ++d)
+                {
+                    if (d == point && d > 0)
+                    {
+                        *c++ = '.';
+                    }
+                    *c++ = static_cast<char>('0' + digit(random));
+                }
+                snprintf(c, number + sizeof(number) - c, "e%d", static_cast<int>(random() % 61) - 30);
+                break;
+            }
+            }
+            offsets.push_back(text.size());
+            text += number;
+            text += '\n';
+        }
+        offsets.push_back(text.size());
+        return text;
+    }
+
+
+    /// Check the OBJ number parser gives the same doubles as strtod, and time both
+    bool checkNumberParser(int count)
+    {
+        std::vector<size_t> offsets;
+        std::string text = makeNumbers(count, offsets);
+
+        // Timed per kind of number, see makeNumbers
+        static const char* KIND_NAMES[] = { "%.6f", "%.4f", "%.9g", "%.17g", "long" };
+        const int KIND_COUNT = sizeof(KIND_NAMES) / sizeof(KIND_NAMES[0]);
+        std::vector<double> expected(count);
+        std::vector<double> parsed(count);
+        printf("ns/number  parser  strtod\n");
+        for (int kind = 0; kind < KIND_COUNT; ++kind)
+        {
+            auto start = Clock::now();
+            for (int i = kind; i < count; i += KIND_COUNT)
+            {
+                expected[i] = strtod(text.c_str() + offsets[i], nullptr);
+            }
+            double strtodMs = elapsedMs(start);
+
+            start = Clock::now();
+            for (int i = kind; i < count; i += KIND_COUNT)
+            {
+                tinyobj::ParseDouble(text.c_str() + offsets[i], text.c_str() + offsets[i + 1] - 1, &parsed[i]);
+            }
+            double parseMs = elapsedMs(start);
+
+            int kindCount = (count - kind + KIND_COUNT - 1) / KIND_COUNT;
+            printf("%-9s %7.1f %7.1f\n", KIND_NAMES[kind],
+                   parseMs * 1e6 / std::max(kindCount, 1), strtodMs * 1e6 / std::max(kindCount, 1));
+        }
+
+        int mismatches = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            if (memcmp(&expected[i], &parsed[i], sizeof(double)) != 0)
+            {
+                if (mismatches++ < 10)
+                {
+                    fprintf(stderr, "%.*s: %.17g, strtod %.17g\n", static_cast<int>(offsets[i + 1] - offsets[i] - 1),
+                            text.c_str() + offsets[i], parsed[i], expected[i]);
+                }
+            }
+        }
+        printf("%d numbers, %d differ from strtod\n", count, mismatches);
+        return mismatches == 0;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    int iterations = 0;
+    bool optimize = false;
+    int arg = 1;
+    while (arg < argc && argv[arg][0] == '-')
+    {
+        if (strcmp(argv[arg], "-o") == 0)
+        {
+            optimize = true;
+            arg += 1;
+        }
+        else if (strcmp(argv[arg], "-b") == 0 && arg + 1 < argc)
+        {
+            iterations = atoi(argv[arg + 1]);
+            arg += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (argc - arg == 2 && strcmp(argv[1], "-p") == 0)
+    {
+        return checkParity(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (argc - arg == 2 && strcmp(argv[1], "-f") == 0)
+    {
+        return checkNumberParser(atoi(argv[2])) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (argc - arg != 2)
+    {
+        fprintf(stderr, "Usage: %s [-o] [-b iterations] input.obj output.mesh\n"
+                        "       %s -p input.obj\n"
+                        "       %s -f count\n", argv[0], argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* objFilename = argv[arg];
+    const char* meshFilename = argv[arg + 1];
+
+    MeshCache::Mesh mesh;
+    if (!loadObj(objFilename, mesh))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (optimize)
+    {
+        auto before = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertexCount());
+        MeshOptimizer::optimize(mesh);
+        auto after = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertexCount());
+        printf("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+               objFilename, before.acmr, after.acmr, before.atvr, after.atvr);
+        if (after.acmr > before.acmr)
+        {
+            fprintf(stderr, "The optimization made the vertex cache use worse\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<char> data;
+    MeshCache::serialize(mesh, data);
+    if (!writeFile(meshFilename, data))
+    {
+        fprintf(stderr, "Cannot write %s\n", meshFilename);
+        return EXIT_FAILURE;
+    }
+    printf("%s: %u vertices, %zu indices, %zu bytes\n",
+           meshFilename, mesh.vertexCount(), mesh.indices.size(), data.size());
+
+    if (iterations > 0)
+    {
+        if (!checkParity(objFilename))
+        {
+            return EXIT_FAILURE;
+        }
+        benchmark(objFilename, meshFilename, iterations);
+    }
+
+    return EXIT_SUCCESS;
+}
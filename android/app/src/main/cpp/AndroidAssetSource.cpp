@@ -0,0 +1,62 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "AndroidAssetSource.h"
+
+#include <Log.h>
+
+
+namespace
+{
+    /// An open AAsset, closed with the object
+    class AndroidAsset : public Asset
+    {
+    public:
+        AndroidAsset(AAsset* asset, const void* buffer, size_t size)
+            : mAsset(asset)
+        {
+            mData = static_cast<const char*>(buffer);
+            mSize = size;
+        }
+
+        ~AndroidAsset() override
+        {
+            AAsset_close(mAsset);
+        }
+
+    private:
+        AAsset* mAsset;
+    };
+}
+
+
+std::unique_ptr<Asset>
+AndroidAssetSource::open(const char* name) const
+{
+    if (mAssetManager == nullptr)
+    {
+        return nullptr;
+    }
+
+    AAsset* asset = AAssetManager_open(mAssetManager, name, AASSET_MODE_BUFFER);
+    if (asset == nullptr)
+    {
+        return nullptr;
+    }
+
+    // Compressed assets are decompressed into a buffer owned by the asset
+    size_t size = static_cast<size_t>(AAsset_getLength(asset));
+    const void* buffer = AAsset_getBuffer(asset);
+    if (buffer == nullptr && size > 0)
+    {
+        LOG("Error reading asset file %s", name);
+        AAsset_close(asset);
+        return nullptr;
+    }
+
+    return std::unique_ptr<Asset>(new AndroidAsset(asset, buffer, size));
+}
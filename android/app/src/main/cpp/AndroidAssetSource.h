@@ -0,0 +1,33 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_ANDROIDASSETSOURCE_H_
+#define _VUFORIA_ANDROIDASSETSOURCE_H_
+
+#include <android/asset_manager.h>
+
+#include <Asset.h>
+
+
+/// Assets packaged in the APK, read through the NDK asset manager
+/**
+ * Assets are opened with AASSET_MODE_BUFFER and exposed through
+ * AAsset_getBuffer, so assets stored uncompressed (see noCompress in
+ * build.gradle) are read straight from the memory mapped APK.
+ */
+class AndroidAssetSource : public AssetSource
+{
+public:
+    explicit AndroidAssetSource(AAssetManager* assetManager) : mAssetManager(assetManager) {}
+
+    std::unique_ptr<Asset> open(const char* name) const override;
+
+private:
+    AAssetManager* mAssetManager;
+};
+
+#endif // _VUFORIA_ANDROIDASSETSOURCE_H_
@@ -0,0 +1,131 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "GLESGpuTimer.h"
+
+#include <Log.h>
+
+#include <EGL/egl.h>
+
+#include <cstring>
+
+
+void
+GLESGpuTimer::init()
+{
+    deinit();
+
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (extensions == nullptr || strstr(extensions, "GL_EXT_disjoint_timer_query") == nullptr)
+    {
+        LOG("GL_EXT_disjoint_timer_query is not supported, GPU stages won't be timed");
+        return;
+    }
+
+    // The query object functions are core in OpenGL ES 3.0 except the 64-bit result
+    mGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+        eglGetProcAddress("glGetQueryObjectui64vEXT"));
+    if (mGetQueryObjectui64v == nullptr)
+    {
+        return;
+    }
+
+    GLuint ids[QUERY_COUNT];
+    glGenQueries(QUERY_COUNT, ids);
+    for (int i = 0; i < QUERY_COUNT; ++i)
+    {
+        mQueries[i].id = ids[i];
+    }
+
+    // Reading the flag clears it
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+}
+
+
+void
+GLESGpuTimer::deinit()
+{
+    if (isSupported())
+    {
+        for (Query& query : mQueries)
+        {
+            glDeleteQueries(1, &query.id);
+            query = Query();
+        }
+    }
+    mGetQueryObjectui64v = nullptr;
+    mFirstPending = 0;
+    mPendingCount = 0;
+    mActive = false;
+}
+
+
+void
+GLESGpuTimer::begin(FrameProfiler::Stage stage)
+{
+    if (!isSupported() || mActive || mPendingCount == QUERY_COUNT)
+    {
+        return;
+    }
+
+    Query& query = mQueries[(mFirstPending + mPendingCount) % QUERY_COUNT];
+    query.stage = stage;
+    glBeginQuery(GL_TIME_ELAPSED_EXT, query.id);
+    mActive = true;
+}
+
+
+void
+GLESGpuTimer::end()
+{
+    if (!mActive)
+    {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    mPendingCount++;
+    mActive = false;
+}
+
+
+void
+GLESGpuTimer::collect()
+{
+    if (!isSupported())
+    {
+        return;
+    }
+
+    // A disjoint event makes the results of all the queries in flight meaningless
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    while (mPendingCount > 0)
+    {
+        const Query& query = mQueries[mFirstPending];
+
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && !disjoint)
+        {
+            // Queries finish in order, the later ones aren't available either
+            break;
+        }
+
+        if (!disjoint)
+        {
+            GLuint64 nanoseconds = 0;
+            mGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+            FrameProfiler::record(query.stage, static_cast<float>(nanoseconds * 1e-6));
+        }
+
+        mFirstPending = (mFirstPending + 1) % QUERY_COUNT;
+        mPendingCount--;
+    }
+}
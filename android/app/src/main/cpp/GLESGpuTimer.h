@@ -0,0 +1,66 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_GLESGPUTIMER_H_
+#define _VUFORIA_GLESGPUTIMER_H_
+
+#include <GLES3/gl31.h>
+#include <GLES2/gl2ext.h>
+
+#include <FrameProfiler.h>
+
+
+/// GPU durations of frame stages measured with GL_EXT_disjoint_timer_query
+/**
+ * Query results become available a few frames after they are issued, so
+ * queries are kept in a ring and collect() records the finished ones into
+ * the FrameProfiler. Results spanning a disjoint event, e.g. a GPU frequency
+ * change, are discarded. Without the extension all calls do nothing.
+ *
+ * Time elapsed queries can't be nested, only time one stage at a time.
+ */
+class GLESGpuTimer
+{
+public:
+    /// Check for the extension and create the queries, call with a current context
+    void init();
+    /// Delete the queries
+    void deinit();
+
+    bool isSupported() const { return mGetQueryObjectui64v != nullptr; }
+
+    /// Start timing a stage, skipped if all queries are still pending
+    void begin(FrameProfiler::Stage stage);
+    /// Stop timing the stage passed to begin
+    void end();
+
+    /// Record the results of the finished queries, call once per frame
+    void collect();
+
+private: // types
+
+    struct Query
+    {
+        GLuint id = 0;
+        FrameProfiler::Stage stage = FrameProfiler::STAGE_COUNT;
+    };
+
+    /// Enough for a few frames of latency with two timed stages per frame
+    static const int QUERY_COUNT = 16;
+
+private: // data members
+
+    PFNGLGETQUERYOBJECTUI64VEXTPROC mGetQueryObjectui64v = nullptr;
+
+    /// Ring of queries, pending ones are [mFirstPending, mFirstPending + mPendingCount)
+    Query mQueries[QUERY_COUNT];
+    int mFirstPending = 0;
+    int mPendingCount = 0;
+    bool mActive = false;
+};
+
+#endif // _VUFORIA_GLESGPUTIMER_H_
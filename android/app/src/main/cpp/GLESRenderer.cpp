@@ -10,15 +10,69 @@ countries.
 #include "GLESUtils.h"
 #include "Shaders.h"
 
-#include <MathUtils.h>
-#include <MemoryStream.h>
+#include <ImageDecoder.h>
+#include <MathCore.h>
+#include <MeshOptimizer.h>
 #include <Models.h>
 #include <Vuforia/Tool.h>
 
-#include <android/asset_manager.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
 
-bool GLESRenderer::init(AAssetManager* assetManager)
+
+namespace
+{
+    // The uniform block structs are copied as is, their layout must match std140
+    static_assert(sizeof(Vuforia::Matrix44F) == 16 * sizeof(float), "mat4 is 16 floats");
+    static_assert(sizeof(Vuforia::Vec4F) == 4 * sizeof(float), "vec4 is 4 floats");
+
+    /// Delete a vertex array if it was created and reset the name to 0
+    void deleteVertexArray(GLuint& vertexArray)
+    {
+        if (vertexArray != 0)
+        {
+            glDeleteVertexArrays(1, &vertexArray);
+            vertexArray = 0;
+        }
+    }
+
+    /// Delete a buffer if it was created and reset the name to 0
+    void deleteBuffer(GLuint& buffer)
+    {
+        if (buffer != 0)
+        {
+            GLESUtils::destroyBuffer(buffer);
+            buffer = 0;
+        }
+    }
+
+    /// Assets of a model, the mesh cache is preferred to the OBJ file
+    struct ModelAssets
+    {
+        const char* meshFilename;
+        const char* objFilename;
+    };
+
+    /// Assets of each GLESRenderer::ModelId
+    const ModelAssets MODEL_ASSETS[GLESRenderer::MODEL_COUNT] =
+    {
+        { "Astronaut.mesh", "Astronaut.obj" },
+        { "VikingLander.mesh", "VikingLander.obj" },
+    };
+
+    /// Size of each texture streaming segment, a few rows of a 1024 texel wide texture
+    constexpr GLsizeiptr TEXTURE_STREAMING_SEGMENT_SIZE = 64 * 1024;
+}
+
+
+bool GLESRenderer::init(std::shared_ptr<const AssetSource> assets)
 {
+    auto start = std::chrono::steady_clock::now();
+    const GLESUtils::ProgramCacheStatistics programsBefore = GLESUtils::getProgramCacheStatistics();
+
     // Setup for Video Background rendering
     mVbShaderProgramID =
         GLESUtils::createProgramFromBuffer(textureVertexShaderSrc, textureFragmentShaderSrc);
@@ -36,10 +90,6 @@ bool GLESRenderer::init(AAssetManager* assetManager)
         GLESUtils::createProgramFromBuffer(uniformColorVertexShaderSrc, uniformColorFragmentShaderSrc);
     mUniformColorVertexPositionHandle =
         glGetAttribLocation(mUniformColorShaderProgramID, "vertexPosition");
-    mUniformColorMvpMatrixHandle =
-        glGetUniformLocation(mUniformColorShaderProgramID, "modelViewProjectionMatrix");
-    mUniformColorColorHandle =
-        glGetUniformLocation(mUniformColorShaderProgramID, "uniformColor");
 
     // Setup for guide view rendering
     mTextureUniformColorShaderProgramID =
@@ -48,12 +98,27 @@ bool GLESRenderer::init(AAssetManager* assetManager)
         glGetAttribLocation(mTextureUniformColorShaderProgramID, "vertexPosition");
     mTextureUniformColorTextureCoordHandle =
         glGetAttribLocation(mTextureUniformColorShaderProgramID, "vertexTextureCoord");
-    mTextureUniformColorMvpMatrixHandle =
-        glGetUniformLocation(mTextureUniformColorShaderProgramID, "modelViewProjectionMatrix");
     mTextureUniformColorTexSampler2DHandle =
         glGetUniformLocation(mTextureUniformColorShaderProgramID, "texSampler2D");
-    mTextureUniformColorColorHandle =
-        glGetUniformLocation(mTextureUniformColorShaderProgramID, "uniformColor");
+    // The texture is always bound to unit 0
+    glUseProgram(mTextureUniformColorShaderProgramID);
+    glUniform1i(mTextureUniformColorTexSampler2DHandle, 0); //texture unit, not handle
+    glUseProgram(0);
+
+    // Setup for instanced model rendering
+    mTextureColorInstancedShaderProgramID =
+        GLESUtils::createProgramFromBuffer(textureColorInstancedVertexShaderSrc, textureColorFragmentShaderSrc);
+    mTextureColorInstancedVertexPositionHandle =
+        glGetAttribLocation(mTextureColorInstancedShaderProgramID, "vertexPosition");
+    mTextureColorInstancedTextureCoordHandle =
+        glGetAttribLocation(mTextureColorInstancedShaderProgramID, "vertexTextureCoord");
+    mTextureColorInstancedModelViewMatrixHandle =
+        glGetAttribLocation(mTextureColorInstancedShaderProgramID, "instanceModelViewMatrix");
+    mTextureColorInstancedTexSampler2DHandle =
+        glGetUniformLocation(mTextureColorInstancedShaderProgramID, "texSampler2D");
+    glUseProgram(mTextureColorInstancedShaderProgramID);
+    glUniform1i(mTextureColorInstancedTexSampler2DHandle, 0); //texture unit, not handle
+    glUseProgram(0);
 
     // Setup for axis rendering
     mVertexColorShaderProgramID =
@@ -62,41 +127,54 @@ bool GLESRenderer::init(AAssetManager* assetManager)
         = glGetAttribLocation(mVertexColorShaderProgramID, "vertexPosition");
     mVertexColorColorHandle
         = glGetAttribLocation(mVertexColorShaderProgramID, "vertexColor");
-    mVertexColorMvpMatrixHandle
-        = glGetUniformLocation(mVertexColorShaderProgramID, "modelViewProjectionMatrix");
-
-    mModelTargetGuideViewTextureUnit = -1;
 
-    std::vector<char> data; // for reading model files
+    // All augmentation programs share the camera and object uniform blocks
+    for (GLuint program : { mUniformColorShaderProgramID, mTextureUniformColorShaderProgramID,
+                            mTextureColorInstancedShaderProgramID, mVertexColorShaderProgramID })
+    {
+        setUniformBlockBinding(program, "CameraData", CAMERA_DATA_BINDING);
+        setUniformBlockBinding(program, "ObjectData", OBJECT_DATA_BINDING);
+    }
 
-    // Load Astronaut model
+    // Room for the camera and 64 objects, the ring grows if a frame needs more
+    if (!mUniformRing.init(mUniformRing.align(sizeof(CameraData)) + 64 * mUniformRing.align(sizeof(ObjectData))))
     {
-        if (!readAsset(assetManager, "Astronaut.obj", data))
-        {
-            return false;
-        }
-        if (!loadObjModel(data, mAstronautVertexCount, mAstronautVertices, mAstronautTexCoords))
-        {
-            return false;
-        }
-        data.clear();
-        mAstronautTextureUnit = -1;
+        return false;
+    }
+    // Eight segments in flight, the per frame budget bounds how many are used at once
+    if (!mTextureStreamer.init(TEXTURE_STREAMING_SEGMENT_SIZE))
+    {
+        return false;
     }
 
-    // Load Lander model
+    // Startup timing, compare the runs after a fresh install and after a restart
     {
-        if (!readAsset(assetManager, "VikingLander.obj", data))
-        {
-            return false;
-        }
-        if (!loadObjModel(data, mLanderVertexCount, mLanderVertices, mLanderTexCoords))
-        {
-            return false;
-        }
-        data.clear();
-        mLanderTextureUnit = -1;
+        const GLESUtils::ProgramCacheStatistics& programs = GLESUtils::getProgramCacheStatistics();
+        LOG("Programs: %u compiled in %.2f ms, %u loaded from the cache in %.2f ms",
+            programs.compiledCount - programsBefore.compiledCount, programs.compiledMs - programsBefore.compiledMs,
+            programs.cachedCount - programsBefore.cachedCount, programs.cachedMs - programsBefore.cachedMs);
+        LOG("Program setup took %.2f ms",
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
     }
 
+    mModelTargetGuideViewTextureUnit = -1;
+
+    // Bound in place of a model texture until it is ready
+    unsigned char white[4] = { 255, 255, 255, 255 };
+    mWhiteTextureUnit = GLESUtils::createTexture(1, 1, white);
+
+    createStaticGeometry();
+
+    // The models are loaded when they are prefetched or first drawn
+    mAssets = std::move(assets);
+    mFrameIndex = 0;
+    mAstronautTextureUnit = -1;
+    mLanderTextureUnit = -1;
+
+    // The app only decodes the textures when this fails
+    mAstronautTextureLoad.needsPixels = !loadModelTexture("Astronaut", mAstronautTextureUnit, mAstronautTextureLoad);
+    mLanderTextureLoad.needsPixels = !loadModelTexture("VikingLander", mLanderTextureUnit, mLanderTextureLoad);
+
     return true;
 }
 
@@ -108,6 +186,11 @@ void GLESRenderer::deinit()
         GLESUtils::destroyTexture(mModelTargetGuideViewTextureUnit);
         mModelTargetGuideViewTextureUnit = -1;
     }
+    if (mWhiteTextureUnit != -1)
+    {
+        GLESUtils::destroyTexture(mWhiteTextureUnit);
+        mWhiteTextureUnit = -1;
+    }
     if (mAstronautTextureUnit != -1)
     {
         GLESUtils::destroyTexture(mAstronautTextureUnit);
@@ -118,66 +201,132 @@ void GLESRenderer::deinit()
         GLESUtils::destroyTexture(mLanderTextureUnit);
         mLanderTextureUnit = -1;
     }
+    // Waits for decodes still in progress, the streamer deletes the textures of unfinished uploads
+    mAstronautTextureLoad = TextureLoad();
+    mLanderTextureLoad = TextureLoad();
+    mTextureStreamer.deinit();
+    // Waits for loads still in progress
+    for (Model& model : mModels)
+    {
+        destroyModel(model);
+        model = Model();
+    }
+    mAssets.reset();
+    destroyStaticGeometry();
+    mUniformRing.deinit();
+}
+
+
+void GLESRenderer::prefetchModel(ModelId id)
+{
+    mModels[id].loadFailed = false;
+    useModel(id);
+}
+
+
+size_t GLESRenderer::getModelMemoryUsage() const
+{
+    size_t usage = 0;
+    for (const Model& model : mModels)
+    {
+        usage += model.memorySize;
+    }
+    return usage;
+}
+
+
+void GLESRenderer::beginFrame()
+{
+    mState.invalidate();
+    mState.resetStatistics();
+    mRenderQueue.clear();
+
+    ++mFrameIndex;
+    for (Model& model : mModels)
+    {
+        updateModel(model);
+    }
+    evictModels();
+}
+
+
+void GLESRenderer::endFrame()
+{
+    // Streaming binds textures to the active unit, which holds the camera
+    // texture until the video background is drawn, so it runs after that.
+    // The cache doesn't see the streamer's binds and is invalidated.
+    updateTexture(mAstronautTextureLoad, mAstronautTextureUnit);
+    updateTexture(mLanderTextureLoad, mLanderTextureUnit);
+    mTextureStreamer.update();
+    mState.invalidate();
+
+    for (Model& model : mModels)
+    {
+        submitModelInstances(model);
+    }
+    drawQueue();
+
+    // Leave no vertex array bound so buffer bindings made outside the
+    // renderer can't modify the renderer's vertex arrays
+    mState.bindVertexArray(0);
+
+    if (DEBUG_STATE)
+    {
+        const GLESStateCache::Statistics& statistics = mState.getStatistics();
+        LOG("GL state calls: %u issued, %u elided", statistics.issued, statistics.elided);
+    }
 }
 
 
 void GLESRenderer::setAstronautTexture(int width, int height, unsigned char* bytes)
 {
-    createTexture(width, height, bytes, mAstronautTextureUnit);
+    if (mAstronautTextureLoad.needsPixels)
+    {
+        mAstronautTextureLoad.needsPixels = false;
+        mAstronautTextureLoad.name = "Astronaut";
+        mAstronautTextureLoad.loadStart = std::chrono::steady_clock::now();
+        streamTexture(std::vector<uint8_t>(bytes, bytes + size_t(width) * height * 4), width, height,
+                      mAstronautTextureLoad);
+    }
 }
 
 
 void GLESRenderer::setLanderTexture(int width, int height, unsigned char* bytes)
 {
-    createTexture(width, height, bytes, mLanderTextureUnit);
+    if (mLanderTextureLoad.needsPixels)
+    {
+        mLanderTextureLoad.needsPixels = false;
+        mLanderTextureLoad.name = "VikingLander";
+        mLanderTextureLoad.loadStart = std::chrono::steady_clock::now();
+        streamTexture(std::vector<uint8_t>(bytes, bytes + size_t(width) * height * 4), width, height,
+                      mLanderTextureLoad);
+    }
 }
 
 
 void GLESRenderer::renderVideoBackground(
     Vuforia::Matrix44F& projectionMatrix,
     const float* vertices, const float* textureCoordinates,
-    const int numTriangles, const unsigned short* indices,
-    int textureUnit)
+    const int numVertices, const int numTriangles,
+    const unsigned short* indices, int textureUnit)
 {
-    GLboolean depthTest = GL_FALSE;
-    GLboolean cullTest = GL_FALSE;
-
-    glGetBooleanv(GL_DEPTH_TEST, &depthTest);
-    glGetBooleanv(GL_CULL_FACE, &cullTest);
+    updateVideoBackgroundMesh(vertices, textureCoordinates, numVertices, numTriangles, indices);
 
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
+    mState.disable(GL_DEPTH_TEST);
+    mState.disable(GL_CULL_FACE);
+    mState.disable(GL_BLEND);
 
-    // Load the shader and upload the vertex/texcoord/index data
-    glUseProgram(mVbShaderProgramID);
-    glVertexAttribPointer(static_cast<GLuint>(mVbVertexPositionHandle), 3, GL_FLOAT,
-                          GL_FALSE, 0, vertices);
-    glVertexAttribPointer(static_cast<GLuint>(mVbTextureCoordHandle), 2, GL_FLOAT,
-                          GL_FALSE, 0, textureCoordinates);
+    // Load the shader and bind the vertex/texcoord/index data
+    mState.useProgram(mVbShaderProgramID);
+    mState.bindVertexArray(mVbVertexArray);
 
     glUniform1i(mVbTexSampler2DHandle, textureUnit);
 
-    // Render the video background with the custom shader
-    // First, we enable the vertex arrays
-    glEnableVertexAttribArray(static_cast<GLuint>(mVbVertexPositionHandle));
-    glEnableVertexAttribArray(static_cast<GLuint>(mVbTextureCoordHandle));
-
     // Pass the projection matrix to OpenGL
     glUniformMatrix4fv(mVbMvpMatrixHandle, 1, GL_FALSE, projectionMatrix.data);
 
     // Then, we issue the render call
-    glDrawElements(GL_TRIANGLES, numTriangles * 3, GL_UNSIGNED_SHORT,
-                   indices);
-
-    // Finally, we disable the vertex arrays
-    glDisableVertexAttribArray(static_cast<GLuint>(mVbVertexPositionHandle));
-    glDisableVertexAttribArray(static_cast<GLuint>(mVbTextureCoordHandle));
-
-    if(depthTest)
-        glEnable(GL_DEPTH_TEST);
-
-    if(cullTest)
-        glEnable(GL_CULL_FACE);
+    glDrawElements(GL_TRIANGLES, numTriangles * 3, GL_UNSIGNED_SHORT, nullptr);
 
     GLESUtils::checkGlError("Render video background");
 }
@@ -196,56 +345,33 @@ void GLESRenderer::renderImageTarget(Vuforia::Matrix44F& projectionMatrix,
                                      Vuforia::Matrix44F& modelViewMatrix,
                                      Vuforia::Matrix44F& scaledModelViewMatrix)
 {
-    Vuforia::Matrix44F scaledModelViewProjectionMatrix;
-    MathUtils::multiplyMatrix(projectionMatrix, scaledModelViewMatrix, scaledModelViewProjectionMatrix);
-
+    mRenderQueue.setProjectionMatrix(projectionMatrix);
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    float stateLineWidth;
-    glGetFloatv(GL_LINE_WIDTH, &stateLineWidth);
-
-    glUseProgram(mUniformColorShaderProgramID);
-
-    glVertexAttribPointer(mUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_TRUE, 0,
-                          (const GLvoid *) &squareVertices[0]);
-
-    glEnableVertexAttribArray(mUniformColorVertexPositionHandle);
-
-    glUniformMatrix4fv(mUniformColorMvpMatrixHandle, 1, GL_FALSE,
-                       &scaledModelViewProjectionMatrix.data[0]);
+    RenderQueue::DrawItem item;
+    item.program = mUniformColorShaderProgramID;
+    item.vertexArray = mSquareVertexArray;
+    item.modelViewMatrix = scaledModelViewMatrix;
+    item.state = RenderQueue::STATE_DEPTH_TEST | RenderQueue::STATE_BLEND;
 
     // Draw translucent solid overlay
     // Color RGBA
-    glUniform4f(mUniformColorColorHandle, 1.0, 0.0, 0.0, 0.1);
-    glDrawElements(GL_TRIANGLES, NUM_SQUARE_INDEX, GL_UNSIGNED_SHORT,
-                   (const GLvoid *) &squareIndices[0]);
+    item.indexCount = NUM_SQUARE_INDEX;
+    item.color = Vuforia::Vec4F(1.0f, 0.0f, 0.0f, 0.1f);
+    mRenderQueue.submit(item);
 
     // Draw solid outline
-    glUniform4f(mUniformColorColorHandle, 1.0, 0.0, 0.0, 1.0);
-    glLineWidth(4.0f);
-    glDrawElements(GL_LINES, NUM_SQUARE_WIREFRAME_INDEX, GL_UNSIGNED_SHORT,
-                   (const GLvoid *) &squareWireframeIndices[0]);
-
-    glDisableVertexAttribArray(mUniformColorVertexPositionHandle);
-
-    GLESUtils::checkGlError("Render Image Target");
-
-    glLineWidth(stateLineWidth);
-
-    glDisable(GL_BLEND);
-    glDisable(GL_DEPTH_TEST);
+    // The wireframe indices follow the solid indices in the index buffer
+    item.primitive = GL_LINES;
+    item.indexCount = NUM_SQUARE_WIREFRAME_INDEX;
+    item.indexOffset = NUM_SQUARE_INDEX * sizeof(unsigned short);
+    item.color = Vuforia::Vec4F(1.0f, 0.0f, 0.0f, 1.0f);
+    item.lineWidth = 4.0f;
+    mRenderQueue.submit(item);
 
     Vuforia::Vec3F axis2cmSize = Vuforia::Vec3F(0.02f, 0.02f, 0.02f);
     renderAxis(projectionMatrix, modelViewMatrix, axis2cmSize, 4.0f);
 
-    Vuforia::Matrix44F modelViewProjectionMatrix;
-    MathUtils::multiplyMatrix(projectionMatrix, modelViewMatrix, modelViewProjectionMatrix);
-    renderModel(modelViewProjectionMatrix,
-        mAstronautVertexCount, mAstronautVertices.data(), mAstronautTexCoords.data(),
-        mAstronautTextureUnit);
+    renderModel(modelViewMatrix, useModel(MODEL_ASTRONAUT), mAstronautTextureUnit);
 }
 
 
@@ -253,12 +379,9 @@ void GLESRenderer::renderModelTarget(Vuforia::Matrix44F& projectionMatrix,
                                      Vuforia::Matrix44F& modelViewMatrix,
                                      Vuforia::Matrix44F& /*scaledModelViewMatrix*/)
 {
-    Vuforia::Matrix44F modelViewProjectionMatrix;
-    MathUtils::multiplyMatrix(projectionMatrix, modelViewMatrix, modelViewProjectionMatrix);
+    mRenderQueue.setProjectionMatrix(projectionMatrix);
 
-    renderModel(modelViewProjectionMatrix,
-        mLanderVertexCount, mLanderVertices.data(), mLanderTexCoords.data(),
-        mLanderTextureUnit);
+    renderModel(modelViewMatrix, useModel(MODEL_LANDER), mLanderTextureUnit);
 
     Vuforia::Vec3F axis10cmSize = Vuforia::Vec3F(0.1f, 0.1f, 0.1f);
     renderAxis(projectionMatrix, modelViewMatrix, axis10cmSize, 4.0f);
@@ -269,273 +392,720 @@ void GLESRenderer::renderModelTargetGuideView(Vuforia::Matrix44F& projectionMatr
                                               Vuforia::Matrix44F& modelViewMatrix,
                                               const Vuforia::Image *image)
 {
-    Vuforia::Matrix44F modelViewProjectionMatrix;
-    MathUtils::multiplyMatrix(projectionMatrix, modelViewMatrix, modelViewProjectionMatrix);
+    mRenderQueue.setProjectionMatrix(projectionMatrix);
 
+    if (mModelTargetGuideViewTextureUnit == -1)
+    {
+        mModelTargetGuideViewTextureUnit = GLESUtils::createTexture(image);
+        // Creating the texture changed the binding behind the cache's back
+        mState.invalidate();
+    }
 
-    glDisable(GL_DEPTH_TEST);
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // Drawn without depth test, so as an overlay after everything else
+    RenderQueue::DrawItem item;
+    item.program = mTextureUniformColorShaderProgramID;
+    item.vertexArray = mGuideViewVertexArray;
+    item.texture = mModelTargetGuideViewTextureUnit;
+    item.indexCount = NUM_SQUARE_INDEX;
+    item.modelViewMatrix = modelViewMatrix;
+    item.color = Vuforia::Vec4F(1.0f, 1.0f, 1.0f, 0.7f);
+    item.state = RenderQueue::STATE_BLEND;
+    mRenderQueue.submit(item);
+}
 
-    glActiveTexture(GL_TEXTURE0);
 
-    if (mModelTargetGuideViewTextureUnit == -1)
+void GLESRenderer::streamTexture(std::vector<uint8_t> pixels, uint32_t width, uint32_t height, TextureLoad& load)
+{
+    if (load.upload != 0)
     {
-        mModelTargetGuideViewTextureUnit = GLESUtils::createTexture(image);
+        mTextureStreamer.cancel(load.upload);
     }
-    glBindTexture(GL_TEXTURE_2D, mModelTargetGuideViewTextureUnit);
+    // The driver builds the mip chain faster than the CPU on this thread could
+    load.upload = mTextureStreamer.queue(std::move(pixels), width, height, true);
+}
 
-    glEnableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
-    glVertexAttribPointer(mTextureUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&squareVertices[0]);
 
-    glEnableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
-    glVertexAttribPointer(mTextureUniformColorTextureCoordHandle, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&squareTexCoords[0]);
+bool GLESRenderer::loadCompressedTexture(const char* name, int& textureId)
+{
+    // In order of preference, ASTC has the better quality for its size
+    static const char* const SUFFIXES[] = { ".astc.ktx", ".etc2.ktx" };
 
-    glUseProgram(mTextureUniformColorShaderProgramID);
-    glUniformMatrix4fv(mTextureUniformColorMvpMatrixHandle, 1, GL_FALSE, (GLfloat*)modelViewProjectionMatrix.data);
-    glUniform4f(mTextureUniformColorColorHandle, 1.0f, 1.0f, 1.0f, 0.7f);
-    glUniform1i(mTextureUniformColorTexSampler2DHandle, 0); //texture unit, not handle
+    for (const char* suffix : SUFFIXES)
+    {
+        std::string filename = std::string(name) + suffix;
+        std::unique_ptr<Asset> asset = mAssets->open(filename.c_str());
+        KtxTexture::View ktx;
+        if (asset == nullptr || !KtxTexture::parse(asset->getData(), asset->getSize(), ktx))
+        {
+            continue;
+        }
+        const uint32_t format = ktx.header.glInternalFormat;
+        if (!GLESUtils::isCompressedFormatSupported(format))
+        {
+            LOG("Texture %s: %s is not supported", filename.c_str(), KtxTexture::getFormatName(format));
+            continue;
+        }
 
-    // Draw
-    glDrawElements(GL_TRIANGLES, NUM_SQUARE_INDEX, GL_UNSIGNED_SHORT, (const GLvoid*)&squareIndices[0]);
+        auto start = std::chrono::steady_clock::now();
+        if (textureId != -1)
+        {
+            GLESUtils::destroyTexture(textureId);
+        }
+        textureId = GLESUtils::createTexture(ktx);
+        double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
-    //disable input data structures
-    glDisableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
-    glDisableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
-    glUseProgram(0);
+        size_t compressedBytes = 0;
+        for (const KtxTexture::Level& level : ktx.levels)
+        {
+            compressedBytes += level.size;
+        }
+        LOG("Texture %s: %s %ux%u, %zu levels, %zu bytes (%zu for level 0 as RGBA8), uploaded in %.2f ms",
+            filename.c_str(), KtxTexture::getFormatName(format), ktx.header.pixelWidth, ktx.header.pixelHeight,
+            ktx.levels.size(), compressedBytes, size_t(ktx.header.pixelWidth) * ktx.header.pixelHeight * 4,
+            uploadMs);
+        return textureId != -1;
+    }
+    return false;
+}
+
+
+bool GLESRenderer::loadImageTexture(const char* filename, TextureLoad& load)
+{
+    std::unique_ptr<Asset> asset = mAssets->open(filename);
+    ImageDecoder::Info info;
+    if (asset == nullptr || !ImageDecoder::getInfo(asset->getData(), asset->getSize(), info))
+    {
+        return false;
+    }
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    load.name = filename;
+    load.loadStart = std::chrono::steady_clock::now();
+    load.pendingImage = std::async(std::launch::async, decodeImage, std::move(asset));
+    return true;
+}
 
-    GLESUtils::checkGlError("Render guide view");
 
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
+bool GLESRenderer::loadModelTexture(const char* name, int& textureId, TextureLoad& load)
+{
+    return loadCompressedTexture(name, textureId) || loadImageTexture((std::string(name) + ".jpg").c_str(), load);
 }
 
 
-void GLESRenderer::createTexture(int width, int height, unsigned char* bytes, int& textureId)
+void GLESRenderer::updateTexture(TextureLoad& load, int& textureId)
 {
+    if (load.pendingImage.valid() &&
+        load.pendingImage.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        DecodedImage image = load.pendingImage.get();
+        if (image.pixels.empty())
+        {
+            // The app sets the pixels instead, see needsTextures
+            LOG("Error decoding texture %s", load.name.c_str());
+            load.needsPixels = true;
+        }
+        else
+        {
+            LOG("Texture %s: decoded in %.2f ms in the background", load.name.c_str(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load.loadStart).count());
+            streamTexture(std::move(image.pixels), image.width, image.height, load);
+        }
+    }
+
+    if (load.upload == 0)
+    {
+        return;
+    }
+    GLuint texture = mTextureStreamer.takeTexture(load.upload);
+    if (texture == 0)
+    {
+        return;
+    }
+
     if (textureId != -1)
     {
         GLESUtils::destroyTexture(textureId);
-        textureId = -1;
     }
-    textureId = GLESUtils::createTexture(width, height, bytes);
+    textureId = static_cast<int>(texture);
+    load.upload = 0;
+    LOG("Texture %s: ready %.2f ms after its load started, %zu bytes still streaming", load.name.c_str(),
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load.loadStart).count(),
+        mTextureStreamer.getPendingBytes());
+}
+
+
+GLESRenderer::DecodedImage GLESRenderer::decodeImage(std::unique_ptr<Asset> asset)
+{
+    DecodedImage image;
+    ImageDecoder::Info info;
+    if (!ImageDecoder::getInfo(asset->getData(), asset->getSize(), info))
+    {
+        return image;
+    }
+
+    const size_t stride = size_t(info.width) * ImageDecoder::PIXEL_SIZE;
+    image.pixels.resize(stride * info.height);
+    // Bottom row first, the order GL expects texture rows in
+    if (!ImageDecoder::decode(asset->getData(), asset->getSize(), image.pixels.data(), stride, true))
+    {
+        image.pixels.clear();
+        return image;
+    }
+    image.width = info.width;
+    image.height = info.height;
+    return image;
 }
 
 
 void GLESRenderer::renderCube(const Vuforia::Matrix44F& projectionMatrix, const Vuforia::Matrix44F& modelViewMatrix,
                               float scale, const Vuforia::Vec4F& color)
 {
-    Vuforia::Matrix44F scaledModelViewMatrix;
-    Vuforia::Matrix44F modelViewProjectionMatrix;
-    Vuforia::Vec3F scaleVec(scale, scale, scale);
+    // Render with const ambient diffuse light uniform color shader
+    RenderQueue::DrawItem item;
+    item.program = mUniformColorShaderProgramID;
+    item.vertexArray = mCubeVertexArray;
+    item.indexCount = NUM_CUBE_INDEX;
+    item.color = color;
+    item.state = RenderQueue::STATE_DEPTH_TEST;
+    item.modelViewMatrix = Math::scaled(modelViewMatrix, Math::Vec3(scale, scale, scale));
+    mRenderQueue.setProjectionMatrix(projectionMatrix);
+    mRenderQueue.submit(item);
+}
 
-    scaledModelViewMatrix = MathUtils::Matrix44FScale(scaleVec, modelViewMatrix);
-    MathUtils::multiplyMatrix(projectionMatrix, scaledModelViewMatrix, modelViewProjectionMatrix);
 
-    ///////////////////////////////////////////////////////////////
-    // Render with const ambient diffuse light uniform color shader
-    glEnable(GL_DEPTH_TEST);
-    glUseProgram(mUniformColorShaderProgramID);
+void GLESRenderer::renderAxis(const Vuforia::Matrix44F& projectionMatrix, const Vuforia::Matrix44F& modelViewMatrix,
+                              const Vuforia::Vec3F& scale,
+                              float lineWidth)
+{
+    // Render with vertex color shader
+    RenderQueue::DrawItem item;
+    item.program = mVertexColorShaderProgramID;
+    item.vertexArray = mAxisVertexArray;
+    item.primitive = GL_LINES;
+    item.indexCount = NUM_AXIS_INDEX;
+    item.lineWidth = lineWidth;
+    item.state = RenderQueue::STATE_DEPTH_TEST;
+    item.modelViewMatrix = Math::scaled(modelViewMatrix, scale);
+    mRenderQueue.setProjectionMatrix(projectionMatrix);
+    mRenderQueue.submit(item);
+}
 
-    glEnableVertexAttribArray(mUniformColorVertexPositionHandle);
 
-    glVertexAttribPointer(mUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&cubeVertices[0]);
+void GLESRenderer::renderModel(const Vuforia::Matrix44F& modelViewMatrix,
+    Model& model, GLint textureId)
+{
+    // Not drawn until it is loaded
+    if (model.vertexArray == 0)
+    {
+        return;
+    }
 
-    glUniformMatrix4fv(mUniformColorMvpMatrixHandle, 1, GL_FALSE, (GLfloat*)modelViewProjectionMatrix.data);
-    glUniform4f(mUniformColorColorHandle, color.data[0], color.data[1], color.data[2], color.data[3]);
+    // Drawn in its uniform color with the white texture until its texture is ready
+    GLuint texture = static_cast<GLuint>(textureId == -1 ? mWhiteTextureUnit : textureId);
+    if (mInstancingEnabled)
+    {
+        model.instanceMatrices.push_back(modelViewMatrix);
+        model.instanceTexture = texture;
+        return;
+    }
 
-    // Draw
-    glDrawElements(GL_TRIANGLES, NUM_CUBE_INDEX, GL_UNSIGNED_SHORT, (const GLvoid*)&cubeIndices[0]);
+    // The model textures are opaque, so the model is drawn in the opaque pass
+    RenderQueue::DrawItem item;
+    item.program = mTextureUniformColorShaderProgramID;
+    item.vertexArray = model.vertexArray;
+    item.texture = texture;
+    item.indexCount = model.indexCount;
+    item.indexType = model.indexType;
+    item.modelViewMatrix = modelViewMatrix;
+    item.state = RenderQueue::STATE_DEPTH_TEST | RenderQueue::STATE_CULL_FACE;
+    mRenderQueue.submit(item);
+}
 
-    //disable input data structures
-    glDisableVertexAttribArray(mUniformColorVertexPositionHandle);
-    glUseProgram(0);
-    glDisable(GL_DEPTH_TEST);
 
-    GLESUtils::checkGlError("Render cube");
-    ///////////////////////////////////////////////////////
+void GLESRenderer::submitModelInstances(Model& model)
+{
+    if (model.instanceMatrices.empty())
+    {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, model.instanceBuffer);
+    GLESUtils::streamBuffer(GL_ARRAY_BUFFER, model.instanceMatrices.size() * sizeof(Vuforia::Matrix44F),
+                            model.instanceMatrices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    RenderQueue::DrawItem item;
+    item.program = mTextureColorInstancedShaderProgramID;
+    item.vertexArray = model.instancedVertexArray;
+    item.texture = model.instanceTexture;
+    item.indexCount = model.indexCount;
+    item.indexType = model.indexType;
+    item.instanceCount = static_cast<GLsizei>(model.instanceMatrices.size());
+    item.state = RenderQueue::STATE_DEPTH_TEST | RenderQueue::STATE_CULL_FACE;
+
+    // Sort the batch by its nearest instance
+    item.modelViewMatrix = *std::min_element(model.instanceMatrices.begin(), model.instanceMatrices.end(),
+        [this](const Vuforia::Matrix44F& a, const Vuforia::Matrix44F& b)
+        { return mRenderQueue.getDepth(a) < mRenderQueue.getDepth(b); });
+    mRenderQueue.submit(item);
+
+    model.instanceMatrices.clear();
 }
 
 
-void GLESRenderer::renderAxis(const Vuforia::Matrix44F& projectionMatrix, const Vuforia::Matrix44F& modelViewMatrix,
-                              const Vuforia::Vec3F& scale,
-                              float lineWidth)
+void GLESRenderer::drawQueue()
 {
-    Vuforia::Matrix44F scaledModelViewMatrix;
-    Vuforia::Matrix44F modelViewProjectionMatrix;
+    mRenderQueue.sort();
 
-    scaledModelViewMatrix = MathUtils::Matrix44FScale(scale, modelViewMatrix);
-    MathUtils::multiplyMatrix(projectionMatrix, scaledModelViewMatrix, modelViewProjectionMatrix);
+    const std::vector<RenderQueue::DrawItem>& items = mRenderQueue.getItems();
+    if (items.empty())
+    {
+        return;
+    }
 
-    ///////////////////////////////////////////////////////
-    // Render with vertex color shader
-    glEnable(GL_DEPTH_TEST);
-    glUseProgram(mVertexColorShaderProgramID);
+    // Gather the uniform data of the frame so it is uploaded with one map,
+    // each block starts at a multiple of the offset alignment
+    const GLsizeiptr cameraDataSize = mUniformRing.align(sizeof(CameraData));
+    const GLsizeiptr objectDataSize = mUniformRing.align(sizeof(ObjectData));
+    mUniformData.resize(cameraDataSize + items.size() * objectDataSize);
 
-    glEnableVertexAttribArray(mVertexColorVertexPositionHandle);
-    glVertexAttribPointer(mVertexColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&axisVertices[0]);
+    CameraData cameraData;
+    cameraData.projectionMatrix = mRenderQueue.getProjectionMatrix();
+    memcpy(mUniformData.data(), &cameraData, sizeof(cameraData));
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        ObjectData objectData;
+        objectData.modelViewMatrix = items[i].modelViewMatrix;
+        objectData.color = items[i].color;
+        memcpy(mUniformData.data() + cameraDataSize + i * objectDataSize, &objectData, sizeof(objectData));
+    }
 
-    glEnableVertexAttribArray(mVertexColorColorHandle);
-    glVertexAttribPointer(mVertexColorColorHandle, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&axisColors[0]);
+    GLintptr uniformOffset = mUniformRing.upload(mUniformData.data(), mUniformData.size());
+    if (uniformOffset < 0)
+    {
+        mRenderQueue.clear();
+        return;
+    }
+
+    GLuint uniformBuffer = mUniformRing.getBuffer();
+    glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_DATA_BINDING, uniformBuffer, uniformOffset, sizeof(CameraData));
+    GLintptr objectDataOffset = uniformOffset + cameraDataSize;
 
-    glUniformMatrix4fv(mVertexColorMvpMatrixHandle, 1, GL_FALSE, (GLfloat*)modelViewProjectionMatrix.data);
+    for (const RenderQueue::DrawItem& item : items)
+    {
+        mState.setEnabled(GL_DEPTH_TEST, (item.state & RenderQueue::STATE_DEPTH_TEST) != 0);
+        mState.setEnabled(GL_BLEND, (item.state & RenderQueue::STATE_BLEND) != 0);
+        mState.setEnabled(GL_CULL_FACE, (item.state & RenderQueue::STATE_CULL_FACE) != 0);
+        if (item.state & RenderQueue::STATE_BLEND)
+        {
+            mState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        if (item.state & RenderQueue::STATE_CULL_FACE)
+        {
+            mState.cullFace(GL_BACK);
+            mState.frontFace(GL_CCW);
+        }
+        if (item.primitive == GL_LINES)
+        {
+            mState.lineWidth(item.lineWidth);
+        }
 
-    // Draw
-    float stateLineWidth;
-    glGetFloatv(GL_LINE_WIDTH, &stateLineWidth);
+        mState.useProgram(item.program);
+        mState.bindVertexArray(item.vertexArray);
 
-    glLineWidth(lineWidth);
+        if (item.program == mTextureColorInstancedShaderProgramID ||
+            item.program == mTextureUniformColorShaderProgramID)
+        {
+            mState.activeTexture(GL_TEXTURE0);
+            mState.bindTexture2D(item.texture);
+        }
 
-    glDrawElements(GL_LINES, NUM_AXIS_INDEX, GL_UNSIGNED_SHORT, (const GLvoid*)&axisIndices[0]);
+        // The item's matrix and color, instanced draws only use the color
+        glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_DATA_BINDING, uniformBuffer, objectDataOffset, sizeof(ObjectData));
+        objectDataOffset += objectDataSize;
 
-    //disable input data structures
-    glDisableVertexAttribArray(mVertexColorVertexPositionHandle);
-    glDisableVertexAttribArray(mVertexColorColorHandle);
-    glUseProgram(0);
-    glDisable(GL_DEPTH_TEST);
+        if (item.instanceCount > 0)
+        {
+            glDrawElementsInstanced(item.primitive, item.indexCount, item.indexType,
+                                    (const GLvoid*) item.indexOffset, item.instanceCount);
+        }
+        else
+        {
+            glDrawElements(item.primitive, item.indexCount, item.indexType, (const GLvoid*) item.indexOffset);
+        }
+    }
 
-    glLineWidth(stateLineWidth);
+    mUniformRing.endFrame();
 
-    GLESUtils::checkGlError("Render axis");
-    ///////////////////////////////////////////////////////
+    GLESUtils::checkGlError("Draw render queue");
+
+    mRenderQueue.clear();
 }
 
 
-void GLESRenderer::renderModel(Vuforia::Matrix44F modelViewProjectionMatrix,
-    const int numVertices, const float* vertices, const float* textureCoordinates,
-    GLint textureId)
+void GLESRenderer::setUniformBlockBinding(GLuint program, const char* blockName, GLuint binding)
 {
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glFrontFace(GL_CCW);
+    GLuint blockIndex = glGetUniformBlockIndex(program, blockName);
+    if (blockIndex != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, blockIndex, binding);
+    }
+}
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glUseProgram(mTextureUniformColorShaderProgramID);
-
-    glEnableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
-    glVertexAttribPointer(mTextureUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0,
-                          (const GLvoid *) vertices);
+GLESRenderer::Model& GLESRenderer::useModel(ModelId id)
+{
+    Model& model = mModels[id];
+    model.lastUsedFrame = mFrameIndex;
+    if (model.vertexArray == 0 && !model.pendingMesh.valid() && !model.loadFailed && mAssets != nullptr)
+    {
+        loadModel(MODEL_ASSETS[id].meshFilename, MODEL_ASSETS[id].objFilename, model);
+    }
+    return model;
+}
 
-    glEnableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
-    glVertexAttribPointer(mTextureUniformColorTextureCoordHandle, 2, GL_FLOAT, GL_FALSE, 0,
-                          (const GLvoid *) textureCoordinates);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureId);
+void GLESRenderer::evictModels()
+{
+    size_t usage = getModelMemoryUsage();
+    while (usage > mModelMemoryBudget)
+    {
+        // Models drawn in the last frame are kept even over the budget
+        Model* leastRecentlyUsed = nullptr;
+        for (Model& model : mModels)
+        {
+            if (model.memorySize > 0 && model.lastUsedFrame + 1 < mFrameIndex &&
+                (leastRecentlyUsed == nullptr || model.lastUsedFrame < leastRecentlyUsed->lastUsedFrame))
+            {
+                leastRecentlyUsed = &model;
+            }
+        }
+        if (leastRecentlyUsed == nullptr)
+        {
+            return;
+        }
 
-    glUniformMatrix4fv(mTextureUniformColorMvpMatrixHandle, 1, GL_FALSE,
-                       (GLfloat *) modelViewProjectionMatrix.data);
-    glUniform4f(mTextureUniformColorColorHandle, 1.0f, 1.0f, 1.0f, 1.0f);
-    glUniform1i(mTextureUniformColorTexSampler2DHandle, 0); //texture unit, not handle
+        LOG("Unloading model %s, %zu bytes resident of a %zu byte budget",
+            leastRecentlyUsed->name, usage, mModelMemoryBudget);
+        usage -= leastRecentlyUsed->memorySize;
+        destroyModel(*leastRecentlyUsed);
+    }
+}
 
-    // Draw
-    glDrawArrays(GL_TRIANGLES, 0, numVertices);
 
-    //disable input data structures
-    glDisableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
-    glDisableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
-    glUseProgram(0);
+void GLESRenderer::loadModel(const char* meshFilename, const char* objFilename, Model& model)
+{
+    destroyModel(model);
+    model.name = objFilename;
+    model.loadStart = std::chrono::steady_clock::now();
+    // The task keeps the asset source alive, the filenames are literals
+    std::shared_ptr<const AssetSource> assets = mAssets;
+    model.pendingMesh = std::async(std::launch::async, [assets, meshFilename, objFilename]()
+    {
+        return readModel(*assets, meshFilename, objFilename);
+    });
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
 
-    GLESUtils::checkGlError("Render model");
+void GLESRenderer::updateModel(Model& model)
+{
+    if (!model.pendingMesh.valid() ||
+        model.pendingMesh.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return;
+    }
 
-    glDisable(GL_BLEND);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
+    auto ready = std::chrono::steady_clock::now();
+    std::unique_ptr<Asset> meshData = model.pendingMesh.get();
+    if (meshData == nullptr || !uploadModel(meshData->getData(), meshData->getSize(), model))
+    {
+        LOG("Error loading model %s", model.name);
+        // Drawing the model doesn't start the load again every frame
+        model.loadFailed = true;
+        return;
+    }
+    auto uploaded = std::chrono::steady_clock::now();
+    LOG("Model %s: loaded in %.2f ms in the background, uploaded in %.2f ms, %zu bytes", model.name,
+        std::chrono::duration<double, std::milli>(ready - model.loadStart).count(),
+        std::chrono::duration<double, std::milli>(uploaded - ready).count(), model.memorySize);
 }
 
 
-bool GLESRenderer::readAsset(AAssetManager* assetManager, const char* filename, std::vector<char>& data)
+std::unique_ptr<Asset> GLESRenderer::readModel(const AssetSource& assets, const char* meshFilename,
+                                               const char* objFilename)
 {
-    LOG("Reading asset %s", filename);
-    AAsset* asset = AAssetManager_open(assetManager, filename, AASSET_MODE_STREAMING);
-    if (asset == nullptr)
+    // Prefer the binary mesh cache, the asset buffer is uploaded directly without copying
+    std::unique_ptr<Asset> meshAsset = assets.open(meshFilename);
+    if (meshAsset != nullptr)
     {
-        LOG("Error opening asset file %s", filename);
-        return false;
+        LOG("Loading mesh cache %s", meshFilename);
+        MeshCache::View view;
+        if (MeshCache::parse(meshAsset->getData(), meshAsset->getSize(), view))
+        {
+            return meshAsset;
+        }
+        LOG("Falling back to %s", objFilename);
     }
-    auto assetSize = AAsset_getLength(asset);
-    data.reserve(assetSize);
-    char buf[BUFSIZ];
-    int nb_read = 0;
-    while ((nb_read = AAsset_read(asset, buf, BUFSIZ)) > 0)
+
+    LOG("Reading asset %s", objFilename);
+    std::unique_ptr<Asset> objAsset = assets.open(objFilename);
+    if (objAsset == nullptr)
     {
-        std::copy(&buf[0], &buf[BUFSIZ], std::back_inserter(data));
+        LOG("Error opening asset file %s", objFilename);
+        return nullptr;
     }
-    AAsset_close(asset);
-    if (nb_read < 0)
+    std::vector<char> meshData;
+    if (!loadObjModel(objAsset->getData(), objAsset->getSize(), meshData))
     {
-        LOG("Error reading asset file %s", filename);
-        return false;
+        return nullptr;
     }
-    return true;
+    return std::unique_ptr<Asset>(new MemoryAsset(std::move(meshData)));
 }
 
 
-bool GLESRenderer::loadObjModel(const std::vector<char>& data, int& numVertices, std::vector<float>& vertices, std::vector<float>& texCoords)
+bool GLESRenderer::loadObjModel(const char* data, size_t size, std::vector<char>& meshData, bool optimize)
 {
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
     std::string err;
 
-    MemoryInputStream aFileDataStream(data.data(), data.size());
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &aFileDataStream);
+    // Parsed in place, the asset data isn't copied into a stream. Large
+    // models are split between all the cores.
+    bool ret = tinyobj::LoadObjFromBuffer(&attrib, &shapes, &err, data, size, true,
+                                          std::thread::hardware_concurrency());
     if (!ret || !err.empty())
     {
         LOG("Error loading model (%s)", err.c_str());
         return false;
     }
 
-    numVertices = 0;
-    vertices.clear();
-    texCoords.clear();
-    // Loop over shapes
-    // s is the index into the shapes vector
-    // f is the index of the current face
-    // v is the index of the current vertex
-    for (size_t s = 0; s < shapes.size(); ++s)
+    MeshCache::Mesh mesh;
+    if (!MeshCache::buildFromObj(attrib, shapes, mesh))
     {
-        // Loop over faces(polygon)
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); ++f)
-        {
-            int fv = shapes[s].mesh.num_face_vertices[f];
-            numVertices += fv;
+        return false;
+    }
 
-            // Loop over vertices in the face.
-            for (size_t v = 0; v < fv; ++v)
-            {
-                // access to vertex
-                tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-
-                vertices.push_back(attrib.vertices[3 * idx.vertex_index + 0]);
-                vertices.push_back(attrib.vertices[3 * idx.vertex_index + 1]);
-                vertices.push_back(attrib.vertices[3 * idx.vertex_index + 2]);
-
-                // The model may not have texture coordinates for every vertex
-                // If a texture coordinate is missing we just set it to 0,0
-                // This may not be suitable for rendering some OBJ model files
-                if (idx.texcoord_index < 0)
-                {
-                    texCoords.push_back(0.f);
-                    texCoords.push_back(0.f);
-                }
-                else
-                {
-                    texCoords.push_back(attrib.texcoords[2 * idx.texcoord_index + 0]);
-                    texCoords.push_back(attrib.texcoords[2 * idx.texcoord_index + 1]);
-                }
-            }
-            index_offset += fv;
-        }
+    if (optimize)
+    {
+        auto before = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertexCount());
+        MeshOptimizer::optimize(mesh);
+        auto after = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertexCount());
+        LOG("Optimized model: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+            before.acmr, after.acmr, before.atvr, after.atvr);
     }
+
+    MeshCache::serialize(mesh, meshData);
     return true;
 }
+
+
+bool GLESRenderer::uploadModel(const void* meshData, size_t size, Model& model)
+{
+    MeshCache::View view;
+    if (!MeshCache::parse(meshData, size, view))
+    {
+        return false;
+    }
+
+    destroyModel(model);
+
+    glGenVertexArrays(1, &model.vertexArray);
+    glBindVertexArray(model.vertexArray);
+
+    model.vertexBuffer = GLESUtils::createBuffer(GL_ARRAY_BUFFER, view.vertexBytes, view.vertices);
+    glEnableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
+    glVertexAttribPointer(mTextureUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE,
+                          MeshCache::VERTEX_STRIDE, (const GLvoid *) MeshCache::POSITION_OFFSET);
+    glEnableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
+    glVertexAttribPointer(mTextureUniformColorTextureCoordHandle, 2, GL_FLOAT, GL_FALSE,
+                          MeshCache::VERTEX_STRIDE, (const GLvoid *) MeshCache::TEXCOORD_OFFSET);
+
+    // The index buffer binding is recorded in the vertex array
+    model.indexBuffer = GLESUtils::createBuffer(GL_ELEMENT_ARRAY_BUFFER, view.indexBytes, view.indices);
+
+    // The instanced vertex array shares the model buffers and adds the instance matrices,
+    // a mat4 attribute uses four consecutive locations, one per column
+    glGenVertexArrays(1, &model.instancedVertexArray);
+    glBindVertexArray(model.instancedVertexArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, model.vertexBuffer);
+    glEnableVertexAttribArray(mTextureColorInstancedVertexPositionHandle);
+    glVertexAttribPointer(mTextureColorInstancedVertexPositionHandle, 3, GL_FLOAT, GL_FALSE,
+                          MeshCache::VERTEX_STRIDE, (const GLvoid *) MeshCache::POSITION_OFFSET);
+    glEnableVertexAttribArray(mTextureColorInstancedTextureCoordHandle);
+    glVertexAttribPointer(mTextureColorInstancedTextureCoordHandle, 2, GL_FLOAT, GL_FALSE,
+                          MeshCache::VERTEX_STRIDE, (const GLvoid *) MeshCache::TEXCOORD_OFFSET);
+
+    glGenBuffers(1, &model.instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, model.instanceBuffer);
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint location = mTextureColorInstancedModelViewMatrixHandle + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Vuforia::Matrix44F),
+                              (const GLvoid *) (column * 4 * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model.indexBuffer);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    model.indexCount = static_cast<GLsizei>(view.header.indexCount);
+    model.indexType = view.header.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    model.memorySize = view.vertexBytes + view.indexBytes;
+
+    GLESUtils::checkGlError("Upload model");
+
+    return true;
+}
+
+
+void GLESRenderer::destroyModel(Model& model)
+{
+    deleteVertexArray(model.vertexArray);
+    deleteVertexArray(model.instancedVertexArray);
+    deleteBuffer(model.vertexBuffer);
+    deleteBuffer(model.indexBuffer);
+    deleteBuffer(model.instanceBuffer);
+    model.indexCount = 0;
+    model.memorySize = 0;
+    model.instanceMatrices.clear();
+    model.instanceTexture = 0;
+    model.loadFailed = false;
+    // Releasing the pending load waits for it to finish
+    model.pendingMesh = std::future<std::unique_ptr<Asset>>();
+}
+
+
+void GLESRenderer::createStaticGeometry()
+{
+    // Square, positions followed by texture coordinates
+    // The index buffer holds the solid indices followed by the wireframe indices
+    std::vector<float> squareData(squareVertices, squareVertices + NUM_SQUARE_VERTEX * 3);
+    squareData.insert(squareData.end(), squareTexCoords, squareTexCoords + NUM_SQUARE_VERTEX * 2);
+    std::vector<unsigned short> squareIndexData(squareIndices, squareIndices + NUM_SQUARE_INDEX);
+    squareIndexData.insert(squareIndexData.end(), squareWireframeIndices,
+                           squareWireframeIndices + NUM_SQUARE_WIREFRAME_INDEX);
+    const GLvoid* squareTexCoordOffset = (const GLvoid*) (NUM_SQUARE_VERTEX * 3 * sizeof(float));
+
+    mSquareVertexBuffer = GLESUtils::createBuffer(GL_ARRAY_BUFFER, squareData.size() * sizeof(float), squareData.data());
+    mSquareIndexBuffer = GLESUtils::createBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                                                 squareIndexData.size() * sizeof(unsigned short), squareIndexData.data());
+
+    glGenVertexArrays(1, &mSquareVertexArray);
+    glBindVertexArray(mSquareVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, mSquareVertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mSquareIndexBuffer);
+    glEnableVertexAttribArray(mUniformColorVertexPositionHandle);
+    glVertexAttribPointer(mUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glGenVertexArrays(1, &mGuideViewVertexArray);
+    glBindVertexArray(mGuideViewVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, mSquareVertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mSquareIndexBuffer);
+    glEnableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
+    glVertexAttribPointer(mTextureUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
+    glVertexAttribPointer(mTextureUniformColorTextureCoordHandle, 2, GL_FLOAT, GL_FALSE, 0, squareTexCoordOffset);
+    glBindVertexArray(0);
+
+    // Cube
+    glGenVertexArrays(1, &mCubeVertexArray);
+    glBindVertexArray(mCubeVertexArray);
+    mCubeVertexBuffer = GLESUtils::createBuffer(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices);
+    mCubeIndexBuffer = GLESUtils::createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices);
+    glEnableVertexAttribArray(mUniformColorVertexPositionHandle);
+    glVertexAttribPointer(mUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindVertexArray(0);
+
+    // Axis, positions followed by colors
+    std::vector<float> axisData(axisVertices, axisVertices + NUM_AXIS_VERTEX * 3);
+    axisData.insert(axisData.end(), axisColors, axisColors + NUM_AXIS_COLOR * 4);
+    const GLvoid* axisColorOffset = (const GLvoid*) (NUM_AXIS_VERTEX * 3 * sizeof(float));
+
+    glGenVertexArrays(1, &mAxisVertexArray);
+    glBindVertexArray(mAxisVertexArray);
+    mAxisVertexBuffer = GLESUtils::createBuffer(GL_ARRAY_BUFFER, axisData.size() * sizeof(float), axisData.data());
+    mAxisIndexBuffer = GLESUtils::createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(axisIndices), axisIndices);
+    glEnableVertexAttribArray(mVertexColorVertexPositionHandle);
+    glVertexAttribPointer(mVertexColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(mVertexColorColorHandle);
+    glVertexAttribPointer(mVertexColorColorHandle, 4, GL_FLOAT, GL_FALSE, 0, axisColorOffset);
+    glBindVertexArray(0);
+
+    // Video background, the buffers are filled when the first frame is rendered
+    glGenVertexArrays(1, &mVbVertexArray);
+    glGenBuffers(1, &mVbVertexBuffer);
+    glGenBuffers(1, &mVbIndexBuffer);
+    mVbVertices.clear();
+    mVbIndices.clear();
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    GLESUtils::checkGlError("Create static geometry");
+}
+
+
+void GLESRenderer::destroyStaticGeometry()
+{
+    deleteVertexArray(mSquareVertexArray);
+    deleteVertexArray(mGuideViewVertexArray);
+    deleteBuffer(mSquareVertexBuffer);
+    deleteBuffer(mSquareIndexBuffer);
+
+    deleteVertexArray(mCubeVertexArray);
+    deleteBuffer(mCubeVertexBuffer);
+    deleteBuffer(mCubeIndexBuffer);
+
+    deleteVertexArray(mAxisVertexArray);
+    deleteBuffer(mAxisVertexBuffer);
+    deleteBuffer(mAxisIndexBuffer);
+
+    deleteVertexArray(mVbVertexArray);
+    deleteBuffer(mVbVertexBuffer);
+    deleteBuffer(mVbIndexBuffer);
+    mVbVertices.clear();
+    mVbIndices.clear();
+}
+
+
+void GLESRenderer::updateVideoBackgroundMesh(const float* vertices, const float* textureCoordinates,
+                                             int numVertices, int numTriangles, const unsigned short* indices)
+{
+    // The mesh only changes when the video background configuration changes,
+    // comparing the few vertices avoids uploading them every frame
+    const size_t positionCount = static_cast<size_t>(numVertices) * 3;
+    const size_t texCoordCount = static_cast<size_t>(numVertices) * 2;
+    const size_t indexCount = static_cast<size_t>(numTriangles) * 3;
+    if (mVbVertices.size() == positionCount + texCoordCount &&
+        mVbIndices.size() == indexCount &&
+        std::equal(vertices, vertices + positionCount, mVbVertices.begin()) &&
+        std::equal(textureCoordinates, textureCoordinates + texCoordCount, mVbVertices.begin() + positionCount) &&
+        std::equal(indices, indices + indexCount, mVbIndices.begin()))
+    {
+        return;
+    }
+
+    mVbVertices.assign(vertices, vertices + positionCount);
+    mVbVertices.insert(mVbVertices.end(), textureCoordinates, textureCoordinates + texCoordCount);
+    mVbIndices.assign(indices, indices + indexCount);
+    const GLvoid* texCoordOffset = (const GLvoid*) (positionCount * sizeof(float));
+
+    mState.bindVertexArray(mVbVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, mVbVertexBuffer);
+    GLESUtils::uploadBuffer(GL_ARRAY_BUFFER, mVbVertices.size() * sizeof(float), mVbVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mVbIndexBuffer);
+    GLESUtils::uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, mVbIndices.size() * sizeof(unsigned short), mVbIndices.data(), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(static_cast<GLuint>(mVbVertexPositionHandle));
+    glVertexAttribPointer(static_cast<GLuint>(mVbVertexPositionHandle), 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(static_cast<GLuint>(mVbTextureCoordHandle));
+    glVertexAttribPointer(static_cast<GLuint>(mVbTextureCoordHandle), 2, GL_FLOAT, GL_FALSE, 0, texCoordOffset);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLESUtils::checkGlError("Update video background mesh");
+}
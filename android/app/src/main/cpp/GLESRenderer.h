@@ -8,36 +8,136 @@ countries.
 #ifndef _VUFORIA_GLESRENDERER_H_
 #define _VUFORIA_GLESRENDERER_H_
 
-#include <android/asset_manager.h>
 #include <GLES3/gl31.h>
 #include <GLES3/gl3ext.h>
 
-#include <tiny_obj_loader.h>
+#include "GLESStateCache.h"
+#include "GLESTextureStreamer.h"
+#include "GLESUniformRing.h"
+#include "RenderQueue.h"
+
+#include <Asset.h>
+#include <MeshCache.h>
 
 #include <Vuforia/Image.h>
 #include <Vuforia/Matrices.h>
 #include <Vuforia/Vectors.h>
 
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
 #include <vector>
 
 
 /// Class to encapsulate OpenGLES rendering for the sample
+/**
+ * The video background is drawn immediately. Augmentations are submitted
+ * to a render queue between beginFrame and endFrame, endFrame sorts the
+ * queue and issues the GL calls.
+ *
+ * The augmentation programs read their matrices and color from uniform
+ * blocks: the projection is uploaded once per frame and the per object data
+ * of all the draws is written to a uniform buffer ring with a single map.
+ *
+ * Models are read and decoded on background threads so init doesn't wait
+ * for them. The GL thread uploads each model at the start of the first
+ * frame after its data is ready, until then the model isn't drawn.
+ *
+ * A model is only loaded when it is prefetched or first drawn. When the
+ * resident models exceed the model memory budget the least recently drawn
+ * ones are unloaded, they are loaded again if they are drawn later.
+ *
+ * Model textures decoded from images, natively or by the app, are streamed
+ * to the GPU through a pixel buffer ring a few rows per frame within the
+ * texture upload budget. The model is drawn with a white texture until it
+ * finishes.
+ */
 class GLESRenderer
 {
 public:
+    /// Models drawn on the targets
+    enum ModelId
+    {
+        MODEL_ASTRONAUT,
+        MODEL_LANDER,
+        MODEL_COUNT
+    };
+
     /// Initialize the renderer ready for use
-    bool init(AAssetManager* assetManager);
+    /*
+    * The models are loaded from assets in the background, the source is
+    * kept until deinit.
+    */
+    bool init(std::shared_ptr<const AssetSource> assets);
     /// Clean up objects created during rendering
     void deinit();
 
+    /// Start rendering a frame
+    /*
+    * Call after Vuforia has prepared to render, any GL state it changed is
+    * forgotten by the state cache.
+    */
+    void beginFrame();
+    /// Finish rendering a frame, drawing all the augmentations submitted since beginFrame
+    /*
+    * Textures are streamed here, after the video background is drawn.
+    */
+    void endFrame();
+
+    /// Enable drawing all the instances of a model with a single instanced draw call
+    /*
+    * Enabled by default, when disabled each instance is a separate draw.
+    */
+    void setInstancingEnabled(bool enabled) { mInstancingEnabled = enabled; }
+    bool isInstancingEnabled() const { return mInstancingEnabled; }
+
+    /// Start loading a model before it is first drawn, e.g. when its dataset is activated
+    /*
+    * A model whose previous load failed is loaded again.
+    */
+    void prefetchModel(ModelId id);
+
+    /// GPU memory for the resident models, in bytes
+    /*
+    * Models which weren't drawn in the last frame are unloaded, least
+    * recently drawn first, while the resident models exceed the budget.
+    */
+    void setModelMemoryBudget(size_t bytes) { mModelMemoryBudget = bytes; }
+    size_t getModelMemoryBudget() const { return mModelMemoryBudget; }
+    /// GPU memory used by the resident models, in bytes
+    size_t getModelMemoryUsage() const;
+
+    /// GL state calls issued and elided since the start of the frame
+    const GLESStateCache::Statistics& getStateStatistics() const { return mState.getStatistics(); }
+
+    /// Set the model textures from decoded images
+    /*
+    * The pixels are copied and streamed in over the next frames. Ignored for
+    * a model whose texture is loaded by init, from a compressed KTX asset or
+    * by decoding its image natively, unless that decode failed.
+    */
     void setAstronautTexture(int width, int height, unsigned char* bytes);
     void setLanderTexture(int width, int height, unsigned char* bytes);
 
+    /// Whether a model texture needs setAstronautTexture or setLanderTexture
+    /*
+    * True after init when a texture can't be loaded from the assets, and
+    * after endFrame when a native decode started by init failed, so check
+    * it again each frame.
+    */
+    bool needsTextures() const { return mAstronautTextureLoad.needsPixels || mLanderTextureLoad.needsPixels; }
+
+    /// Texture bytes uploaded per frame at most, at least one row of a texture is
+    void setTextureUploadBudget(size_t bytes) { mTextureStreamer.setFrameBudget(bytes); }
+    size_t getTextureUploadBudget() const { return mTextureStreamer.getFrameBudget(); }
+
     /// Render the video background
     void renderVideoBackground(Vuforia::Matrix44F& projectionMatrix,
                                const float* vertices, const float* textureCoordinates,
-                               const int numTriangles, const unsigned short* indices,
-                               int textureUnit);
+                               const int numVertices, const int numTriangles,
+                               const unsigned short* indices, int textureUnit);
 
     /// Render augmentation for the world origin
     void renderWorldOrigin(Vuforia::Matrix44F& projectionMatrix,
@@ -58,9 +158,110 @@ public:
                                     Vuforia::Matrix44F& modelViewMatrix,
                                     const Vuforia::Image* Image);
 
+private: // types
+
+    /// Uniform block binding points, see Shaders.h
+    enum UniformBlockBinding : GLuint
+    {
+        CAMERA_DATA_BINDING = 0,
+        OBJECT_DATA_BINDING = 1,
+    };
+
+    /// std140 layout of the CameraData uniform block
+    struct CameraData
+    {
+        Vuforia::Matrix44F projectionMatrix;
+    };
+
+    /// std140 layout of the ObjectData uniform block
+    struct ObjectData
+    {
+        Vuforia::Matrix44F modelViewMatrix;
+        Vuforia::Vec4F color;
+    };
+
+    /// GPU buffers holding an indexed model
+    /*
+    * The vertex arrays capture the attribute setup for the texture color
+    * program and its instanced variant so drawing only needs to bind them.
+    */
+    struct Model
+    {
+        GLuint vertexArray = 0;
+        GLuint instancedVertexArray = 0;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        /// Model view matrix of each instance, streamed every frame
+        GLuint instanceBuffer = 0;
+        GLsizei indexCount = 0;
+        GLenum indexType = GL_UNSIGNED_SHORT;
+        /// Size of the vertex and index buffers
+        size_t memorySize = 0;
+        /// Frame the model was last drawn or prefetched in
+        uint64_t lastUsedFrame = 0;
+
+        /// Instances submitted during the current frame
+        std::vector<Vuforia::Matrix44F> instanceMatrices;
+        GLuint instanceTexture = 0;
+
+        /// Mesh cache data being loaded on a background thread, valid until
+        /// updateModel uploads it
+        std::future<std::unique_ptr<Asset>> pendingMesh;
+        /// The last load failed, it isn't retried until the model is destroyed or prefetched again
+        bool loadFailed = false;
+        const char* name = nullptr;
+        std::chrono::steady_clock::time_point loadStart;
+    };
+
+    /// RGBA8 pixels of a decoded image, bottom row first
+    struct DecodedImage
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    /// A model texture on its way to the GPU, decoded and then streamed
+    struct TextureLoad
+    {
+        /// Image being decoded on a background thread, valid until updateTexture queues it
+        std::future<DecodedImage> pendingImage;
+        /// Upload in progress, 0 when none
+        GLESTextureStreamer::Handle upload = 0;
+        /// Neither loaded nor being loaded, the app has to set the pixels
+        bool needsPixels = true;
+        std::string name;
+        std::chrono::steady_clock::time_point loadStart;
+    };
+
 private: // methods
-    /// Attempt to create a texture from bytes
-    void createTexture(int width, int height, unsigned char* bytes, int& textureId);
+    /// Queue decoded pixels for streaming, replacing any upload in progress
+    void streamTexture(std::vector<uint8_t> pixels, uint32_t width, uint32_t height, TextureLoad& load);
+
+    /// Create a texture from a compressed KTX asset, name.astc.ktx or name.etc2.ktx
+    /*
+    * ASTC is preferred when the device supports it, returns false when no
+    * usable asset exists.
+    */
+    bool loadCompressedTexture(const char* name, int& textureId);
+
+    /// Start decoding a JPEG or PNG asset on a background thread, see ImageDecoder
+    /*
+    * Returns false when the asset is missing or its header can't be read.
+    */
+    bool loadImageTexture(const char* filename, TextureLoad& load);
+
+    /// Load a model texture, compressed if possible and otherwise from name.jpg
+    bool loadModelTexture(const char* name, int& textureId, TextureLoad& load);
+
+    /// Queue a decoded image and take the texture of a finished upload, never waits
+    void updateTexture(TextureLoad& load, int& textureId);
+
+    /// Decode an image asset, runs on a background thread
+    /*
+    * Returns no pixels if the image can't be decoded.
+    */
+    static DecodedImage decodeImage(std::unique_ptr<Asset> asset);
 
     /// Render a filled 3D cube
     /*
@@ -86,22 +287,92 @@ private: // methods
                     float lineWidth = 2.0f);
 
     /// Render a v3d model
-    void renderModel(Vuforia::Matrix44F modelViewProjectionMatrix,
-                     const int numVertices, const float* vertices, const float* textureCoordinates,
-                     GLint textureId);
+    /*
+    * When instancing is enabled the model is drawn with its other instances
+    * by submitModelInstances at the end of the frame.
+    */
+    void renderModel(const Vuforia::Matrix44F& modelViewMatrix,
+                     Model& model, GLint textureId);
+
+    /// Upload the instances of a model rendered during the frame and submit one instanced draw
+    void submitModelInstances(Model& model);
 
-    /// Read an asset file into a byte vector
-    bool readAsset(AAssetManager* assetManager, const char* filename, std::vector<char>& data);
+    /// Mark a model as used in this frame and start loading it if it isn't loaded
+    /*
+    * Returns the model, which has no buffers until its load completes.
+    */
+    Model& useModel(ModelId id);
+
+    /// Unload least recently used models until the resident models fit the budget
+    void evictModels();
+
+    /// Start loading a model on a background thread
+    /*
+    * The model is uploaded to GPU buffers by updateModel once the data is
+    * ready, it isn't drawn until then.
+    */
+    void loadModel(const char* meshFilename, const char* objFilename, Model& model);
+
+    /// Upload a model if its background load has finished, never waits for the load
+    void updateModel(Model& model);
+
+    /// Read a model as mesh cache data, runs on a background thread
+    /*
+    * The binary mesh cache file is used when it is present in the assets,
+    * otherwise the OBJ file is parsed. Returns nullptr if neither can be read.
+    */
+    static std::unique_ptr<Asset> readModel(const AssetSource& assets, const char* meshFilename,
+                                            const char* objFilename);
 
     /// Load a model from an OBJ file
     /*
-    * The model is input as the data array, the vertex and texture coordinate
-    * vectors are populated by this method as it reads the input.
+    * The model is parsed in place from data, meshData is populated with the
+    * model in the mesh cache format as it reads the input.
+    * When optimize is true the triangles and vertices are reordered for
+    * the vertex cache and to reduce overdraw before the mesh is written.
     */
-    bool loadObjModel(const std::vector<char>& data, int& numVertices, std::vector<float>& vertices, std::vector<float>& texCoords);
+    static bool loadObjModel(const char* data, size_t size, std::vector<char>& meshData, bool optimize = true);
+
+    /// Upload a mesh cache held in memory to GPU buffers
+    bool uploadModel(const void* meshData, size_t size, Model& model);
+
+    /// Delete the GPU buffers of a model, waiting for a load in progress
+    /*
+    * The model's last use is kept.
+    */
+    void destroyModel(Model& model);
+
+    /// Sort the render queue, upload its uniform data, issue its draw calls and clear it
+    void drawQueue();
+
+    /// Bind a program's uniform block to a binding point, programs not using the block are skipped
+    void setUniformBlockBinding(GLuint program, const char* blockName, GLuint binding);
+
+    /// Upload the static meshes from Models.h and create a vertex array for each mesh and program pair
+    void createStaticGeometry();
+
+    /// Delete the buffers and vertex arrays created by createStaticGeometry
+    void destroyStaticGeometry();
+
+    /// Upload the video background mesh if it differs from the one last uploaded
+    void updateVideoBackgroundMesh(const float* vertices, const float* textureCoordinates,
+                                   int numVertices, int numTriangles, const unsigned short* indices);
 
 private: // data members
 
+    /// Enable this flag to log the state cache statistics every frame
+    static const bool DEBUG_STATE = false;
+
+    /// Shadow of the GL state, all render state changes go through it
+    GLESStateCache mState;
+
+    /// Augmentations submitted during the frame
+    RenderQueue mRenderQueue;
+
+    /// Uniform block data of the queued draws, the camera data followed by the object data of each item
+    GLESUniformRing mUniformRing;
+    std::vector<unsigned char> mUniformData;
+
     // For video background rendering
     unsigned int mVbShaderProgramID     = 0;
     GLint mVbVertexPositionHandle       = 0;
@@ -109,36 +380,66 @@ private: // data members
     GLint mVbMvpMatrixHandle            = 0;
     GLint mVbTexSampler2DHandle         = 0;
 
+    // Video background mesh, only uploaded again when Vuforia changes it
+    GLuint mVbVertexArray               = 0;
+    GLuint mVbVertexBuffer              = 0;
+    GLuint mVbIndexBuffer               = 0;
+    std::vector<float> mVbVertices;
+    std::vector<unsigned short> mVbIndices;
+
     // For augmentation rendering
     unsigned int mUniformColorShaderProgramID   = 0;
     GLint mUniformColorVertexPositionHandle     = 0;
-    GLint mUniformColorMvpMatrixHandle          = 0;
-    GLint mUniformColorColorHandle              = 0;
 
     // For model target guide view rendering
     unsigned int mTextureUniformColorShaderProgramID    = 0;
     GLint mTextureUniformColorVertexPositionHandle      = 0;
     GLint mTextureUniformColorTextureCoordHandle        = 0;
-    GLint mTextureUniformColorMvpMatrixHandle           = 0;
     GLint mTextureUniformColorTexSampler2DHandle        = 0;
-    GLint mTextureUniformColorColorHandle               = 0;
     int mModelTargetGuideViewTextureUnit = -1;
 
+    // For instanced model rendering
+    unsigned int mTextureColorInstancedShaderProgramID          = 0;
+    GLint mTextureColorInstancedVertexPositionHandle            = 0;
+    GLint mTextureColorInstancedTextureCoordHandle              = 0;
+    GLint mTextureColorInstancedModelViewMatrixHandle           = 0;
+    GLint mTextureColorInstancedTexSampler2DHandle              = 0;
+    bool mInstancingEnabled = true;
+
     // For axis rendering
     unsigned int mVertexColorShaderProgramID    = 0;
     GLint mVertexColorVertexPositionHandle      = 0;
     GLint mVertexColorColorHandle               = 0;
-    GLint mVertexColorMvpMatrixHandle           = 0;
 
-    int mAstronautVertexCount;
-    std::vector<float> mAstronautVertices;
-    std::vector<float> mAstronautTexCoords;
-    int mAstronautTextureUnit = -1;
+    // Static geometry, the square is drawn both with the uniform color
+    // program (image target) and the texture color program (guide view)
+    GLuint mSquareVertexBuffer      = 0;
+    GLuint mSquareIndexBuffer       = 0;
+    GLuint mSquareVertexArray       = 0;
+    GLuint mGuideViewVertexArray    = 0;
+    GLuint mCubeVertexBuffer        = 0;
+    GLuint mCubeIndexBuffer         = 0;
+    GLuint mCubeVertexArray         = 0;
+    GLuint mAxisVertexBuffer        = 0;
+    GLuint mAxisIndexBuffer         = 0;
+    GLuint mAxisVertexArray         = 0;
+
+    /// Models are loaded from these assets when they are needed
+    std::shared_ptr<const AssetSource> mAssets;
+    Model mModels[MODEL_COUNT];
+    size_t mModelMemoryBudget = 32 * 1024 * 1024;
+    /// Number of frames started, for the model use times
+    uint64_t mFrameIndex = 0;
 
-    int mLanderVertexCount;
-    std::vector<float> mLanderVertices;
-    std::vector<float> mLanderTexCoords;
+    /// Decoded texture pixels are uploaded through it over several frames
+    GLESTextureStreamer mTextureStreamer;
+
+    /// 1x1 white texture drawn on models whose texture isn't ready
+    int mWhiteTextureUnit = -1;
+    int mAstronautTextureUnit = -1;
     int mLanderTextureUnit = -1;
+    TextureLoad mAstronautTextureLoad;
+    TextureLoad mLanderTextureLoad;
 };
 
 #endif //_VUFORIA_GLESRENDERER_H_
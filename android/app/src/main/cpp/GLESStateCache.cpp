@@ -0,0 +1,183 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "GLESStateCache.h"
+
+
+template<typename T>
+bool
+GLESStateCache::update(Tracked<T>& state, T value)
+{
+    if (state.valid && state.value == value)
+    {
+        mStatistics.elided++;
+        return false;
+    }
+
+    state.value = value;
+    state.valid = true;
+    mStatistics.issued++;
+    return true;
+}
+
+
+void
+GLESStateCache::invalidate()
+{
+    for (auto& capability : mCapabilities)
+    {
+        capability.valid = false;
+    }
+    mProgram.valid = false;
+    mVertexArray.valid = false;
+    mActiveTexture.valid = false;
+    for (auto& texture : mTextures)
+    {
+        texture.valid = false;
+    }
+    mBlendFunc.valid = false;
+    mCullFace.valid = false;
+    mFrontFace.valid = false;
+    mLineWidth.valid = false;
+}
+
+
+void
+GLESStateCache::resetStatistics()
+{
+    mStatistics = Statistics();
+}
+
+
+void
+GLESStateCache::setEnabled(GLenum capability, bool enabled)
+{
+    Tracked<bool>* state = nullptr;
+    switch (capability)
+    {
+        case GL_DEPTH_TEST:
+            state = &mCapabilities[CAPABILITY_DEPTH_TEST];
+            break;
+        case GL_BLEND:
+            state = &mCapabilities[CAPABILITY_BLEND];
+            break;
+        case GL_CULL_FACE:
+            state = &mCapabilities[CAPABILITY_CULL_FACE];
+            break;
+        default:
+            break;
+    }
+
+    if (state == nullptr)
+    {
+        mStatistics.issued++;
+    }
+    else if (!update(*state, enabled))
+    {
+        return;
+    }
+
+    if (enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+}
+
+
+void
+GLESStateCache::useProgram(GLuint program)
+{
+    if (update(mProgram, program))
+    {
+        glUseProgram(program);
+    }
+}
+
+
+void
+GLESStateCache::bindVertexArray(GLuint vertexArray)
+{
+    if (update(mVertexArray, vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+    }
+}
+
+
+void
+GLESStateCache::activeTexture(GLenum unit)
+{
+    if (update(mActiveTexture, unit))
+    {
+        glActiveTexture(unit);
+    }
+}
+
+
+void
+GLESStateCache::bindTexture2D(GLuint texture)
+{
+    int unit = static_cast<int>(mActiveTexture.value) - GL_TEXTURE0;
+    if (!mActiveTexture.valid || unit < 0 || unit >= MAX_TEXTURE_UNITS)
+    {
+        // The binding can't be tracked without knowing the active unit
+        mStatistics.issued++;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        return;
+    }
+
+    if (update(mTextures[unit], texture))
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+}
+
+
+void
+GLESStateCache::blendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+    // Both factors are tracked as one value so the call is counted once
+    uint64_t factors = (static_cast<uint64_t>(sourceFactor) << 32) | destinationFactor;
+    if (update(mBlendFunc, factors))
+    {
+        glBlendFunc(sourceFactor, destinationFactor);
+    }
+}
+
+
+void
+GLESStateCache::cullFace(GLenum mode)
+{
+    if (update(mCullFace, mode))
+    {
+        glCullFace(mode);
+    }
+}
+
+
+void
+GLESStateCache::frontFace(GLenum mode)
+{
+    if (update(mFrontFace, mode))
+    {
+        glFrontFace(mode);
+    }
+}
+
+
+void
+GLESStateCache::lineWidth(GLfloat width)
+{
+    if (update(mLineWidth, width))
+    {
+        glLineWidth(width);
+    }
+}
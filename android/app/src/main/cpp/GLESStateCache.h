@@ -0,0 +1,105 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_GLESSTATECACHE_H_
+#define _VUFORIA_GLESSTATECACHE_H_
+
+#include <GLES3/gl31.h>
+
+#include <cstdint>
+
+
+/// Shadow copy of the OpenGL ES state used by the renderer
+/**
+ * Each setter compares the requested value with the value last set and only
+ * calls into GL when it differs, so render functions can set all the state
+ * they need without paying for redundant calls or querying GL with glGet*.
+ *
+ * State changed without going through the cache (e.g. by Vuforia while
+ * preparing to render) is unknown to it, call invalidate() afterwards.
+ */
+class GLESStateCache
+{
+public:
+    /// Number of state calls sent to GL and skipped because they were redundant
+    struct Statistics
+    {
+        uint32_t issued = 0;
+        uint32_t elided = 0;
+    };
+
+    /// Forget all tracked state, the next call for each state is always issued
+    void invalidate();
+
+    /// Reset the statistics, call at the start of each frame
+    void resetStatistics();
+
+    /// Statistics since the last call to resetStatistics
+    const Statistics& getStatistics() const { return mStatistics; }
+
+    /// glEnable/glDisable
+    void setEnabled(GLenum capability, bool enabled);
+    void enable(GLenum capability) { setEnabled(capability, true); }
+    void disable(GLenum capability) { setEnabled(capability, false); }
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+
+    /// glActiveTexture, unit is GL_TEXTURE0 + i
+    void activeTexture(GLenum unit);
+    /// glBindTexture(GL_TEXTURE_2D) on the active texture unit
+    void bindTexture2D(GLuint texture);
+
+    void blendFunc(GLenum sourceFactor, GLenum destinationFactor);
+    void cullFace(GLenum mode);
+    void frontFace(GLenum mode);
+    void lineWidth(GLfloat width);
+
+private: // types
+
+    /// Capabilities tracked by setEnabled, others are passed through
+    enum Capability
+    {
+        CAPABILITY_DEPTH_TEST,
+        CAPABILITY_BLEND,
+        CAPABILITY_CULL_FACE,
+        CAPABILITY_COUNT
+    };
+
+    /// A value and whether it is known to match the GL state
+    template<typename T>
+    struct Tracked
+    {
+        T value {};
+        bool valid = false;
+    };
+
+    /// Number of texture units whose 2D binding is tracked
+    static constexpr int MAX_TEXTURE_UNITS = 8;
+
+private: // methods
+
+    /// Record the new value, returns true if GL must be called
+    template<typename T>
+    bool update(Tracked<T>& state, T value);
+
+private: // data members
+
+    Tracked<bool> mCapabilities[CAPABILITY_COUNT];
+    Tracked<GLuint> mProgram;
+    Tracked<GLuint> mVertexArray;
+    Tracked<GLenum> mActiveTexture;
+    Tracked<GLuint> mTextures[MAX_TEXTURE_UNITS];
+    Tracked<uint64_t> mBlendFunc;
+    Tracked<GLenum> mCullFace;
+    Tracked<GLenum> mFrontFace;
+    Tracked<GLfloat> mLineWidth;
+
+    Statistics mStatistics;
+};
+
+#endif // _VUFORIA_GLESSTATECACHE_H_
@@ -0,0 +1,294 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "GLESTextureStreamer.h"
+
+#include "GLESUtils.h"
+
+#include <Log.h>
+#include <MipmapGenerator.h>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+    /// Bytes per texel of the streamed textures
+    constexpr size_t PIXEL_SIZE = 4;
+}
+
+
+bool
+GLESTextureStreamer::init(GLsizeiptr segmentSize)
+{
+    deinit();
+
+    mSegmentSize = segmentSize;
+    mBuffer = GLESUtils::createBuffer(GL_PIXEL_UNPACK_BUFFER, mSegmentSize * SEGMENT_COUNT, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (mBuffer == 0)
+    {
+        LOG("Failed to create the texture streaming buffer");
+        mSegmentSize = 0;
+        return false;
+    }
+    return true;
+}
+
+
+void
+GLESTextureStreamer::deinit()
+{
+    for (Upload& upload : mUploads)
+    {
+        release(upload);
+    }
+    mUploads.clear();
+
+    for (GLsync& fence : mFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (mBuffer != 0)
+    {
+        GLESUtils::destroyBuffer(mBuffer);
+        mBuffer = 0;
+    }
+    mSegmentSize = 0;
+    mSegment = 0;
+}
+
+
+GLESTextureStreamer::Handle
+GLESTextureStreamer::queue(std::vector<uint8_t> pixels, uint32_t width, uint32_t height, bool mipmaps)
+{
+    const size_t rowSize = size_t(width) * PIXEL_SIZE;
+    if (width == 0 || height == 0 || pixels.size() < rowSize * height)
+    {
+        LOG("Error: Cannot stream a %ux%u texture from %zu bytes", width, height, pixels.size());
+        return 0;
+    }
+    if (rowSize > static_cast<size_t>(mSegmentSize))
+    {
+        LOG("Error: A row of a %ux%u texture doesn't fit a %zu byte streaming segment",
+            width, height, static_cast<size_t>(mSegmentSize));
+        return 0;
+    }
+
+    Upload upload;
+    upload.handle = mNextHandle++;
+    if (mNextHandle == 0)
+    {
+        mNextHandle = 1;
+    }
+    upload.width = width;
+    upload.height = height;
+    upload.mipmaps = mipmaps;
+    upload.pixels = std::move(pixels);
+
+    // Immutable storage for the whole chain, the rows are filled in by update
+    const GLsizei levelCount = mipmaps ? static_cast<GLsizei>(MipmapGenerator::getLevelCount(width, height)) : 1;
+    glGenTextures(1, &upload.texture);
+    glBindTexture(GL_TEXTURE_2D, upload.texture);
+    glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_RGBA8, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLESUtils::checkGlError("Creating streamed texture");
+
+    mUploads.push_back(std::move(upload));
+    return mUploads.back().handle;
+}
+
+
+void
+GLESTextureStreamer::cancel(Handle handle)
+{
+    auto it = std::find_if(mUploads.begin(), mUploads.end(),
+                           [handle](const Upload& upload) { return upload.handle == handle; });
+    if (it != mUploads.end())
+    {
+        // Rows already uploaded may still be read from their segment, its
+        // fence keeps the segment from being reused until they are
+        release(*it);
+        mUploads.erase(it);
+    }
+}
+
+
+GLuint
+GLESTextureStreamer::takeTexture(Handle handle)
+{
+    auto it = std::find_if(mUploads.begin(), mUploads.end(),
+                           [handle](const Upload& upload) { return upload.handle == handle; });
+    if (it == mUploads.end() || it->readyFence == nullptr)
+    {
+        return 0;
+    }
+
+    GLenum result = glClientWaitSync(it->readyFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        return 0;
+    }
+    if (result == GL_WAIT_FAILED)
+    {
+        LOG("Waiting for a streamed texture fence failed");
+    }
+
+    glDeleteSync(it->readyFence);
+    GLuint texture = it->texture;
+    mUploads.erase(it);
+    return texture;
+}
+
+
+void
+GLESTextureStreamer::update()
+{
+    auto it = std::find_if(mUploads.begin(), mUploads.end(),
+                           [](const Upload& upload) { return upload.readyFence == nullptr; });
+    if (it == mUploads.end() || mBuffer == 0)
+    {
+        return;
+    }
+
+    // Always allow a row so an upload completes however small the budget
+    size_t budget = std::max(mFrameBudget, size_t(it->width) * PIXEL_SIZE);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+    for (; it != mUploads.end(); ++it)
+    {
+        Upload& upload = *it;
+        if (upload.readyFence != nullptr)
+        {
+            continue;
+        }
+
+        while (upload.nextRow < upload.height && uploadRows(upload, budget))
+        {
+        }
+        if (upload.nextRow < upload.height)
+        {
+            // Out of budget or waiting for a segment, resume next frame
+            break;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, upload.texture);
+        GLint levelCount = 1;
+        if (upload.mipmaps)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            levelCount = static_cast<GLint>(MipmapGenerator::getLevelCount(upload.width, upload.height));
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        GLESUtils::setMinificationFilter(levelCount);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        upload.readyFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        std::vector<uint8_t>().swap(upload.pixels);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    GLESUtils::checkGlError("Streaming textures");
+}
+
+
+size_t
+GLESTextureStreamer::getPendingBytes() const
+{
+    size_t bytes = 0;
+    for (const Upload& upload : mUploads)
+    {
+        bytes += size_t(upload.height - upload.nextRow) * upload.width * PIXEL_SIZE;
+    }
+    return bytes;
+}
+
+
+bool
+GLESTextureStreamer::uploadRows(Upload& upload, size_t& budget)
+{
+    const size_t rowSize = size_t(upload.width) * PIXEL_SIZE;
+    const uint32_t rowCount = static_cast<uint32_t>(std::min({ size_t(upload.height - upload.nextRow),
+                                                               static_cast<size_t>(mSegmentSize) / rowSize,
+                                                               budget / rowSize }));
+    if (rowCount == 0)
+    {
+        return false;
+    }
+
+    // Never wait for the GPU, a busy segment ends the frame's uploads
+    GLsync& fence = mFences[mSegment];
+    if (fence != nullptr)
+    {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            return false;
+        }
+        if (result == GL_WAIT_FAILED)
+        {
+            LOG("Waiting for the texture streaming fence failed");
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const GLintptr offset = mSegment * mSegmentSize;
+    const size_t size = rowSize * rowCount;
+
+    void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, static_cast<GLsizeiptr>(size),
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (destination == nullptr)
+    {
+        LOG("Failed to map the texture streaming buffer");
+        return false;
+    }
+    memcpy(destination, upload.pixels.data() + size_t(upload.nextRow) * rowSize, size);
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+    {
+        // The contents were lost, the rows are uploaded again next frame
+        LOG("The texture streaming buffer was corrupted while mapped");
+        return false;
+    }
+
+    // With a buffer bound the data pointer is an offset into it
+    glBindTexture(GL_TEXTURE_2D, upload.texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<GLint>(upload.nextRow), upload.width, rowCount,
+                    GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(offset));
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mSegment = (mSegment + 1) % SEGMENT_COUNT;
+    upload.nextRow += rowCount;
+    budget -= size;
+    return true;
+}
+
+
+void
+GLESTextureStreamer::release(Upload& upload)
+{
+    if (upload.readyFence != nullptr)
+    {
+        glDeleteSync(upload.readyFence);
+        upload.readyFence = nullptr;
+    }
+    if (upload.texture != 0)
+    {
+        glDeleteTextures(1, &upload.texture);
+        upload.texture = 0;
+    }
+}
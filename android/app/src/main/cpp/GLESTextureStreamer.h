@@ -0,0 +1,101 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_GLESTEXTURESTREAMER_H_
+#define _VUFORIA_GLESTEXTURESTREAMER_H_
+
+#include <GLES3/gl31.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/// Uploads RGBA8 textures a few rows at a time across frames
+/**
+ * Queued images are copied into a pixel unpack buffer split into segments
+ * used in turn, and uploaded from it with glTexSubImage2D. A fence placed
+ * after each upload protects its segment, a segment the GPU hasn't
+ * finished with ends the frame's uploads rather than waiting, so update
+ * never blocks the render thread. At most the frame budget is uploaded by
+ * each update, at least one row so every upload progresses.
+ *
+ * Once all rows are uploaded the mip chain is generated and a last fence
+ * marks the texture ready, takeTexture then hands it over.
+ */
+class GLESTextureStreamer
+{
+public:
+    /// Identifies a queued upload, 0 is never used
+    using Handle = uint32_t;
+
+    /// Number of segments in the pixel buffer
+    static const int SEGMENT_COUNT = 8;
+
+    /// Create the pixel buffer, with segments of segmentSize bytes
+    bool init(GLsizeiptr segmentSize);
+    /// Delete the buffer, fences and the textures of unfinished uploads
+    void deinit();
+
+    /// Bytes uploaded per update at most, trading load speed against frame time
+    void setFrameBudget(size_t bytes) { mFrameBudget = bytes; }
+    size_t getFrameBudget() const { return mFrameBudget; }
+
+    /// Queue an image to upload to a new texture, rows bottom first
+    Handle queue(std::vector<uint8_t> pixels, uint32_t width, uint32_t height, bool mipmaps);
+
+    /// Stop an upload and delete its texture
+    void cancel(Handle handle);
+
+    /// The texture of a finished upload, 0 while it is in progress
+    /*
+    * The caller owns the texture returned and the handle is no longer valid.
+    */
+    GLuint takeTexture(Handle handle);
+
+    /// Upload the next rows within the frame budget, call once per frame
+    void update();
+
+    /// Bytes queued which haven't been uploaded yet
+    size_t getPendingBytes() const;
+
+private: // methods
+
+    struct Upload
+    {
+        Handle handle = 0;
+        GLuint texture = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool mipmaps = false;
+        /// Rows not uploaded yet are released once the last one is
+        std::vector<uint8_t> pixels;
+        uint32_t nextRow = 0;
+        /// Set after the last row, the texture is ready when it is signaled
+        GLsync readyFence = nullptr;
+    };
+
+    /// Copy rows of an upload to the next segment and upload them, taking their size from budget
+    /// Returns false when the budget doesn't cover a row or the segment is still in use.
+    bool uploadRows(Upload& upload, size_t& budget);
+
+    /// Delete the GL objects of an upload
+    static void release(Upload& upload);
+
+private: // data members
+
+    GLuint mBuffer = 0;
+    GLsizeiptr mSegmentSize = 0;
+    int mSegment = 0;
+    GLsync mFences[SEGMENT_COUNT] = {};
+    size_t mFrameBudget = 1024 * 1024;
+    Handle mNextHandle = 1;
+    /// In queue order, rows are uploaded for the first unfinished one
+    std::vector<Upload> mUploads;
+};
+
+#endif // _VUFORIA_GLESTEXTURESTREAMER_H_
@@ -0,0 +1,152 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "GLESUniformRing.h"
+
+#include "GLESUtils.h"
+
+#include <Log.h>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+    /// Time to wait for a fence before checking again, in nanoseconds
+    constexpr GLuint64 FENCE_TIMEOUT = 100000000;
+}
+
+
+bool
+GLESUniformRing::init(GLsizeiptr segmentSize)
+{
+    // The alignment is fixed for the context, query it once rather than per frame
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &mOffsetAlignment);
+    mOffsetAlignment = std::max(mOffsetAlignment, 1);
+    mSegment = 0;
+
+    return allocate(segmentSize);
+}
+
+
+void
+GLESUniformRing::deinit()
+{
+    deleteFences();
+    if (mBuffer != 0)
+    {
+        GLESUtils::destroyBuffer(mBuffer);
+        mBuffer = 0;
+    }
+    mSegmentSize = 0;
+}
+
+
+GLsizeiptr
+GLESUniformRing::align(GLsizeiptr size) const
+{
+    return (size + mOffsetAlignment - 1) / mOffsetAlignment * mOffsetAlignment;
+}
+
+
+GLintptr
+GLESUniformRing::upload(const void* data, GLsizeiptr size)
+{
+    if (size > mSegmentSize && !allocate(std::max(size, mSegmentSize * 2)))
+    {
+        return -1;
+    }
+
+    mSegment = (mSegment + 1) % FRAME_COUNT;
+
+    // Wait until the GPU has finished the frame which last used the segment
+    GLsync& fence = mFences[mSegment];
+    if (fence != nullptr)
+    {
+        GLenum result;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        if (result == GL_WAIT_FAILED)
+        {
+            LOG("Waiting for the uniform buffer fence failed");
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    GLintptr offset = mSegment * mSegmentSize;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    void* destination = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (destination == nullptr)
+    {
+        LOG("Failed to map the uniform buffer");
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        return -1;
+    }
+    memcpy(destination, data, size);
+    bool unmapped = glUnmapBuffer(GL_UNIFORM_BUFFER) == GL_TRUE;
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (!unmapped)
+    {
+        // The contents were lost, e.g. to a display mode change
+        LOG("The uniform buffer was corrupted while mapped");
+        return -1;
+    }
+
+    return offset;
+}
+
+
+void
+GLESUniformRing::endFrame()
+{
+    GLsync& fence = mFences[mSegment];
+    if (fence == nullptr)
+    {
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+
+bool
+GLESUniformRing::allocate(GLsizeiptr segmentSize)
+{
+    // Orphaning the old buffer leaves any pending draws using it unaffected
+    deinit();
+
+    mSegmentSize = align(segmentSize);
+    mBuffer = GLESUtils::createBuffer(GL_UNIFORM_BUFFER, mSegmentSize * FRAME_COUNT, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (mBuffer == 0)
+    {
+        LOG("Failed to create the uniform buffer");
+        mSegmentSize = 0;
+        return false;
+    }
+    return true;
+}
+
+
+void
+GLESUniformRing::deleteFences()
+{
+    for (GLsync& fence : mFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
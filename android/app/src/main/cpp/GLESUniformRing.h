@@ -0,0 +1,65 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_GLESUNIFORMRING_H_
+#define _VUFORIA_GLESUNIFORMRING_H_
+
+#include <GLES3/gl31.h>
+
+
+/// Uniform buffer split into per frame segments used in turn
+/**
+ * Each frame the uniform data of all its draws is copied into the next
+ * segment with a single unsynchronized map, the draws then bind ranges of
+ * that segment. A fence placed at the end of the frame protects the segment
+ * until the GPU has finished with it, so writing never waits for the draws
+ * of the previous frames unless the GPU is FRAME_COUNT frames behind.
+ */
+class GLESUniformRing
+{
+public:
+    /// Number of frames which can be in flight
+    static const int FRAME_COUNT = 3;
+
+    /// Create the buffer, segmentSize is the initial size of a frame's data
+    bool init(GLsizeiptr segmentSize);
+    /// Delete the buffer and fences
+    void deinit();
+
+    GLuint getBuffer() const { return mBuffer; }
+
+    /// Round a size up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    GLsizeiptr align(GLsizeiptr size) const;
+
+    /// Copy the uniform data of a frame into the next segment
+    /*
+    * The buffer grows when the data doesn't fit in a segment.
+    * Returns the offset of the data in the buffer, or -1 on failure.
+    */
+    GLintptr upload(const void* data, GLsizeiptr size);
+
+    /// Fence the segment last uploaded, call after issuing the draws using it
+    void endFrame();
+
+private: // methods
+
+    /// (Re)create the buffer with segments of at least segmentSize bytes
+    bool allocate(GLsizeiptr segmentSize);
+
+    /// Delete all pending fences
+    void deleteFences();
+
+private: // data members
+
+    GLuint mBuffer = 0;
+    GLsizeiptr mSegmentSize = 0;
+    GLint mOffsetAlignment = 1;
+    int mSegment = 0;
+    GLsync mFences[FRAME_COUNT] = {};
+};
+
+#endif // _VUFORIA_GLESUNIFORMRING_H_
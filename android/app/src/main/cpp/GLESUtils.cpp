@@ -7,11 +7,66 @@ countries.
 
 #include "GLESUtils.h"
 
+#include <MipmapGenerator.h>
+
 #include <stdlib.h>
 
+#include <GLES2/gl2ext.h>
 #include <GLES3/gl31.h>
 #include <GLES3/gl3ext.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+
+GLESUtils::BufferUploadStatistics GLESUtils::sBufferUploadStatistics;
+GLESUtils::ProgramCacheStatistics GLESUtils::sProgramCacheStatistics;
+std::string GLESUtils::sProgramCacheDirectory;
+float GLESUtils::sMaxTextureAnisotropy = 0.0f;
+
+
+namespace
+{
+    /// Header of a program binary cache file, followed by the binary
+    struct ProgramBinaryHeader
+    {
+        static constexpr uint32_t MAGIC = 0x42475250; // "PRGB"
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint64_t key = 0;
+        uint32_t binaryFormat = 0;
+        uint32_t binarySize = 0;
+    };
+
+    /// 64-bit FNV-1a hash of a string, continuing from hash
+    uint64_t hashString(const char* string, uint64_t hash)
+    {
+        if (string != nullptr)
+        {
+            for (const char* c = string; *c != '\0'; ++c)
+            {
+                hash ^= static_cast<unsigned char>(*c);
+                hash *= 0x100000001b3ULL;
+            }
+        }
+        // Separate consecutive strings so "ab" + "c" differs from "a" + "bc"
+        hash ^= 0xff;
+        hash *= 0x100000001b3ULL;
+        return hash;
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
 
 void
 GLESUtils::checkGlError(const char* operation)
@@ -63,6 +118,70 @@ GLESUtils::initShader(unsigned int shaderType, const char* source)
 unsigned int
 GLESUtils::createProgramFromBuffer(const char* vertexShaderBuffer,
                                      const char* fragmentShaderBuffer)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Binaries are only usable if the driver supports at least one format
+    GLint binaryFormatCount = 0;
+    if (!sProgramCacheDirectory.empty())
+    {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+    }
+
+    if (binaryFormatCount == 0)
+    {
+        GLuint program = compileProgram(vertexShaderBuffer, fragmentShaderBuffer, false);
+        sProgramCacheStatistics.compiledCount++;
+        sProgramCacheStatistics.compiledMs += millisecondsSince(start);
+        return program;
+    }
+
+    uint64_t key = getProgramCacheKey(vertexShaderBuffer, fragmentShaderBuffer);
+    char filename[32];
+    snprintf(filename, sizeof(filename), "/program_%016" PRIx64 ".bin", key);
+    std::string path = sProgramCacheDirectory + filename;
+
+    GLuint program = loadProgramBinary(path, key);
+    if (program != 0)
+    {
+        double ms = millisecondsSince(start);
+        sProgramCacheStatistics.cachedCount++;
+        sProgramCacheStatistics.cachedMs += ms;
+        LOG("Program %016" PRIx64 " loaded from the cache in %.2f ms", key, ms);
+        return program;
+    }
+
+    program = compileProgram(vertexShaderBuffer, fragmentShaderBuffer, true);
+    if (program != 0)
+    {
+        saveProgramBinary(path, key, program);
+    }
+
+    double ms = millisecondsSince(start);
+    sProgramCacheStatistics.compiledCount++;
+    sProgramCacheStatistics.compiledMs += ms;
+    LOG("Program %016" PRIx64 " compiled in %.2f ms", key, ms);
+    return program;
+}
+
+
+void
+GLESUtils::setProgramCacheDirectory(const std::string& directory)
+{
+    sProgramCacheDirectory = directory;
+}
+
+
+const GLESUtils::ProgramCacheStatistics&
+GLESUtils::getProgramCacheStatistics()
+{
+    return sProgramCacheStatistics;
+}
+
+
+unsigned int
+GLESUtils::compileProgram(const char* vertexShaderBuffer,
+                          const char* fragmentShaderBuffer, bool retrievable)
 {
     GLuint vertexShader = initShader(GL_VERTEX_SHADER, vertexShaderBuffer);
     if (!vertexShader)
@@ -81,7 +200,12 @@ GLESUtils::createProgramFromBuffer(const char* vertexShaderBuffer,
         
         glAttachShader(program, fragmentShader);
         checkGlError("glAttachShader");
-        
+
+        if (retrievable)
+        {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
         glLinkProgram(program);
         GLint linkStatus = GL_FALSE;
         glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
@@ -108,6 +232,111 @@ GLESUtils::createProgramFromBuffer(const char* vertexShaderBuffer,
 }
 
 
+uint64_t
+GLESUtils::getProgramCacheKey(const char* vertexShaderBuffer,
+                              const char* fragmentShaderBuffer)
+{
+    // A driver update can change the binary format, so the driver is part of the key
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hashString(vertexShaderBuffer, hash);
+    hash = hashString(fragmentShaderBuffer, hash);
+    hash = hashString(reinterpret_cast<const char*>(glGetString(GL_VENDOR)), hash);
+    hash = hashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), hash);
+    hash = hashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), hash);
+    return hash;
+}
+
+
+unsigned int
+GLESUtils::loadProgramBinary(const std::string& path, uint64_t key)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return 0;
+    }
+
+    ProgramBinaryHeader header;
+    std::vector<char> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 header.magic == ProgramBinaryHeader::MAGIC &&
+                 header.version == ProgramBinaryHeader::VERSION &&
+                 header.key == key && header.binarySize > 0;
+    if (valid)
+    {
+        binary.resize(header.binarySize);
+        valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+
+    GLuint program = 0;
+    if (valid)
+    {
+        program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if (linkStatus != GL_TRUE)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (program == 0)
+    {
+        // Stale or corrupt, e.g. written by a previous driver, it is replaced after compiling
+        LOG("Discarding cached program %s", path.c_str());
+        remove(path.c_str());
+    }
+    return program;
+}
+
+
+void
+GLESUtils::saveProgramBinary(const std::string& path, uint64_t key, unsigned int program)
+{
+    GLint binaryLength = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0)
+    {
+        return;
+    }
+
+    ProgramBinaryHeader header;
+    header.key = key;
+    std::vector<char> binary(static_cast<size_t>(binaryLength));
+    GLsizei length = 0;
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, binaryLength, &length, &binaryFormat, binary.data());
+    if (length <= 0)
+    {
+        return;
+    }
+    header.binaryFormat = binaryFormat;
+    header.binarySize = static_cast<uint32_t>(length);
+
+    // Write to a temporary file and rename it so a partial file is never read
+    std::string temporaryPath = path + ".tmp";
+    FILE* file = fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        LOG("Error opening program cache file %s", temporaryPath.c_str());
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(binary.data(), 1, header.binarySize, file) == header.binarySize;
+    written = fclose(file) == 0 && written;
+
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        LOG("Error writing program cache file %s", path.c_str());
+        remove(temporaryPath.c_str());
+    }
+}
+
+
 unsigned int
 GLESUtils::createTexture(const Vuforia::Image* image)
 {
@@ -166,7 +395,7 @@ GLESUtils::createTexture(const Vuforia::Image* image)
 
 
 unsigned int
-GLESUtils::createTexture(int width, int height, unsigned char* data, GLenum format)
+GLESUtils::createTexture(int width, int height, unsigned char* data, GLenum format, Mipmaps mipmaps)
 {
     GLuint gl_TextureID = -1;
 
@@ -179,13 +408,32 @@ GLESUtils::createTexture(int width, int height, unsigned char* data, GLenum form
     glGenTextures(1, &gl_TextureID);
 
     glBindTexture(GL_TEXTURE_2D, gl_TextureID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 
+    GLint levelCount = 1;
+    if (mipmaps == MIPMAPS_CPU && format == GL_RGBA)
+    {
+        std::vector<std::vector<uint8_t>> levels;
+        MipmapGenerator::generate(data, width, height, levels);
+        for (const std::vector<uint8_t>& level : levels)
+        {
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+            glTexImage2D(GL_TEXTURE_2D, levelCount++, format, width, height, 0, format, GL_UNSIGNED_BYTE,
+                         level.data());
+        }
+    }
+    else if (mipmaps != MIPMAPS_NONE)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        levelCount = static_cast<GLint>(MipmapGenerator::getLevelCount(width, height));
+    }
+    setMinificationFilter(levelCount);
+
     glBindTexture(GL_TEXTURE_2D, 0);
 
     GLESUtils::checkGlError("Creating texture from image");
@@ -194,6 +442,93 @@ GLESUtils::createTexture(int width, int height, unsigned char* data, GLenum form
 }
 
 
+unsigned int
+GLESUtils::createTexture(const KtxTexture::View& ktx)
+{
+    GLuint gl_TextureID = -1;
+
+    if (ktx.levels.empty())
+    {
+        LOG("Error: Cannot create a texture without levels");
+        return gl_TextureID;
+    }
+
+    glGenTextures(1, &gl_TextureID);
+
+    glBindTexture(GL_TEXTURE_2D, gl_TextureID);
+    const GLint levelCount = static_cast<GLint>(ktx.levels.size());
+    setMinificationFilter(levelCount);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // The chain may stop before 1x1, don't sample the missing levels
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+    for (GLint i = 0; i < levelCount; ++i)
+    {
+        const KtxTexture::Level& level = ktx.levels[i];
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, ktx.header.glInternalFormat, level.width, level.height, 0,
+                               static_cast<GLsizei>(level.size), level.data);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLESUtils::checkGlError("Creating compressed texture");
+
+    return gl_TextureID;
+}
+
+
+bool
+GLESUtils::isCompressedFormatSupported(GLenum internalFormat)
+{
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+    std::vector<GLint> formats(formatCount);
+    if (formatCount > 0)
+    {
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+    }
+    return std::find(formats.begin(), formats.end(), static_cast<GLint>(internalFormat)) != formats.end();
+}
+
+
+float
+GLESUtils::getMaxTextureAnisotropy()
+{
+    if (sMaxTextureAnisotropy == 0.0f)
+    {
+        sMaxTextureAnisotropy = 1.0f;
+        const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+        if (extensions != nullptr && strstr(extensions, "GL_EXT_texture_filter_anisotropic") != nullptr)
+        {
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &sMaxTextureAnisotropy);
+        }
+        LOG("Maximum texture anisotropy: %.0f", sMaxTextureAnisotropy);
+    }
+    return sMaxTextureAnisotropy;
+}
+
+
+void
+GLESUtils::setMinificationFilter(GLint levelCount)
+{
+    if (levelCount <= 1)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        return;
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    // Models seen at grazing angles otherwise blur along the slope
+    const float anisotropy = std::min(TEXTURE_ANISOTROPY, getMaxTextureAnisotropy());
+    if (anisotropy > 1.0f)
+    {
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+    }
+}
+
+
 bool
 GLESUtils::destroyTexture(unsigned int textureId)
 {
@@ -202,3 +537,56 @@ GLESUtils::destroyTexture(unsigned int textureId)
 
     return true;
 }
+
+
+unsigned int
+GLESUtils::createBuffer(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    GLuint bufferId = 0;
+
+    glGenBuffers(1, &bufferId);
+    glBindBuffer(target, bufferId);
+    uploadBuffer(target, size, data, usage);
+
+    GLESUtils::checkGlError("Creating buffer");
+
+    return bufferId;
+}
+
+
+void
+GLESUtils::uploadBuffer(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    glBufferData(target, size, data, usage);
+
+    sBufferUploadStatistics.uploadCount++;
+    sBufferUploadStatistics.uploadBytes += static_cast<uint64_t>(size);
+}
+
+
+void
+GLESUtils::streamBuffer(GLenum target, GLsizeiptr size, const void* data)
+{
+    glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(target, 0, size, data);
+
+    sBufferUploadStatistics.streamCount++;
+    sBufferUploadStatistics.streamBytes += static_cast<uint64_t>(size);
+}
+
+
+bool
+GLESUtils::destroyBuffer(unsigned int bufferId)
+{
+    glDeleteBuffers(1, &bufferId);
+    GLESUtils::checkGlError("After glDeleteBuffers");
+
+    return true;
+}
+
+
+const GLESUtils::BufferUploadStatistics&
+GLESUtils::getBufferUploadStatistics()
+{
+    return sBufferUploadStatistics;
+}
@@ -9,10 +9,13 @@ countries.
 #define _VUFORIA_GLESUTILS_H_
 
 // Includes:
+#include <KtxTexture.h>
 #include <Log.h>
 #include <Vuforia/Image.h>
 
 #include <GLES3/gl31.h>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 /// A utility class used by the Vuforia Engine samples.
@@ -22,8 +25,44 @@ private:
     /// Enable this flag to debug OpenGL errors
     static const bool DEBUG_GL = false;
 
+    /// Anisotropy of mipmapped textures, limited to what the driver supports
+    static constexpr float TEXTURE_ANISOTROPY = 8.0f;
+
 public:
 
+    /// How createTexture fills the mip levels below level 0
+    enum Mipmaps
+    {
+        /// Level 0 only, sampled with bilinear filtering
+        MIPMAPS_NONE,
+        /// Levels generated by the driver with glGenerateMipmap
+        MIPMAPS_GPU,
+        /// RGBA levels generated with MipmapGenerator and uploaded, other formats use MIPMAPS_GPU
+        MIPMAPS_CPU,
+    };
+
+    /// Buffer uploads performed since the application started
+    struct BufferUploadStatistics
+    {
+        /// Vertex and index data, uploaded with createBuffer and uploadBuffer
+        uint64_t uploadCount = 0;
+        uint64_t uploadBytes = 0;
+        /// Per frame data such as instance matrices, uploaded with streamBuffer
+        uint64_t streamCount = 0;
+        uint64_t streamBytes = 0;
+    };
+
+    /// Programs created since the application started, for the startup timing log
+    struct ProgramCacheStatistics
+    {
+        /// Programs compiled and linked from source
+        uint32_t compiledCount = 0;
+        double compiledMs = 0.0;
+        /// Programs loaded from the program binary cache
+        uint32_t cachedCount = 0;
+        double cachedMs = 0.0;
+    };
+
     /// Prints GL error information.
     static void checkGlError(const char* operation);
 
@@ -32,18 +71,110 @@ public:
         const char* source);
     
     /// Create a shader program.
+    /**
+     * When a program cache directory is set the linked program binary is
+     * loaded from it if present and saved to it after compiling otherwise.
+     */
     static unsigned int createProgramFromBuffer(const char* vertexShaderBuffer,
         const char* fragmentShaderBuffer);
 
+    /// Set the directory program binaries are cached in, e.g. the application's cache directory
+    /**
+     * The cache is disabled while the directory is empty, the default.
+     */
+    static void setProgramCacheDirectory(const std::string& directory);
+
+    /// Counts and times of the programs created with createProgramFromBuffer
+    static const ProgramCacheStatistics& getProgramCacheStatistics();
+
     /// Create a texture from a Vuforia Image
     static unsigned int createTexture(const Vuforia::Image* image);
 
     /// Create a texture from a byte vector
+    /**
+     * With mipmaps the texture is sampled with trilinear filtering, and
+     * anisotropic filtering when GL_EXT_texture_filter_anisotropic is
+     * supported.
+     */
     static unsigned int createTexture(int width, int height,
-        unsigned char* data, GLenum format = GL_RGBA);
+        unsigned char* data, GLenum format = GL_RGBA, Mipmaps mipmaps = MIPMAPS_NONE);
+
+    /// Create a texture from the compressed mip levels of a KTX file
+    /**
+     * The levels are uploaded with glCompressedTexImage2D and sampled as
+     * mipmapped textures from the other overload when the file has a mip
+     * chain. Check the format with isCompressedFormatSupported first.
+     */
+    static unsigned int createTexture(const KtxTexture::View& ktx);
+
+    /// Query whether the GL implementation can sample a compressed texture format
+    /**
+     * ETC2/EAC are core in GLES 3, ASTC needs an extension, e.g.
+     * GL_KHR_texture_compression_astc_ldr.
+     */
+    static bool isCompressedFormatSupported(GLenum internalFormat);
+
+    /// Maximum anisotropy supported by the driver, 1 without GL_EXT_texture_filter_anisotropic
+    static float getMaxTextureAnisotropy();
+
+    /// Set the minification filter of the bound texture for its number of levels
+    /**
+     * Textures with mip levels are sampled with trilinear and anisotropic
+     * filtering, for textures whose levels aren't filled by createTexture.
+     */
+    static void setMinificationFilter(GLint levelCount);
 
     /// Clean up texture
     static bool destroyTexture(unsigned int textureId);
+
+    /// Create a buffer object holding a copy of data
+    /**
+     * The buffer is left bound to target.
+     */
+    static unsigned int createBuffer(GLenum target, GLsizeiptr size,
+        const void* data, GLenum usage = GL_STATIC_DRAW);
+
+    /// Replace the contents of the buffer bound to target
+    static void uploadBuffer(GLenum target, GLsizeiptr size,
+        const void* data, GLenum usage);
+
+    /// Replace the contents of the buffer bound to target with data that changes every frame
+    /**
+     * The previous storage is orphaned so the driver doesn't wait for draws
+     * still using it.
+     */
+    static void streamBuffer(GLenum target, GLsizeiptr size, const void* data);
+
+    /// Clean up buffer
+    static bool destroyBuffer(unsigned int bufferId);
+
+    /// Counters of all uploads made through createBuffer, uploadBuffer and streamBuffer
+    /**
+     * Compare the counters between frames to verify no vertex data is
+     * uploaded while rendering.
+     */
+    static const BufferUploadStatistics& getBufferUploadStatistics();
+
+private:
+    /// Compile and link a program, retrievable requests its binary be kept for the cache
+    static unsigned int compileProgram(const char* vertexShaderBuffer,
+        const char* fragmentShaderBuffer, bool retrievable);
+
+    /// Key of a program in the cache, a hash of its sources and of the driver
+    static uint64_t getProgramCacheKey(const char* vertexShaderBuffer,
+        const char* fragmentShaderBuffer);
+
+    /// Create a program from the cached binary, returns 0 when missing or rejected by the driver
+    static unsigned int loadProgramBinary(const std::string& path, uint64_t key);
+
+    /// Write the binary of a linked program to the cache
+    static void saveProgramBinary(const std::string& path, uint64_t key, unsigned int program);
+
+    static BufferUploadStatistics sBufferUploadStatistics;
+    static ProgramCacheStatistics sProgramCacheStatistics;
+    static std::string sProgramCacheDirectory;
+    /// Queried on first use, 0 until then
+    static float sMaxTextureAnisotropy;
 };
 
 #endif // _VUFORIA_GLESUTILS_H_
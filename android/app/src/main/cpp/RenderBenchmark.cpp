@@ -0,0 +1,74 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "RenderBenchmark.h"
+
+#include "GLESRenderer.h"
+
+#include <Log.h>
+#include <MathUtils.h>
+
+#include <GLES3/gl31.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+void
+RenderBenchmark::begin()
+{
+    mStart = std::chrono::steady_clock::now();
+}
+
+
+void
+RenderBenchmark::replicate(std::vector<AppController::TargetResult>& results) const
+{
+    if (results.empty())
+    {
+        return;
+    }
+
+    const AppController::TargetResult first = results.front();
+    const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(mInstanceCount))));
+    const float spacing = 0.05f;
+
+    results.resize(mInstanceCount);
+    for (int i = 0; i < mInstanceCount; ++i)
+    {
+        Vuforia::Vec3F offset((i % columns - columns / 2) * spacing, (i / columns - columns / 2) * spacing, 0.0f);
+        results[i].modelViewMatrix = MathUtils::Matrix44FTranslate(offset, first.modelViewMatrix);
+
+        // The scaled matrix only differs from the model view matrix in its first three columns
+        results[i].scaledModelViewMatrix = first.scaledModelViewMatrix;
+        std::copy(results[i].modelViewMatrix.data + 12, results[i].modelViewMatrix.data + 16,
+                  results[i].scaledModelViewMatrix.data + 12);
+    }
+}
+
+
+void
+RenderBenchmark::end(GLESRenderer& renderer, bool drawn)
+{
+    if (!drawn)
+    {
+        return;
+    }
+
+    // Include the GPU time of the augmentations
+    glFinish();
+    mMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+    if (++mFrames == FRAME_COUNT)
+    {
+        bool instancing = renderer.isInstancingEnabled();
+        LOG("Benchmark: %d instances, instancing %s, %.3f ms per frame",
+            mInstanceCount, instancing ? "on" : "off", mMs / FRAME_COUNT);
+        renderer.setInstancingEnabled(!instancing);
+        mFrames = 0;
+        mMs = 0.0;
+    }
+}
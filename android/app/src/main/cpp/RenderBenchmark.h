@@ -0,0 +1,55 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_RENDERBENCHMARK_H_
+#define _VUFORIA_RENDERBENCHMARK_H_
+
+#include <AppController.h>
+
+#include <chrono>
+#include <vector>
+
+/// Number of Image Target instances drawn by the render benchmark, 0 builds the app without it
+#ifndef RENDER_BENCHMARK_INSTANCES
+#define RENDER_BENCHMARK_INSTANCES 0
+#endif
+
+class GLESRenderer;
+
+
+/// Debug benchmark of drawing many Image Target augmentations
+/**
+ * Only built into the app when configured with RENDER_BENCHMARK_INSTANCES,
+ * e.g. -DRENDER_BENCHMARK_INSTANCES=256. When an Image Target is tracked
+ * its result is replicated in a grid on the target plane. The submission
+ * and drawing of the augmentations is timed up to glFinish, so the GPU
+ * time is included, and the average is logged and instancing toggled
+ * every FRAME_COUNT frames.
+ */
+class RenderBenchmark
+{
+public:
+    explicit RenderBenchmark(int instanceCount) : mInstanceCount(instanceCount) {}
+
+    /// Start timing the augmentations of a frame
+    void begin();
+    /// Replace the results with the instances, laid out around the first result
+    void replicate(std::vector<AppController::TargetResult>& results) const;
+    /// Stop timing after endFrame, frames without Image Target results aren't counted
+    void end(GLESRenderer& renderer, bool drawn);
+
+private:
+    /// Frames averaged before each log and toggle of instancing
+    static const int FRAME_COUNT = 100;
+
+    int mInstanceCount;
+    int mFrames = 0;
+    double mMs = 0.0;
+    std::chrono::steady_clock::time_point mStart;
+};
+
+#endif // _VUFORIA_RENDERBENCHMARK_H_
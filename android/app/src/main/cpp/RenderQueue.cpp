@@ -0,0 +1,114 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+    // Widths of the sort key fields
+    constexpr int PASS_BITS = 2;
+    constexpr int PROGRAM_BITS = 10;
+    constexpr int TEXTURE_BITS = 14;
+    constexpr int DEPTH_BITS = 32;
+
+    constexpr int PASS_SHIFT = 64 - PASS_BITS;
+
+    constexpr uint64_t PROGRAM_MASK = (uint64_t(1) << PROGRAM_BITS) - 1;
+    constexpr uint64_t TEXTURE_MASK = (uint64_t(1) << TEXTURE_BITS) - 1;
+
+    /// Map a depth to an integer with the same ordering
+    uint32_t depthBits(float depth)
+    {
+        // The bits of a non-negative IEEE float sort in the same order as its value
+        if (!(depth > 0.0f))
+        {
+            return 0;
+        }
+        uint32_t bits;
+        memcpy(&bits, &depth, sizeof(bits));
+        return bits;
+    }
+}
+
+
+void
+RenderQueue::clear()
+{
+    mItems.clear();
+}
+
+
+void
+RenderQueue::submit(const DrawItem& item)
+{
+    float depth = getDepth(item.modelViewMatrix);
+
+    mItems.push_back(item);
+    mItems.back().sortKey = makeSortKey(getPass(item.state), item.program, item.texture, depth);
+}
+
+
+float
+RenderQueue::getDepth(const Vuforia::Matrix44F& modelViewMatrix) const
+{
+    // Last row of the projection times the translation column of the model view
+    const float* p = mProjectionMatrix.data;
+    const float* mv = modelViewMatrix.data;
+    return p[3] * mv[12] + p[7] * mv[13] + p[11] * mv[14] + p[15] * mv[15];
+}
+
+
+void
+RenderQueue::sort()
+{
+    // A stable sort keeps items with equal keys, e.g. overlays, in submission order
+    std::stable_sort(mItems.begin(), mItems.end(),
+                     [](const DrawItem& a, const DrawItem& b) { return a.sortKey < b.sortKey; });
+}
+
+
+RenderQueue::Pass
+RenderQueue::getPass(uint8_t state)
+{
+    if ((state & STATE_DEPTH_TEST) == 0)
+    {
+        return PASS_OVERLAY;
+    }
+    return (state & STATE_BLEND) != 0 ? PASS_BLENDED : PASS_OPAQUE;
+}
+
+
+uint64_t
+RenderQueue::makeSortKey(Pass pass, GLuint program, GLuint texture, float depth)
+{
+    uint64_t key = pass << PASS_SHIFT;
+    uint64_t state = ((program & PROGRAM_MASK) << TEXTURE_BITS) | (texture & TEXTURE_MASK);
+
+    switch (pass)
+    {
+        case PASS_OPAQUE:
+            // Group by state, then front to back to benefit from early depth rejection
+            key |= state << (PASS_SHIFT - PROGRAM_BITS - TEXTURE_BITS);
+            key |= uint64_t(depthBits(depth)) << (PASS_SHIFT - PROGRAM_BITS - TEXTURE_BITS - DEPTH_BITS);
+            break;
+
+        case PASS_BLENDED:
+            // Back to front for correct blending, state only breaks ties
+            key |= uint64_t(~depthBits(depth)) << (PASS_SHIFT - DEPTH_BITS);
+            key |= state << (PASS_SHIFT - DEPTH_BITS - PROGRAM_BITS - TEXTURE_BITS);
+            break;
+
+        case PASS_OVERLAY:
+            break;
+    }
+
+    return key;
+}
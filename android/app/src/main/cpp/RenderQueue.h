@@ -0,0 +1,120 @@
+/*===============================================================================
+Copyright (c) 2020 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_RENDERQUEUE_H_
+#define _VUFORIA_RENDERQUEUE_H_
+
+#include <GLES3/gl31.h>
+
+#include <Vuforia/Matrices.h>
+#include <Vuforia/Vectors.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/// List of draws collected during a frame and issued in sorted order
+/**
+ * Augmentations submit draw items instead of calling GL directly. Before
+ * the items are issued they are sorted by a 64-bit key:
+ *
+ *     opaque:  pass | program | texture | depth (front to back)
+ *     blended: pass | depth (back to front) | program | texture
+ *     overlay: pass (submission order)
+ *
+ * so opaque draws sharing a program and texture are issued together and
+ * translucent draws are composited correctly. Items which don't use the
+ * depth test are overlays and are drawn last in the order submitted.
+ */
+class RenderQueue
+{
+public:
+    /// Render state flags of a draw item
+    enum StateFlags : uint8_t
+    {
+        STATE_DEPTH_TEST    = 1 << 0,
+        STATE_BLEND         = 1 << 1,
+        STATE_CULL_FACE     = 1 << 2,
+    };
+
+    /// Passes in the order they are drawn
+    enum Pass : uint64_t
+    {
+        PASS_OPAQUE = 0,
+        PASS_BLENDED = 1,
+        PASS_OVERLAY = 2,
+    };
+
+    /// A single indexed draw call and the state it needs
+    struct DrawItem
+    {
+        uint64_t sortKey = 0;
+
+        GLuint program = 0;
+        GLuint vertexArray = 0;
+        /// 2D texture bound to unit 0 when the program samples a texture
+        GLuint texture = 0;
+
+        GLenum primitive = GL_TRIANGLES;
+        GLsizei indexCount = 0;
+        GLenum indexType = GL_UNSIGNED_SHORT;
+        /// Byte offset of the first index in the vertex array's index buffer
+        size_t indexOffset = 0;
+
+        /// Combined with the frame's projection matrix on the GPU
+        Vuforia::Matrix44F modelViewMatrix;
+        Vuforia::Vec4F color { 1.0f, 1.0f, 1.0f, 1.0f };
+        float lineWidth = 1.0f;
+        uint8_t state = STATE_DEPTH_TEST;
+
+        /// Number of instances for an instanced draw, 0 for a regular draw
+        /// The per instance data comes from the vertex array.
+        GLsizei instanceCount = 0;
+    };
+
+    /// Remove all items, the storage is kept for the next frame
+    void clear();
+
+    /// Set the projection matrix shared by all the items of the frame
+    /*
+    * Vuforia renders all augmentations of a view with the same projection,
+    * it is uploaded once per frame rather than combined with each item.
+    */
+    void setProjectionMatrix(const Vuforia::Matrix44F& projectionMatrix) { mProjectionMatrix = projectionMatrix; }
+    const Vuforia::Matrix44F& getProjectionMatrix() const { return mProjectionMatrix; }
+
+    /// Add an item, its sort key is computed from its state and transform
+    /*
+    * Set the projection matrix first, it is needed for the item's depth.
+    */
+    void submit(const DrawItem& item);
+
+    /// View space depth of the origin of a model view matrix, the w component of its clip space position
+    float getDepth(const Vuforia::Matrix44F& modelViewMatrix) const;
+
+    /// Sort the items into the order they should be issued
+    void sort();
+
+    const std::vector<DrawItem>& getItems() const { return mItems; }
+
+    /// Pass an item with the given state flags is drawn in
+    static Pass getPass(uint8_t state);
+
+    /// Build the sort key of an item
+    /*
+    * depth is the view space distance of the item, e.g. the w component of
+    * the item's origin in clip space.
+    */
+    static uint64_t makeSortKey(Pass pass, GLuint program, GLuint texture, float depth);
+
+private:
+    std::vector<DrawItem> mItems;
+    Vuforia::Matrix44F mProjectionMatrix {};
+};
+
+#endif // _VUFORIA_RENDERQUEUE_H_
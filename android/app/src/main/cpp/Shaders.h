@@ -8,16 +8,39 @@ countries.
 #ifndef _VUFORIA_SHADERS_H_
 #define _VUFORIA_SHADERS_H_
 
+// All the shaders are GLSL ES 3.00, the version directive must come first
+#define SHADER_VERSION "#version 300 es\n"
+
+// Uniform blocks shared by the augmentation programs, see GLESRenderer::CameraData
+// and GLESRenderer::ObjectData for the matching C++ layout. Members have an explicit
+// precision as a block used by both stages must be declared identically in both.
+
+// Per frame camera data, bound once per frame
+#define CAMERA_DATA_BLOCK                         \
+    "layout(std140) uniform CameraData\n"         \
+    "{\n"                                         \
+    "    highp mat4 projectionMatrix;\n"          \
+    "};\n"
+
+// Per object data, a range of the per frame uniform buffer is bound for each draw
+#define OBJECT_DATA_BLOCK                         \
+    "layout(std140) uniform ObjectData\n"         \
+    "{\n"                                         \
+    "    highp mat4 modelViewMatrix;\n"           \
+    "    mediump vec4 uniformColor;\n"            \
+    "};\n"
+
 /////////////////////////////////////////////////////////////////////////////////////////
-// texture shader: vertexTexCoord in vertex shader, texture2D sample
+// texture shader: vertexTexCoord in vertex shader, texture sample
+// Used for the video background, which has its own projection
 /////////////////////////////////////////////////////////////////////////////////////////
-static const char* textureVertexShaderSrc = R"(
-    attribute vec4 vertexPosition;
-    attribute vec2 vertexTextureCoord;
+static const char* textureVertexShaderSrc = SHADER_VERSION R"(
+    in vec4 vertexPosition;
+    in vec2 vertexTextureCoord;
 
     uniform mat4 modelViewProjectionMatrix;
 
-    varying vec2 texCoord;
+    out vec2 texCoord;
 
     void main()
     {
@@ -27,79 +50,98 @@ static const char* textureVertexShaderSrc = R"(
 )";
 
 
-static const char* textureFragmentShaderSrc = R"(
+static const char* textureFragmentShaderSrc = SHADER_VERSION R"(
     precision mediump float;
 
     uniform sampler2D texSampler2D;
 
-    varying vec2 texCoord;
+    in vec2 texCoord;
+
+    out vec4 fragColor;
 
     void main()
     {
-        gl_FragColor = texture2D(texSampler2D, texCoord);
+        fragColor = texture(texSampler2D, texCoord);
     }
 )";
 
 
 /////////////////////////////////////////////////////////////////////////////////////////
-// texture color shader: vertexTexCoord in vertex shader, uniform color, texture2D sample
+// texture color shader: vertexTexCoord in vertex shader, uniform color, texture sample
 /////////////////////////////////////////////////////////////////////////////////////////
-static const char* textureColorVertexShaderSrc = R"(
-    attribute vec4 vertexPosition;
-    attribute vec2 vertexTextureCoord;
-
-    uniform mat4 modelViewProjectionMatrix;
+static const char* textureColorVertexShaderSrc = SHADER_VERSION CAMERA_DATA_BLOCK OBJECT_DATA_BLOCK R"(
+    in vec4 vertexPosition;
+    in vec2 vertexTextureCoord;
 
-    varying vec2 texCoord;
+    out vec2 texCoord;
 
     void main()
     {
-        gl_Position = modelViewProjectionMatrix * vertexPosition;
+        gl_Position = projectionMatrix * modelViewMatrix * vertexPosition;
         texCoord = vertexTextureCoord;
     }
 )";
 
 
-static const char* textureColorFragmentShaderSrc = R"(
+static const char* textureColorFragmentShaderSrc = SHADER_VERSION OBJECT_DATA_BLOCK R"(
     precision mediump float;
 
     uniform sampler2D texSampler2D;
 
-    varying vec2 texCoord;
+    in vec2 texCoord;
 
-    uniform vec4 uniformColor;
+    out vec4 fragColor;
 
     void main()
     {
-        vec4 texColor = texture2D(texSampler2D, texCoord);
-        gl_FragColor = texColor * uniformColor;
+        vec4 texColor = texture(texSampler2D, texCoord);
+        fragColor = texColor * uniformColor;
     }
 )";
 
 
 /////////////////////////////////////////////////////////////////////////////////////////
-//uniform color shader: uniform color in frag shader
+// instanced texture color shader: per instance matrix attribute, used with the
+// texture color fragment shader
 /////////////////////////////////////////////////////////////////////////////////////////
-static const char *uniformColorVertexShaderSrc = R"(
-    attribute vec4 vertexPosition;
+static const char* textureColorInstancedVertexShaderSrc = SHADER_VERSION CAMERA_DATA_BLOCK R"(
+    in vec4 vertexPosition;
+    in vec2 vertexTextureCoord;
 
-    uniform mat4 modelViewProjectionMatrix;
+    // One matrix per instance, the attribute divisor is 1
+    in mat4 instanceModelViewMatrix;
+
+    out vec2 texCoord;
 
     void main()
     {
-        gl_Position = modelViewProjectionMatrix * vertexPosition;
+        gl_Position = projectionMatrix * instanceModelViewMatrix * vertexPosition;
+        texCoord = vertexTextureCoord;
+    }
+)";
+
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//uniform color shader: uniform color in frag shader
+/////////////////////////////////////////////////////////////////////////////////////////
+static const char *uniformColorVertexShaderSrc = SHADER_VERSION CAMERA_DATA_BLOCK OBJECT_DATA_BLOCK R"(
+    in vec4 vertexPosition;
+
+    void main()
+    {
+        gl_Position = projectionMatrix * modelViewMatrix * vertexPosition;
     }
 )";
 
 
-static const char *uniformColorFragmentShaderSrc = R"(
+static const char *uniformColorFragmentShaderSrc = SHADER_VERSION OBJECT_DATA_BLOCK R"(
     precision mediump float;
 
-    uniform vec4 uniformColor;
+    out vec4 fragColor;
 
     void main()
     {
-        gl_FragColor = uniformColor;
+        fragColor = uniformColor;
     }
 )";
 
@@ -107,30 +149,30 @@ static const char *uniformColorFragmentShaderSrc = R"(
 /////////////////////////////////////////////////////////////////////////////////////////
 // vertex color shader: attribute color in vertex shader
 /////////////////////////////////////////////////////////////////////////////////////////
-static const char *vertexColorVertexShaderSrc = R"(
-    attribute vec4 vertexPosition;
-    attribute vec4 vertexColor;
-
-    uniform mat4 modelViewProjectionMatrix;
+static const char *vertexColorVertexShaderSrc = SHADER_VERSION CAMERA_DATA_BLOCK OBJECT_DATA_BLOCK R"(
+    in vec4 vertexPosition;
+    in vec4 vertexColor;
 
     // Color to use per vertex, linear interpolated down at fragment shader
-    varying vec4 color;
+    out vec4 color;
 
     void main()
     {
-        gl_Position = modelViewProjectionMatrix * vertexPosition;
+        gl_Position = projectionMatrix * modelViewMatrix * vertexPosition;
         color = vertexColor;
     }
 )";
 
-static const char *vertexColorFragmentShaderSrc = R"(
+static const char *vertexColorFragmentShaderSrc = SHADER_VERSION R"(
     precision mediump float;
 
-    varying vec4 color;
+    in vec4 color;
+
+    out vec4 fragColor;
 
     void main()
     {
-        gl_FragColor = color;
+        fragColor = color;
     }
 )";
 
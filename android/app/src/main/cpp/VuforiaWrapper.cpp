@@ -8,8 +8,13 @@ countries.
 #include <jni.h>
 
 #include <AppController.h>
+#include <FrameProfiler.h>
 #include <Log.h>
+#include "AndroidAssetSource.h"
+#include "GLESGpuTimer.h"
 #include "GLESRenderer.h"
+#include "GLESUtils.h"
+#include "RenderBenchmark.h"
 
 #include <Vuforia/Tool.h>
 #include <Vuforia/GLRenderer.h>
@@ -18,6 +23,7 @@ countries.
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 
+#include <memory>
 #include <vector>
 
 
@@ -35,6 +41,14 @@ struct
     jmethodID initDoneMethodID = nullptr;
 
     GLESRenderer renderer;
+    GLESGpuTimer gpuTimer;
+
+    // Storage for the Image Target results, reused every frame
+    std::vector<AppController::TargetResult> imageTargetResults;
+
+#if RENDER_BENCHMARK_INSTANCES > 0
+    RenderBenchmark benchmark { RENDER_BENCHMARK_INSTANCES };
+#endif
 } gWrapperData;
 
 
@@ -98,6 +112,24 @@ Java_in_bugle_deshgujarat_VuforiaActivity_initAR(
         return;
     }
 
+    // Linked shader programs are cached in the application's cache directory
+    jclass activityClass = env->GetObjectClass(activity);
+    jmethodID getCacheDirMethodID = env->GetMethodID(activityClass, "getCacheDir", "()Ljava/io/File;");
+    jobject cacheDir = env->CallObjectMethod(activity, getCacheDirMethodID);
+    if (cacheDir != nullptr)
+    {
+        jclass fileClass = env->GetObjectClass(cacheDir);
+        jmethodID getAbsolutePathMethodID = env->GetMethodID(fileClass, "getAbsolutePath", "()Ljava/lang/String;");
+        auto path = static_cast<jstring>(env->CallObjectMethod(cacheDir, getAbsolutePathMethodID));
+        const char* pathChars = env->GetStringUTFChars(path, nullptr);
+        GLESUtils::setProgramCacheDirectory(pathChars);
+        env->ReleaseStringUTFChars(path, pathChars);
+        env->DeleteLocalRef(path);
+        env->DeleteLocalRef(fileClass);
+        env->DeleteLocalRef(cacheDir);
+    }
+    env->DeleteLocalRef(activityClass);
+
     // Start Vuforia initialization
     controller.initAR(initConfig, target);
 }
@@ -180,10 +212,14 @@ Java_in_bugle_deshgujarat_VuforiaActivity_initRendering(
     // Define clear color
     glClearColor(0.0f, 0.0f, 0.0f, Vuforia::requiresAlpha() ? 0.0f : 1.0f);
 
-    if (!gWrapperData.renderer.init(gWrapperData.assetManager))
+    if (!gWrapperData.renderer.init(std::make_shared<AndroidAssetSource>(gWrapperData.assetManager)))
     {
         LOG("Error initialising rendering");
     }
+    // Only the model of the session's target is drawn, start loading it now
+    gWrapperData.renderer.prefetchModel(controller.getTarget() == AppController::IMAGE_TARGET_ID ?
+                                        GLESRenderer::MODEL_ASTRONAUT : GLESRenderer::MODEL_LANDER);
+    gWrapperData.gpuTimer.init();
 }
 
 
@@ -194,8 +230,9 @@ Java_in_bugle_deshgujarat_VuforiaActivity_setTextures(
     jint astronautWidth, jint astronautHeight, jobject astronautByteBuffer,
     jint landerWidth, jint landerHeight, jobject landerByteBuffer)
 {
-    // Textures are loaded using the BitmapFactory which isn't available from the NDK.
-    // They are loaded in the Kotlin code and passed to this method to create GLES textures.
+    // The renderer decodes the textures from the assets itself, see needsTextures.
+    // Otherwise they are loaded in the Kotlin code with the BitmapFactory and passed to
+    // this method to create GLES textures.
     auto astronautBytes = static_cast<unsigned char*>(env->GetDirectBufferAddress(astronautByteBuffer));
     gWrapperData.renderer.setAstronautTexture(astronautWidth, astronautHeight, astronautBytes);
     auto landerBytes = static_cast<unsigned char*>(env->GetDirectBufferAddress(landerByteBuffer));
@@ -203,12 +240,22 @@ Java_in_bugle_deshgujarat_VuforiaActivity_setTextures(
 }
 
 
+JNIEXPORT jboolean JNICALL
+Java_in_bugle_deshgujarat_VuforiaActivity_needsTextures(
+    JNIEnv *env,
+    jobject /* this */)
+{
+    return gWrapperData.renderer.needsTextures() ? JNI_TRUE : JNI_FALSE;
+}
+
+
 JNIEXPORT void JNICALL
 Java_in_bugle_deshgujarat_VuforiaActivity_deinitRendering(
     JNIEnv *env,
     jobject /* this */)
 {
     gWrapperData.renderer.deinit();
+    gWrapperData.gpuTimer.deinit();
 }
 
 
@@ -233,6 +280,13 @@ Java_in_bugle_deshgujarat_VuforiaActivity_renderFrame(
         return JNI_FALSE;
     }
 
+    PROFILE_SCOPE(STAGE_FRAME);
+    gWrapperData.gpuTimer.collect();
+
+    // Geometry is resident on the GPU, frames should not upload vertex data
+    // except when the video background mesh changes
+    const GLESUtils::BufferUploadStatistics uploadsBefore = GLESUtils::getBufferUploadStatistics();
+
     // Clear colour and depth buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -244,46 +298,113 @@ Java_in_bugle_deshgujarat_VuforiaActivity_renderFrame(
         // Set viewport for current view
         glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
 
-        auto renderingPrimitives = controller.getRenderingPrimitives();
-        Vuforia::Matrix44F vbProjectionMatrix = Vuforia::Tool::convert2GLMatrix(
-            renderingPrimitives->getVideoBackgroundProjectionMatrix(Vuforia::VIEW_SINGULAR));
-        const Vuforia::Mesh& vbMesh = renderingPrimitives->getVideoBackgroundMesh(Vuforia::VIEW_SINGULAR);
-        gWrapperData.renderer.renderVideoBackground(vbProjectionMatrix,
-            vbMesh.getPositionCoordinates(), vbMesh.getUVCoordinates(),
-            vbMesh.getNumTriangles(), vbMesh.getTriangles(),
-            vbTextureUnit.mTextureUnit);
-
-        Vuforia::Matrix44F worldOriginProjection;
-        Vuforia::Matrix44F worldOriginModelView;
-        if (controller.getOrigin(worldOriginProjection, worldOriginModelView))
-        {
-            gWrapperData.renderer.renderWorldOrigin(worldOriginProjection, worldOriginModelView);
-        }
+        gWrapperData.renderer.beginFrame();
 
-        Vuforia::Matrix44F trackableProjection;
-        Vuforia::Matrix44F trackableModelView;
-        Vuforia::Matrix44F trackableModelViewScaled;
-        Vuforia::Image* modelTargetGuideViewImage = nullptr;
-        if (controller.getImageTargetResult(trackableProjection, trackableModelView, trackableModelViewScaled))
         {
-            gWrapperData.renderer.renderImageTarget(trackableProjection, trackableModelView, trackableModelViewScaled);
+            PROFILE_SCOPE(STAGE_VIDEO_BACKGROUND);
+            gWrapperData.gpuTimer.begin(FrameProfiler::STAGE_GPU_VIDEO_BACKGROUND);
+
+            auto renderingPrimitives = controller.getRenderingPrimitives();
+            Vuforia::Matrix44F vbProjectionMatrix = Vuforia::Tool::convert2GLMatrix(
+                renderingPrimitives->getVideoBackgroundProjectionMatrix(Vuforia::VIEW_SINGULAR));
+            const Vuforia::Mesh& vbMesh = renderingPrimitives->getVideoBackgroundMesh(Vuforia::VIEW_SINGULAR);
+            gWrapperData.renderer.renderVideoBackground(vbProjectionMatrix,
+                vbMesh.getPositionCoordinates(), vbMesh.getUVCoordinates(),
+                vbMesh.getNumVertices(), vbMesh.getNumTriangles(), vbMesh.getTriangles(),
+                vbTextureUnit.mTextureUnit);
+
+            gWrapperData.gpuTimer.end();
         }
-        else if (controller.getModelTargetResult(trackableProjection, trackableModelView, trackableModelViewScaled))
-        {
-            gWrapperData.renderer.renderModelTarget(trackableProjection, trackableModelView, trackableModelViewScaled);
-        }
-        else if (controller.getModelTargetGuideView(trackableProjection, trackableModelView, &modelTargetGuideViewImage))
+
+        auto& imageTargetResults = gWrapperData.imageTargetResults;
+
+        // The augmentations stage covers submitting to the render queue and drawing it in endFrame
         {
-            gWrapperData.renderer.renderModelTargetGuideView(trackableProjection, trackableModelView, modelTargetGuideViewImage);
+            PROFILE_SCOPE(STAGE_AUGMENTATIONS);
+            gWrapperData.gpuTimer.begin(FrameProfiler::STAGE_GPU_AUGMENTATIONS);
+
+            Vuforia::Matrix44F worldOriginProjection;
+            Vuforia::Matrix44F worldOriginModelView;
+            if (controller.getOrigin(worldOriginProjection, worldOriginModelView))
+            {
+                gWrapperData.renderer.renderWorldOrigin(worldOriginProjection, worldOriginModelView);
+            }
+
+#if RENDER_BENCHMARK_INSTANCES > 0
+            gWrapperData.benchmark.begin();
+#endif
+
+            Vuforia::Matrix44F trackableProjection;
+            Vuforia::Matrix44F trackableModelView;
+            Vuforia::Matrix44F trackableModelViewScaled;
+            Vuforia::Image* modelTargetGuideViewImage = nullptr;
+            if (controller.getImageTargetResults(trackableProjection, imageTargetResults))
+            {
+#if RENDER_BENCHMARK_INSTANCES > 0
+                gWrapperData.benchmark.replicate(imageTargetResults);
+#endif
+                for (auto& result : imageTargetResults)
+                {
+                    gWrapperData.renderer.renderImageTarget(trackableProjection, result.modelViewMatrix, result.scaledModelViewMatrix);
+                }
+            }
+            else if (controller.getModelTargetResult(trackableProjection, trackableModelView, trackableModelViewScaled))
+            {
+                gWrapperData.renderer.renderModelTarget(trackableProjection, trackableModelView, trackableModelViewScaled);
+            }
+            else if (controller.getModelTargetGuideView(trackableProjection, trackableModelView, &modelTargetGuideViewImage))
+            {
+                gWrapperData.renderer.renderModelTargetGuideView(trackableProjection, trackableModelView, modelTargetGuideViewImage);
+            }
+
+            gWrapperData.renderer.endFrame();
+
+            gWrapperData.gpuTimer.end();
         }
+
+#if RENDER_BENCHMARK_INSTANCES > 0
+        gWrapperData.benchmark.end(gWrapperData.renderer, !imageTargetResults.empty());
+#endif
     }
 
     controller.finishRender(nullptr);
 
+    const GLESUtils::BufferUploadStatistics& uploads = GLESUtils::getBufferUploadStatistics();
+    if (uploads.uploadCount != uploadsBefore.uploadCount)
+    {
+        LOG("Frame uploaded %llu buffers (%llu bytes)",
+            static_cast<unsigned long long>(uploads.uploadCount - uploadsBefore.uploadCount),
+            static_cast<unsigned long long>(uploads.uploadBytes - uploadsBefore.uploadBytes));
+    }
+
     return JNI_TRUE;
 }
 
 
+JNIEXPORT jfloatArray JNICALL
+Java_in_bugle_deshgujarat_VuforiaActivity_getFrameTimings(
+    JNIEnv *env,
+    jobject /* this */)
+{
+    // p50, p95 and p99 in milliseconds for each FrameProfiler stage in order
+    float timings[FrameProfiler::STAGE_COUNT * 3];
+    for (int stage = 0; stage < FrameProfiler::STAGE_COUNT; ++stage)
+    {
+        FrameProfiler::Percentiles percentiles = FrameProfiler::getPercentiles(static_cast<FrameProfiler::Stage>(stage));
+        timings[stage * 3 + 0] = percentiles.p50;
+        timings[stage * 3 + 1] = percentiles.p95;
+        timings[stage * 3 + 2] = percentiles.p99;
+    }
+
+    jfloatArray result = env->NewFloatArray(FrameProfiler::STAGE_COUNT * 3);
+    if (result != nullptr)
+    {
+        env->SetFloatArrayRegion(result, 0, FrameProfiler::STAGE_COUNT * 3, timings);
+    }
+    return result;
+}
+
+
 JNIEXPORT jint JNICALL
 Java_in_bugle_deshgujarat_VuforiaActivity_00024Companion_getImageTargetId(
     JNIEnv *env,
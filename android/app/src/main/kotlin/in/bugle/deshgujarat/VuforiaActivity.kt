@@ -46,6 +46,8 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
 
     private var mVuforiaStarted = false
     private var mSurfaceChanged = false
+    // Textures aren't decoded again every frame after the BitmapFactory failed
+    private var mTextureFallbackFailed = false
 
     private var mGestureDetector : GestureDetectorCompat? = null
 
@@ -65,10 +67,14 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
     external fun initRendering()
     external fun setTextures(astronautWidth: Int, astronautHeight: Int, astronautBytes: ByteBuffer,
                              landerWidth: Int, landerHeight: Int, landerBytes: ByteBuffer)
+    external fun needsTextures() : Boolean
     external fun deinitRendering()
     external fun configureRendering(width : Int, height : Int, orientation : Int) : Boolean
     external fun renderFrame() : Boolean
 
+    // Rolling p50, p95 and p99 in milliseconds for each native FrameProfiler stage in order
+    external fun getFrameTimings() : FloatArray
+
 
     // Activity methods
     override fun onCreate(savedInstanceState: Bundle?) {
@@ -256,6 +262,12 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
 
             // OpenGL rendering of Video Background and augmentations is implemented in native code
             var didRender = renderFrame()
+
+            // A texture the native code failed to decode is loaded here instead, once
+            if (!mTextureFallbackFailed && needsTextures()) {
+                loadTextures()
+            }
+
             if (didRender && mProgressIndicatorLayout?.visibility != View.GONE) {
                 GlobalScope.launch(Dispatchers.Main) {
                     mProgressIndicatorLayout?.visibility = View.GONE
@@ -270,7 +282,20 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
         mWidth = width
         mHeight = height
 
-        // Re-load textures in case they got destroyed
+        // Re-load textures in case they got destroyed, unless the native code
+        // loads them itself when rendering is initialized
+        mTextureFallbackFailed = false
+        if (needsTextures()) {
+            loadTextures()
+        }
+
+        // Update flag to tell us we need to update Vuforia configuration
+        mSurfaceChanged = true
+    }
+
+
+    // Decode the textures with the BitmapFactory for the native code to upload
+    private fun loadTextures() {
         var astronautTexture = Texture.loadTextureFromApk("Astronaut.jpg", assets)
         var landerTexture = Texture.loadTextureFromApk("VikingLander.jpg", assets)
         if (astronautTexture != null && landerTexture != null) {
@@ -280,10 +305,8 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
             )
         } else {
             Log.e("VuforiaSample", "Failed to load astronaut or lander texture");
+            mTextureFallbackFailed = true
         }
-
-        // Update flag to tell us we need to update Vuforia configuration
-        mSurfaceChanged = true
     }
 
 